@@ -0,0 +1,109 @@
+// File: arc-stepper.c
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// Midpoint-circle G2/G3 step generator, see
+// arc-stepper.h
+
+// ==============================================
+// INCLUDE FILE HEADERS
+#include <string.h>
+#include <stdlib.h>
+
+#include "arc-stepper.h"
+
+// ========================================================
+static int64_t arc_cross(const struct arc_stepper *a) {
+// ========================================================
+    // > 0 while the end point lies ahead (less than half a turn)
+    int64_t c = a->x * a->ye - a->y * a->xe;
+    return a->ccw ? c : -c;
+}
+
+// ========================================================
+void arc_begin(struct arc_stepper *a, int64_t x0, int64_t y0, int64_t xe, int64_t ye, int ccw) {
+// ========================================================
+    // Start (x0, y0) and end (xe, ye) relative to the centre.
+    // Start == end is a full circle.
+    memset(a, 0, sizeof(*a));
+    a->x   = x0;
+    a->y   = y0;
+    a->xe  = xe;
+    a->ye  = ye;
+    a->ccw = ccw;
+    a->prev_cross = arc_cross(a);
+    a->max_ticks  = (uint32_t)(8 * (llabs(x0) + llabs(y0)) + 16);
+    if (x0 == 0 && y0 == 0)
+        a->phase = ARC_CORRECT;     // Zero radius: straight to the end
+}
+
+// ========================================================
+int arc_step(struct arc_stepper *a, int step[2]) {
+// ========================================================
+    // Next tick: step[0], step[1] = -1, 0 or +1 for X and Y.
+    // Returns 0 once the end point has been reached.
+    int64_t tx, ty, f1, f2, cross;
+    int sx = 0, sy = 0;
+
+    if (a->phase == ARC_DONE)
+        return 0;
+
+    if (a->phase == ARC_CORRECT) {
+        sx = (a->xe > a->x) - (a->xe < a->x);
+        sy = (a->ye > a->y) - (a->ye < a->y);
+        if (sx == 0 && sy == 0) {
+            a->phase = ARC_DONE;
+            return 0;
+        }
+    } else {
+        // Tangent: (-y, x) counter-clockwise, (y, -x) clockwise
+        tx = a->ccw ? -a->y : a->y;
+        ty = a->ccw ? a->x : -a->x;
+        if (llabs(tx) >= llabs(ty)) {
+            // X is the major axis in this octant
+            sx = tx > 0 ? 1 : -1;
+            sy = ty > 0 ? 1 : ty < 0 ? -1 : (a->y > 0 ? -1 : 1);
+            f1 = a->f + 2 * a->x * sx + 1;
+            f2 = f1 + 2 * a->y * sy + 1;
+            if (llabs(f2) >= llabs(f1))
+                sy = 0;
+        } else {
+            sy = ty > 0 ? 1 : -1;
+            sx = tx > 0 ? 1 : tx < 0 ? -1 : (a->x > 0 ? -1 : 1);
+            f1 = a->f + 2 * a->y * sy + 1;
+            f2 = f1 + 2 * a->x * sx + 1;
+            if (llabs(f2) >= llabs(f1))
+                sx = 0;
+        }
+    }
+
+    if (sx) { a->f += 2 * a->x * sx + 1; a->x += sx; }
+    if (sy) { a->f += 2 * a->y * sy + 1; a->y += sy; }
+    a->ticks++;
+
+    if (a->phase == ARC_SWEEP) {
+        // Swept past the end angle (on the near side of the centre)
+        cross = arc_cross(a);
+        if ((a->prev_cross > 0 && cross <= 0 && a->x * a->xe + a->y * a->ye > 0)
+            || a->ticks >= a->max_ticks)
+            a->phase = ARC_CORRECT;
+        a->prev_cross = cross;
+    }
+    step[0] = sx;
+    step[1] = sy;
+    return 1;
+}
+
+// ========================================================
+uint32_t arc_count_ticks(const struct arc_stepper *a) {
+// ========================================================
+    // Dry run on a copy: ticks the arc will take, so the
+    // speed profile knows where to decelerate
+    struct arc_stepper copy = *a;
+    int step[2];
+
+    while (arc_step(&copy, step))
+        ;
+    return copy.ticks;
+}
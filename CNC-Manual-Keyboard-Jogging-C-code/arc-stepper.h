@@ -0,0 +1,51 @@
+// File: arc-stepper.h
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// Integer circular interpolation for G2/G3 in the
+// XY plane (midpoint-circle stepping). Positions are
+// whole steps relative to the arc centre and
+//
+//   f = x^2 + y^2 - r^2
+//
+// is kept up to date with additions only. Each tick
+// steps the axis that moves fastest along the tangent
+// in the current octant, and also the other axis when
+// that brings |f| closer to zero. The stepped path
+// therefore stays within about half a step of the
+// true circle. No trig, no division, no floating
+// point: one tick costs a few integer multiplies.
+//
+// The arc ends once the position has swept past the
+// end point's angle (cross-product sign change); any
+// step left over from rounding of the end point is
+// taken as a short straight correction.
+
+#ifndef ARC_STEPPER_H
+#define ARC_STEPPER_H
+
+#include <stdint.h>
+
+enum arc_phase {
+    ARC_SWEEP   = 0,    // Stepping along the circle
+    ARC_CORRECT = 1,    // Straight steps onto the exact end point
+    ARC_DONE    = 2
+};
+
+struct arc_stepper {
+    int64_t     x, y;           // Position relative to the centre (steps)
+    int64_t     xe, ye;         // End point relative to the centre (steps)
+    int64_t     f;              // x^2 + y^2 - r^2
+    int64_t     prev_cross;     // Side of the end point at the last tick
+    uint32_t    ticks;
+    uint32_t    max_ticks;      // Safety bound (more than one full turn)
+    int         ccw;            // G3 = 1, G2 = 0
+    enum arc_phase phase;
+};
+
+void     arc_begin(struct arc_stepper *a, int64_t x0, int64_t y0, int64_t xe, int64_t ye, int ccw);
+int      arc_step(struct arc_stepper *a, int step[2]);
+uint32_t arc_count_ticks(const struct arc_stepper *a);
+
+#endif // ARC_STEPPER_H
@@ -0,0 +1,180 @@
+// File: cnc-shm-tool.c
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// Command-line client of the jogger's shared-memory
+// segment (keyboard-jogging-code.cx --shm, see
+// cnc-shm.h). It is also the reference for writing
+// other clients: attach, push commands, wait on
+// cmd_done_seq, read the status under its seqlock.
+//
+//   status          : one status block
+//   watch [MS]      : a status line every MS (default 100)
+//   key K           : key K, exactly as if typed
+//   jog K [MS]      : continuous jog in key K's direction
+//                     for MS (default 1000), then stop
+//   stop            : end a continuous jog
+//   move DX DY DZ [DA] : relative move in steps
+//
+// Commands wait until the jogger has carried them out.
+
+// ==============================================
+// COMPILATION AND EXECUTION INSTRUCTIONS
+// gcc -O2 -o cnc-shm-tool.cx cnc-shm-tool.c cnc-shm.c
+//
+// ./cnc-shm-tool.cx status
+// ./cnc-shm-tool.cx move 500 0 0
+// ./cnc-shm-tool.cx --shm=/cnc-jogging watch 50
+
+// ==============================================
+// INCLUDE FILE HEADERS
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cnc-time.h"
+#include "cnc-shm.h"
+
+#define TOOL_JOG_REPEAT_MS      100     // Re-send a jog like keyboard auto-repeat
+#define TOOL_WAIT_TIMEOUT_S     600     // Give up waiting for a command after this
+
+const char      *shm_name = CNC_SHM_DEFAULT_NAME;
+struct cnc_shm  *shm;
+
+// ========================================================
+static void sleep_ms(int ms) {
+// ========================================================
+    struct timespec ts;
+
+    ts.tv_sec  = ms / 1000;
+    ts.tv_nsec = (long)(ms % 1000) * 1000000L;
+    nanosleep(&ts, NULL);
+}
+
+// ========================================================
+static uint64_t send_cmd(uint32_t type, int a0, int a1, int a2, int a3) {
+// ========================================================
+    // Queue one command, retrying while the ring is full
+    struct cnc_shm_cmd cmd;
+
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type   = type;
+    cmd.arg[0] = a0;
+    cmd.arg[1] = a1;
+    cmd.arg[2] = a2;
+    cmd.arg[3] = a3;
+    while (cnc_shm_cmd_push(shm, &cmd) != 0)
+        sleep_ms(1);
+    return cmd.seq;
+}
+
+// ========================================================
+static int wait_done(uint64_t seq) {
+// ========================================================
+    uint64_t t_end = monotonic_ns() + (uint64_t)TOOL_WAIT_TIMEOUT_S * NSEC_PER_SEC;
+
+    while (atomic_load_explicit(&shm->cmd_done_seq, memory_order_acquire) < seq) {
+        if (monotonic_ns() > t_end) {
+            printf("ERROR  : Command %llu not carried out\n", (unsigned long long)seq);
+            return -1;
+        }
+        sleep_ms(1);
+    }
+    return 0;
+}
+
+// ========================================================
+static void print_status(int one_line) {
+// ========================================================
+    struct cnc_shm_status st;
+    double age_ms;
+
+    cnc_shm_status_read(shm, &st);
+    age_ms = (monotonic_ns() - st.t_ns) / 1e6;
+    if (one_line) {
+        printf("pos %8lld %8lld %8lld %8lld  vel %8.0f %8.0f %8.0f %8.0f  data 0x%02X status 0x%02X  %s%s\n",
+            (long long)st.position[0], (long long)st.position[1], (long long)st.position[2],
+            (long long)st.position[3], st.velocity[0], st.velocity[1], st.velocity[2], st.velocity[3],
+            st.data_byte, st.status_byte,
+            st.jog_active ? "jog " : "", st.fault_axis >= 0 ? "FAULT" : "");
+        return;
+    }
+    printf("position X/Y/Z/A    = %lld / %lld / %lld / %lld (steps, homed %c%c%c%c)\n",
+        (long long)st.position[0], (long long)st.position[1], (long long)st.position[2], (long long)st.position[3],
+        st.homed & 1 ? 'X' : '-', st.homed & 2 ? 'Y' : '-', st.homed & 4 ? 'Z' : '-', st.homed & 8 ? 'A' : '-');
+    printf("velocity X/Y/Z/A    = %.0f / %.0f / %.0f / %.0f (steps/s)\n", st.velocity[0], st.velocity[1],
+        st.velocity[2], st.velocity[3]);
+    if (st.fault_axis >= 0)
+        printf("limit fault         = %c-axis switch\n", "XYZA"[st.fault_axis]);
+    else
+        printf("limit fault         = none\n");
+    printf("DATA_REG/STATUS_REG = 0x%02X / 0x%02X\n", st.data_byte, st.status_byte);
+    printf("jog active/mode     = %u / %s\n", st.jog_active, st.jog_continuous ? "continuous" : "500 pulses");
+    printf("motion queue depth  = %llu\n", (unsigned long long)st.queue_depth);
+    printf("edges/missed        = %llu / %llu\n", (unsigned long long)st.edges, (unsigned long long)st.missed);
+    printf("lateness mean/max   = %.1f / %.1f (us)\n", st.mean_late_ns / 1000.0, st.max_late_ns / 1000.0);
+    printf("status age          = %.1f (ms), jogger pid %lld\n", age_ms, (long long)shm->pid);
+}
+
+// ========================================================
+static void usage(const char *prog) {
+// ========================================================
+    printf("Usage: %s [--shm=/NAME] status | watch [MS] | key K | jog K [MS] | stop | move DX DY DZ [DA]\n", prog);
+    exit(1);
+}
+
+// ==================================================================
+int main(int argc, char *argv[]) {
+// ==================================================================
+    uint64_t seq = 0, t_end;
+    int argi = 1, ms;
+
+    if (argi < argc && strncmp(argv[argi], "--shm=", 6) == 0)
+        shm_name = argv[argi++] + 6;
+    if (argi >= argc)
+        usage(argv[0]);
+
+    if (cnc_shm_attach(&shm, shm_name) != 0) {
+        printf("ERROR  : Attach %s \t= %s\n", shm_name,
+            errno == EPROTO ? "not a jogger segment of this version" : strerror(errno));
+        return 1;
+    }
+
+    if (strcmp(argv[argi], "status") == 0) {
+        print_status(0);
+    } else if (strcmp(argv[argi], "watch") == 0) {
+        ms = argi + 1 < argc ? atoi(argv[argi + 1]) : 100;
+        for (;;) {
+            print_status(1);
+            fflush(stdout);
+            sleep_ms(ms > 0 ? ms : 100);
+        }
+    } else if (strcmp(argv[argi], "key") == 0 && argi + 1 < argc) {
+        seq = send_cmd(CNC_SHM_CMD_KEY, argv[argi + 1][0], 0, 0, 0);
+    } else if (strcmp(argv[argi], "jog") == 0 && argi + 1 < argc) {
+        ms = argi + 2 < argc ? atoi(argv[argi + 2]) : 1000;
+        t_end = monotonic_ns() + (uint64_t)ms * 1000000;
+        while (monotonic_ns() < t_end) {
+            send_cmd(CNC_SHM_CMD_JOG, argv[argi + 1][0], 0, 0, 0);
+            sleep_ms(TOOL_JOG_REPEAT_MS);
+        }
+        seq = send_cmd(CNC_SHM_CMD_STOP, 0, 0, 0, 0);
+    } else if (strcmp(argv[argi], "stop") == 0) {
+        seq = send_cmd(CNC_SHM_CMD_STOP, 0, 0, 0, 0);
+    } else if (strcmp(argv[argi], "move") == 0 && argi + 3 < argc) {
+        seq = send_cmd(CNC_SHM_CMD_MOVE, atoi(argv[argi + 1]), atoi(argv[argi + 2]), atoi(argv[argi + 3]),
+                       argi + 4 < argc ? atoi(argv[argi + 4]) : 0);
+    } else {
+        usage(argv[0]);
+    }
+
+    if (seq != 0 && wait_done(seq) == 0)
+        print_status(1);
+    cnc_shm_detach(shm);
+    return 0;
+}
@@ -0,0 +1,171 @@
+// File: cnc-shm.c
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// Shared-memory command/status segment, see cnc-shm.h
+
+// ==============================================
+// INCLUDE FILE HEADERS
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "cnc-shm.h"
+
+// ========================================================
+int cnc_shm_create(struct cnc_shm **shm, const char *name) {
+// ========================================================
+    // Create (or take over) the segment and lay it out.
+    // Returns 0, or -1 with errno set.
+    struct cnc_shm *s;
+    int fd, err;
+
+    fd = shm_open(name, O_CREAT | O_RDWR, 0660);
+    if (fd < 0)
+        return -1;
+    if (ftruncate(fd, sizeof(struct cnc_shm)) != 0) {
+        err = errno;
+        close(fd);
+        errno = err;
+        return -1;
+    }
+    s = mmap(NULL, sizeof(struct cnc_shm), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    err = errno;
+    close(fd);
+    if (s == MAP_FAILED) {
+        errno = err;
+        return -1;
+    }
+
+    // magic stays 0 until the layout is complete
+    memset(s, 0, sizeof(*s));
+    s->version  = CNC_SHM_VERSION;
+    s->size     = sizeof(struct cnc_shm);
+    s->num_axes = CNC_SHM_AXES;
+    s->pid      = getpid();
+    atomic_init(&s->cmd_head, 0);
+    atomic_init(&s->cmd_tail, 0);
+    atomic_init(&s->cmd_done_seq, 0);
+    atomic_init(&s->status_seq, 0);
+    atomic_store_explicit(&s->magic, CNC_SHM_MAGIC, memory_order_release);
+
+    *shm = s;
+    return 0;
+}
+
+// ========================================================
+void cnc_shm_destroy(struct cnc_shm *shm, const char *name) {
+// ========================================================
+    // Clients still attached keep their mapping; new ones fail
+    atomic_store_explicit(&shm->magic, 0, memory_order_release);
+    munmap(shm, sizeof(*shm));
+    shm_unlink(name);
+}
+
+// ========================================================
+int cnc_shm_cmd_pop(struct cnc_shm *shm, struct cnc_shm_cmd *cmd) {
+// ========================================================
+    // Jogger only. Returns 1 and the oldest command, or 0.
+    uint64_t tail = atomic_load_explicit(&shm->cmd_tail, memory_order_relaxed);
+    uint64_t head = atomic_load_explicit(&shm->cmd_head, memory_order_acquire);
+
+    if (head == tail)
+        return 0;
+    *cmd = shm->cmd[tail & (CNC_SHM_CMD_SLOTS - 1)];
+    atomic_store_explicit(&shm->cmd_tail, tail + 1, memory_order_release);
+    return 1;
+}
+
+// ========================================================
+void cnc_shm_cmd_done(struct cnc_shm *shm, uint64_t seq) {
+// ========================================================
+    atomic_store_explicit(&shm->cmd_done_seq, seq, memory_order_release);
+}
+
+// ========================================================
+void cnc_shm_status_write(struct cnc_shm *shm, const struct cnc_shm_status *status) {
+// ========================================================
+    // One writer (the jogger's keyboard thread)
+    uint64_t seq = atomic_load_explicit(&shm->status_seq, memory_order_relaxed);
+
+    atomic_store_explicit(&shm->status_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    shm->status = *status;
+    atomic_store_explicit(&shm->status_seq, seq + 2, memory_order_release);
+}
+
+// ========================================================
+int cnc_shm_attach(struct cnc_shm **shm, const char *name) {
+// ========================================================
+    // Map an existing segment and check its layout. Returns 0,
+    // or -1 with errno set (EPROTO: other layout or version).
+    struct cnc_shm *s;
+    struct stat sb;
+    int fd, err;
+
+    fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0)
+        return -1;
+    if (fstat(fd, &sb) != 0 || sb.st_size < (off_t)sizeof(struct cnc_shm)) {
+        close(fd);
+        errno = EPROTO;
+        return -1;
+    }
+    s = mmap(NULL, sizeof(struct cnc_shm), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    err = errno;
+    close(fd);
+    if (s == MAP_FAILED) {
+        errno = err;
+        return -1;
+    }
+    if (atomic_load_explicit(&s->magic, memory_order_acquire) != CNC_SHM_MAGIC
+        || s->version != CNC_SHM_VERSION || s->size != sizeof(struct cnc_shm)
+        || s->num_axes != CNC_SHM_AXES) {
+        munmap(s, sizeof(*s));
+        errno = EPROTO;
+        return -1;
+    }
+    *shm = s;
+    return 0;
+}
+
+// ========================================================
+void cnc_shm_detach(struct cnc_shm *shm) {
+// ========================================================
+    munmap(shm, sizeof(*shm));
+}
+
+// ========================================================
+int cnc_shm_cmd_push(struct cnc_shm *shm, struct cnc_shm_cmd *cmd) {
+// ========================================================
+    // One client writer. Returns 0, or -1 if the ring is full.
+    uint64_t head = atomic_load_explicit(&shm->cmd_head, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&shm->cmd_tail, memory_order_acquire);
+
+    if (head - tail >= CNC_SHM_CMD_SLOTS)
+        return -1;
+    cmd->seq = head + 1;
+    shm->cmd[head & (CNC_SHM_CMD_SLOTS - 1)] = *cmd;
+    atomic_store_explicit(&shm->cmd_head, head + 1, memory_order_release);
+    return 0;
+}
+
+// ========================================================
+void cnc_shm_status_read(struct cnc_shm *shm, struct cnc_shm_status *status) {
+// ========================================================
+    uint64_t seq;
+
+    for (;;) {
+        seq = atomic_load_explicit(&shm->status_seq, memory_order_acquire);
+        if (seq & 1)
+            continue;                   // Being written
+        *status = shm->status;
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&shm->status_seq, memory_order_relaxed) == seq)
+            return;
+    }
+}
@@ -0,0 +1,108 @@
+// File: cnc-shm.h
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// POSIX shared-memory command/status interface of
+// the jogging code, in the spirit of LinuxCNC HAL
+// pins: another process on the same host maps the
+// segment (shm_open + mmap) and exchanges data with
+// the jogger without copies or syscalls.
+//
+//   command ring : SPSC ring of fixed-size commands,
+//                  one external writer process, the
+//                  jogger's keyboard thread reads it
+//                  (so motion_q keeps its one producer)
+//   status       : one status block, rewritten about
+//                  every CNC_SHM_STATUS_NS under a
+//                  seqlock: seq is odd while it is
+//                  written; a reader copies it and
+//                  copies again if seq was odd or moved
+//
+// The layout is versioned: a client must check magic,
+// version and size (cnc_shm_attach() does) before it
+// touches anything else. magic is written last when
+// the segment is created.
+//
+// Everything in the segment is fixed-size and 64-bit
+// aligned so 32- and 64-bit clients agree on it.
+
+#ifndef CNC_SHM_H
+#define CNC_SHM_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+#define CNC_SHM_DEFAULT_NAME    "/cnc-jogging"
+#define CNC_SHM_MAGIC           0x434E434AU     // "CNCJ"
+#define CNC_SHM_VERSION         2
+#define CNC_SHM_AXES            4               // X, Y, Z, A
+#define CNC_SHM_CMD_SLOTS       64              // Command ring (power of 2)
+#define CNC_SHM_STATUS_NS       10000000        // Status rewritten every 10 ms
+
+enum cnc_shm_cmd_type {
+    CNC_SHM_CMD_KEY  = 1,       // arg[0] = key, exactly as if typed
+    CNC_SHM_CMD_JOG  = 2,       // arg[0] = direction key; continuous jog, repeat it like auto-repeat
+    CNC_SHM_CMD_STOP = 3,       // End a continuous jog
+    CNC_SHM_CMD_MOVE = 4        // Relative move of arg[0..3] steps on X, Y, Z, A (soft limits apply)
+};
+
+struct cnc_shm_cmd {
+    uint32_t    type;           // enum cnc_shm_cmd_type
+    int32_t     arg[CNC_SHM_AXES];
+    uint64_t    seq;            // Set by cnc_shm_cmd_push()
+};
+
+struct cnc_shm_status {
+    uint64_t    t_ns;                       // CLOCK_MONOTONIC of this update
+    int64_t     position[CNC_SHM_AXES];     // Steps from home
+    double      velocity[CNC_SHM_AXES];     // steps/s since the previous update
+    uint32_t    homed;                      // Bit per axis
+    int32_t     fault_axis;                 // Limit switch hit, -1 = none
+    uint32_t    data_byte;                  // Last DATA_REG byte written
+    uint32_t    status_byte;                // Last STATUS_REG byte read
+    uint32_t    jog_active;                 // A continuous jog is running
+    uint32_t    jog_continuous;             // Keys jog continuously (key 'c')
+    uint64_t    queue_depth;                // Commands waiting on motion_q
+    uint64_t    edges;                      // Step edges timed so far
+    uint64_t    missed;                     // ... that missed their deadline
+    int64_t     max_late_ns;                // Worst edge lateness
+    double      mean_late_ns;
+};
+
+struct cnc_shm {
+    // Layout header, fixed for every version
+    _Atomic uint32_t magic;                 // CNC_SHM_MAGIC once laid out
+    uint32_t    version;
+    uint32_t    size;                       // sizeof(struct cnc_shm)
+    uint32_t    num_axes;
+    int64_t     pid;                        // Jogger process
+
+    // Command ring: external writer -> jogger
+    _Alignas(64) atomic_uint_fast64_t cmd_head;     // Next slot to write (client)
+    _Alignas(64) atomic_uint_fast64_t cmd_tail;     // Next slot to read (jogger)
+    atomic_uint_fast64_t cmd_done_seq;              // Last command carried out
+    _Alignas(64) struct cnc_shm_cmd cmd[CNC_SHM_CMD_SLOTS];
+
+    // Status: jogger -> any number of readers
+    _Alignas(64) atomic_uint_fast64_t status_seq;
+    struct cnc_shm_status status;
+};
+
+// ==================================================================
+// FUNCTION PROTOTYPES
+// ==================================================================
+// Jogger side
+int     cnc_shm_create(struct cnc_shm **shm, const char *name);
+void    cnc_shm_destroy(struct cnc_shm *shm, const char *name);
+int     cnc_shm_cmd_pop(struct cnc_shm *shm, struct cnc_shm_cmd *cmd);
+void    cnc_shm_cmd_done(struct cnc_shm *shm, uint64_t seq);
+void    cnc_shm_status_write(struct cnc_shm *shm, const struct cnc_shm_status *status);
+
+// Client side
+int     cnc_shm_attach(struct cnc_shm **shm, const char *name);
+void    cnc_shm_detach(struct cnc_shm *shm);
+int     cnc_shm_cmd_push(struct cnc_shm *shm, struct cnc_shm_cmd *cmd);
+void    cnc_shm_status_read(struct cnc_shm *shm, struct cnc_shm_status *status);
+
+#endif // CNC_SHM_H
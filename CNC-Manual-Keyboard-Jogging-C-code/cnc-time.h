@@ -0,0 +1,33 @@
+// File: cnc-time.h
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// CLOCK_MONOTONIC helpers shared by the jogging
+// code. All timing inside the control path uses
+// raw nanosecond counts from here, never the
+// wall-clock time printed by DTStamp().
+
+#ifndef CNC_TIME_H
+#define CNC_TIME_H
+
+#include <stdint.h>
+#include <time.h>
+
+#define NSEC_PER_SEC    1000000000L
+
+// Current CLOCK_MONOTONIC time in nanoseconds
+static inline uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * NSEC_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
+// CPU time used by the calling thread in nanoseconds
+static inline uint64_t thread_cpu_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * NSEC_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
+#endif // CNC_TIME_H
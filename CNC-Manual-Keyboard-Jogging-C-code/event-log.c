@@ -0,0 +1,141 @@
+// File: event-log.c
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// Lock-free binary event ring and its text drain
+// thread, see event-log.h
+
+// ==============================================
+// INCLUDE FILE HEADERS
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include "cnc-time.h"
+#include "event-log.h"
+
+// ========================================================
+void event_log_write(struct event_log *log, uint32_t id,
+                     int64_t a0, int64_t a1, int64_t a2, int64_t a3) {
+// ========================================================
+    // Any thread. Never blocks: drops the record if the ring is full.
+    uint64_t pos = atomic_load_explicit(&log->head, memory_order_relaxed);
+    struct event_rec *r;
+
+    for (;;) {
+        r = &log->rec[pos & (EVENT_LOG_SIZE - 1)];
+        uint64_t seq = atomic_load_explicit(&r->seq, memory_order_acquire);
+        if (seq == pos) {
+            // Slot free for this lap: try to claim it
+            if (atomic_compare_exchange_weak_explicit(&log->head, &pos, pos + 1,
+                    memory_order_relaxed, memory_order_relaxed))
+                break;
+        } else if (seq < pos) {
+            // Slot still holds last lap's record: ring full
+            atomic_fetch_add_explicit(&log->dropped, 1, memory_order_relaxed);
+            return;
+        } else {
+            pos = atomic_load_explicit(&log->head, memory_order_relaxed);
+        }
+    }
+
+    r->t_ns   = monotonic_ns();
+    r->id     = id;
+    r->arg[0] = a0;
+    r->arg[1] = a1;
+    r->arg[2] = a2;
+    r->arg[3] = a3;
+    atomic_store_explicit(&r->seq, pos + 1, memory_order_release);
+}
+
+// ========================================================
+void event_log_stamp(const struct event_log *log, uint64_t t_ns, FILE *fp) {
+// ========================================================
+    // Same text as DTStamp(), but for the time the event happened
+    int64_t wall_ns = (int64_t)t_ns + log->realtime_offset_ns;
+    time_t secs = (time_t)(wall_ns / NSEC_PER_SEC);
+    struct tm tm_info;
+    char buffer[26];
+
+    localtime_r(&secs, &tm_info);
+    strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &tm_info);
+    fprintf(fp, "%s.%09ld \t", buffer, (long)(wall_ns % NSEC_PER_SEC));
+}
+
+// ==================================================================
+static int event_log_drain(struct event_log *log) {
+// ==================================================================
+    // Format every ready record. Returns the number drained.
+    uint64_t pos = atomic_load_explicit(&log->tail, memory_order_relaxed);
+    struct event_rec *r;
+    int n = 0;
+
+    for (;;) {
+        r = &log->rec[pos & (EVENT_LOG_SIZE - 1)];
+        if (atomic_load_explicit(&r->seq, memory_order_acquire) != pos + 1)
+            break;
+        log->format(r, log->fp);
+        // Hand the slot back to producers for the next lap
+        atomic_store_explicit(&r->seq, pos + EVENT_LOG_SIZE, memory_order_release);
+        pos++;
+        n++;
+    }
+    atomic_store_explicit(&log->tail, pos, memory_order_release);
+    if (n > 0)
+        fflush(log->fp);
+    return n;
+}
+
+// ==================================================================
+static void *event_log_thread(void *data) {
+// ==================================================================
+    struct event_log *log = data;
+
+    // Lowest priority: text output may wait, pulses may not
+    setpriority(PRIO_PROCESS, 0, 19);
+    while (atomic_load_explicit(&log->running, memory_order_acquire)) {
+        if (event_log_drain(log) == 0)
+            usleep(EVENT_LOG_POLL_US);
+    }
+    event_log_drain(log);
+    return NULL;
+}
+
+// ========================================================
+int event_log_start(struct event_log *log, event_format_fn format, FILE *fp) {
+// ========================================================
+    struct timespec rt, mono;
+    uint64_t i;
+
+    atomic_init(&log->head, 0);
+    atomic_init(&log->tail, 0);
+    atomic_init(&log->dropped, 0);
+    for (i = 0; i < EVENT_LOG_SIZE; i++)
+        atomic_init(&log->rec[i].seq, i);
+
+    clock_gettime(CLOCK_REALTIME, &rt);
+    clock_gettime(CLOCK_MONOTONIC, &mono);
+    log->realtime_offset_ns = ((int64_t)rt.tv_sec - mono.tv_sec) * NSEC_PER_SEC
+                            + (rt.tv_nsec - mono.tv_nsec);
+    log->format = format;
+    log->fp     = fp;
+    atomic_init(&log->running, 1);
+    return pthread_create(&log->tid, NULL, event_log_thread, log);
+}
+
+// ========================================================
+void event_log_flush(struct event_log *log) {
+// ========================================================
+    // Wait until every record written so far has been printed
+    uint64_t head = atomic_load_explicit(&log->head, memory_order_acquire);
+    while (atomic_load_explicit(&log->tail, memory_order_acquire) < head)
+        usleep(1000);
+}
+
+// ========================================================
+void event_log_stop(struct event_log *log) {
+// ========================================================
+    atomic_store_explicit(&log->running, 0, memory_order_release);
+    pthread_join(log->tid, NULL);
+}
@@ -0,0 +1,61 @@
+// File: event-log.h
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// Asynchronous binary event log. Producers (the
+// keyboard thread and the stepping thread) append
+// fixed-size records holding a raw CLOCK_MONOTONIC
+// timestamp, an event id and four integer arguments
+// into a preallocated ring. A low-priority drain
+// thread turns them into text off the control path,
+// so a slow terminal never delays a pulse.
+//
+// The ring is a bounded multi-producer/single-
+// consumer queue (per-slot sequence numbers): a
+// producer claims a slot with one atomic add and
+// never blocks. When the ring is full the record is
+// dropped and counted instead.
+
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#define EVENT_LOG_SIZE      4096    // Records (power of 2)
+#define EVENT_LOG_POLL_US   5000    // Drain thread sleep when idle
+
+struct event_rec {
+    atomic_uint_fast64_t seq;       // Slot sequence (ready when == claim + 1)
+    uint64_t    t_ns;               // CLOCK_MONOTONIC time of the event
+    uint32_t    id;                 // Application event id
+    uint32_t    pad;
+    int64_t     arg[4];
+};
+
+// Formats one record (timestamp already printed); runs on the drain thread
+typedef void (*event_format_fn)(const struct event_rec *rec, FILE *fp);
+
+struct event_log {
+    _Alignas(64) atomic_uint_fast64_t head;     // Next slot to claim (producers)
+    atomic_uint_fast64_t dropped;
+    _Alignas(64) atomic_uint_fast64_t tail;     // Next slot to drain (consumer)
+    int64_t     realtime_offset_ns;             // CLOCK_REALTIME - CLOCK_MONOTONIC
+    event_format_fn format;
+    FILE        *fp;
+    pthread_t   tid;
+    atomic_int  running;
+    struct event_rec rec[EVENT_LOG_SIZE];
+};
+
+int     event_log_start(struct event_log *log, event_format_fn format, FILE *fp);
+void    event_log_flush(struct event_log *log);
+void    event_log_stop(struct event_log *log);
+void    event_log_write(struct event_log *log, uint32_t id,
+                        int64_t a0, int64_t a1, int64_t a2, int64_t a3);
+void    event_log_stamp(const struct event_log *log, uint64_t t_ns, FILE *fp);
+
+#endif // EVENT_LOG_H
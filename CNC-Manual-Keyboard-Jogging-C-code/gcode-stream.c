@@ -0,0 +1,221 @@
+// File: gcode-stream.c
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// Zero-copy G-code tokenizer over an mmap()ed
+// file, see gcode-stream.h
+
+// ==============================================
+// INCLUDE FILE HEADERS
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "cnc-time.h"
+#include "gcode-stream.h"
+
+#define MM_PER_INCH     25.4
+
+// ========================================================
+int gcode_open(struct gcode_reader *r, const char *path) {
+// ========================================================
+    struct stat st;
+
+    memset(r, 0, sizeof(*r));
+    r->absolute = 1;
+    r->fd = open(path, O_RDONLY);
+    if (r->fd < 0)
+        return -1;
+    if (fstat(r->fd, &st) != 0) {
+        close(r->fd);
+        return -1;
+    }
+    r->size = (size_t)st.st_size;
+    if (r->size > 0) {
+        r->data = mmap(NULL, r->size, PROT_READ, MAP_PRIVATE, r->fd, 0);
+        if (r->data == MAP_FAILED) {
+            close(r->fd);
+            return -1;
+        }
+        // Read ahead in order; gcode_next_move() releases
+        // the pages behind us
+        madvise((void *)r->data, r->size, MADV_SEQUENTIAL);
+    }
+    return 0;
+}
+
+// ========================================================
+void gcode_close(struct gcode_reader *r) {
+// ========================================================
+    if (r->size > 0)
+        munmap((void *)r->data, r->size);
+    if (r->fd >= 0)
+        close(r->fd);
+    r->fd = -1;
+}
+
+// ==================================================================
+static int parse_number(const char *p, const char *end, const char **next, double *value) {
+// ==================================================================
+    // [+-]digits[.digits] without needing a terminating NUL
+    double v = 0.0, scale = 1.0;
+    int neg = 0, digits = 0;
+
+    while (p < end && (*p == ' ' || *p == '\t'))
+        p++;
+    if (p < end && (*p == '+' || *p == '-'))
+        neg = (*p++ == '-');
+    while (p < end && *p >= '0' && *p <= '9') {
+        v = v * 10.0 + (*p++ - '0');
+        digits++;
+    }
+    if (p < end && *p == '.') {
+        p++;
+        while (p < end && *p >= '0' && *p <= '9') {
+            scale *= 0.1;
+            v += (*p++ - '0') * scale;
+            digits++;
+        }
+    }
+    *next  = p;
+    *value = neg ? -v : v;
+    return digits > 0 ? 0 : -1;
+}
+
+// ==================================================================
+static int parse_line(struct gcode_reader *r, const char *p, const char *end,
+                      struct gcode_move *move) {
+// ==================================================================
+    // Apply one line to the modal state. Returns 1 if it moves.
+    double value, word[GCODE_AXES], offset[2] = { 0.0, 0.0 };
+    int have[GCODE_AXES] = { 0, 0, 0, 0 }, have_ij = 0;
+    int axis, moves = 0, g;
+    char letter;
+
+    while (p < end) {
+        letter = *p++;
+        if (letter >= 'a' && letter <= 'z')
+            letter -= 'a' - 'A';
+
+        if (letter == ' ' || letter == '\t' || letter == '\r')
+            continue;
+        if (letter == ';')
+            break;
+        if (letter == '(') {
+            while (p < end && *p != ')')
+                p++;
+            if (p < end)
+                p++;
+            continue;
+        }
+        if (letter < 'A' || letter > 'Z' || parse_number(p, end, &p, &value) != 0) {
+            r->errors++;
+            break;
+        }
+
+        switch (letter) {
+        case 'G':
+            g = (int)(value * 10.0 + 0.5);      // G-numbers in tenths
+            if      (g == 0)   { r->motion = 0; moves = 1; }
+            else if (g == 10)  { r->motion = 1; moves = 1; }
+            else if (g == 20)  { r->motion = 2; moves = 1; }
+            else if (g == 30)  { r->motion = 3; moves = 1; }
+            else if (g == 170) ;                // XY plane, the only one
+            else if (g == 900) r->absolute = 1;
+            else if (g == 910) r->absolute = 0;
+            else if (g == 200) r->inches = 1;
+            else if (g == 210) r->inches = 0;
+            else r->unsupported++;
+            break;
+        case 'X': case 'Y': case 'Z':
+            axis = letter - 'X';
+            word[axis] = value * (r->inches ? MM_PER_INCH : 1.0);
+            have[axis] = 1;
+            moves = 1;
+            break;
+        case 'A':
+            word[GCODE_AXIS_A] = value;               // Degrees whatever the units
+            have[GCODE_AXIS_A] = 1;
+            moves = 1;
+            break;
+        case 'I': case 'J':
+            offset[letter - 'I'] = value * (r->inches ? MM_PER_INCH : 1.0);
+            have_ij = 1;
+            break;
+        case 'F':
+            r->feed_mm_min = value * (r->inches ? MM_PER_INCH : 1.0);
+            break;
+        case 'N':
+            break;
+        default:
+            r->unsupported++;
+            break;
+        }
+    }
+
+    // A full circle may give only I/J
+    if (!moves || !(have[0] || have[1] || have[2] || have[GCODE_AXIS_A] || (have_ij && r->motion >= 2)))
+        return 0;
+
+    for (axis = 0; axis < GCODE_AXES; axis++) {
+        move->start_mm[axis] = r->pos_mm[axis];
+        if (have[axis])
+            r->pos_mm[axis] = r->absolute ? word[axis] : r->pos_mm[axis] + word[axis];
+        move->target_mm[axis] = r->pos_mm[axis];
+    }
+    move->rapid       = (r->motion == 0);
+    move->arc         = r->motion >= 2 ? r->motion : 0;
+    move->center_mm[0] = move->start_mm[0] + offset[0];
+    move->center_mm[1] = move->start_mm[1] + offset[1];
+    move->feed_mm_min = r->feed_mm_min;
+    move->line        = r->lines_read;
+    return 1;
+}
+
+// ========================================================
+static void gcode_drop_behind(struct gcode_reader *r) {
+// ========================================================
+    // MADV_SEQUENTIAL only speeds up read-ahead; the pages
+    // already tokenized stay mapped until munmap(). Drop
+    // them (whole pages, GCODE_DROP_BYTES at a time) so a
+    // long program runs in a fixed amount of memory. No
+    // move refers to the text once parsed.
+    long page = sysconf(_SC_PAGESIZE);
+    size_t len;
+
+    if (r->pos - r->dropped < GCODE_DROP_BYTES)
+        return;
+    if (page <= 0)
+        page = 4096;
+    len = (r->pos - r->dropped) / (size_t)page * (size_t)page;
+    madvise((void *)(r->data + r->dropped), len, MADV_DONTNEED);
+    r->dropped += len;
+}
+
+// ========================================================
+int gcode_next_move(struct gcode_reader *r, struct gcode_move *move) {
+// ========================================================
+    // Tokenize forward until the next motion line.
+    // Returns 1 with *move filled, or 0 at end of file.
+    uint64_t t0 = monotonic_ns();
+    const char *line, *eol;
+    int found = 0;
+
+    while (!found && r->pos < r->size) {
+        line = r->data + r->pos;
+        eol  = memchr(line, '\n', r->size - r->pos);
+        if (eol == NULL)
+            eol = r->data + r->size;
+        r->pos = (size_t)(eol - r->data) + 1;
+        r->lines_read++;
+        found = parse_line(r, line, eol, move);
+    }
+    if (found)
+        r->moves++;
+    gcode_drop_behind(r);
+    r->parse_ns += monotonic_ns() - t0;
+    return found;
+}
@@ -0,0 +1,74 @@
+// File: gcode-stream.h
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// Streaming G-code front end. The program file is
+// mmap()ed and tokenized in place (no copies, no
+// line buffers), one move at a time, so a toolpath
+// of any size starts at once and uses a fixed
+// amount of memory. Supported words:
+//
+//   G0 G1      rapid / linear move
+//   G2 G3      clockwise / counter-clockwise arc in
+//              the XY plane (G17), centre given by I J
+//              relative to the start point; with a Z
+//              word, a helix
+//   G90 G91    absolute / incremental coordinates
+//   G20 G21    inches / millimetres
+//   X Y Z F    coordinates and feed (units/min)
+//   A          rotary axis (degrees, also under G20)
+//   I J        arc centre offsets
+//   N          line numbers (ignored)
+//   ; ( )      comments
+//
+// Other G and M words are counted and skipped.
+
+#ifndef GCODE_STREAM_H
+#define GCODE_STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define GCODE_AXES      4       // X, Y, Z (mm), A (degrees)
+#define GCODE_AXIS_A    3       // Index of A in the arrays below
+#define GCODE_DROP_BYTES (1 << 20)  // Unmap tokenized text in chunks this size
+
+struct gcode_move {
+    int         rapid;                      // 1 = G0, 0 = G1, G2, G3
+    int         arc;                        // 2 = G2, 3 = G3, 0 = straight
+    double      start_mm[GCODE_AXES];       // Absolute start (mm)
+    double      center_mm[2];               // Absolute arc centre X, Y (mm)
+    double      target_mm[GCODE_AXES];      // Absolute target (mm)
+    double      feed_mm_min;                // G1 feed (mm/min)
+    uint64_t    line;                       // Source line number
+};
+
+struct gcode_reader {
+    // Mapped program
+    const char  *data;
+    size_t      size;
+    size_t      pos;
+    size_t      dropped;                    // Pages before this are released
+    int         fd;
+
+    // Modal state
+    int         absolute;                   // G90 (1) / G91 (0)
+    int         inches;                     // G20 (1) / G21 (0)
+    int         motion;                     // Last G0, G1, G2 or G3 (0..3)
+    double      feed_mm_min;
+    double      pos_mm[GCODE_AXES];
+
+    // Counters
+    uint64_t    lines_read;
+    uint64_t    moves;
+    uint64_t    unsupported;                // Skipped G/M words
+    uint64_t    errors;                     // Malformed words
+    uint64_t    parse_ns;                   // Time spent tokenizing
+};
+
+int     gcode_open(struct gcode_reader *r, const char *path);
+void    gcode_close(struct gcode_reader *r);
+int     gcode_next_move(struct gcode_reader *r, struct gcode_move *move);
+
+#endif // GCODE_STREAM_H
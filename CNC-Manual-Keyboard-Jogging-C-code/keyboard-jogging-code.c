@@ -21,10 +21,42 @@
 
 // ============================================== 
 // COMPILATION AND EXECUTION INSTRUCTIONS
-// gcc -o keyboard-jogging-code.cx keyboard-jogging-code.c
+// gcc -o keyboard-jogging-code.cx keyboard-jogging-code.c parport-backend.c step-engine.c rt-thread.c motion-profile.c motion-queue.c pulse-compiler.c latency-hist.c event-log.c gcode-stream.c motion-planner.c arc-stepper.c pin-map.c two-rate.c tsc-clock.c cnc-shm.c pulse-trace.c machine-config.c -lpthread -lm
+//
+// sudo ./keyboard-jogging-code.cx                  (direct outb, as before)
+// sudo ./keyboard-jogging-code.cx --rt-priority=90 --cpumap=0x8
+// sudo ./keyboard-jogging-code.cx --max-rate=4000 --accel=20000 --jerk=400000
+//      (limits in steps/s, steps/s^2, steps/s^3; one value, X,Y,Z or X,Y,Z,A)
+// sudo ./keyboard-jogging-code.cx --hold-timeout=750   (continuous jog, see key 'c')
+//      ./keyboard-jogging-code.cx --backend=sim --input-latency=1000   (poll wake-up test)
+// sudo ./keyboard-jogging-code.cx --hist-file=latency.txt   (edge lateness histogram, see key 't')
+// sudo ./keyboard-jogging-code.cx --gcode=part.ngc --steps-per-mm=200   (run a G-code file, then jog)
+// sudo ./keyboard-jogging-code.cx --gcode=part.ngc --lookahead=16 --junction-deviation=0.02
+//      (--lookahead=0 stops at every segment, for comparing job times)
+//      ./keyboard-jogging-code.cx --backend=sim --arc-bench=10000   (G2/G3 per-tick cost)
+// sudo ./keyboard-jogging-code.cx --pin-map=pins.conf   (custom step/dir wiring, see pin-map.h)
+// sudo ./keyboard-jogging-code.cx --extra-port=0x278:slave.conf   (second port written in the same tick)
+//      ./keyboard-jogging-code.cx --backend=ppdev --extra-port=/dev/parport1:slave.conf
+// sudo ./keyboard-jogging-code.cx --fifo=1000   (compiled moves through the port FIFO, ns per byte)
+//      ./keyboard-jogging-code.cx --backend=sim --fifo-bench=20000 --fifo-depth=16   (timed edges vs FIFO)
+// sudo ./keyboard-jogging-code.cx --timing=hybrid --max-rate=20000 --cpumap=0x8   (sleep, then spin to each edge)
+// sudo ./keyboard-jogging-code.cx --timing-bench=10000   (CPU and edge jitter, sleep vs hybrid)
+// sudo ./keyboard-jogging-code.cx --shm   (command/status segment /cnc-jogging, see cnc-shm-tool.c)
+// sudo ./keyboard-jogging-code.cx --capture=job.trace --gcode=part.ngc   (record every DATA_REG write)
+//      ./keyboard-jogging-code.cx --backend=sim --replay=job.trace --replay-scale=2 --capture=again.trace
+// sudo ./keyboard-jogging-code.cx --two-rate --base-period=50000   (continuous jog on base/servo threads, see two-rate.h)
+// sudo ./keyboard-jogging-code.cx --soft-min=-20000,-20000,0 --soft-max=20000,20000,8000   (steps from home, see key 'h')
+//      ./keyboard-jogging-code.cx --backend=sim --sim-home=1500   (simulated home switches, for testing key 'h')
+// sudo ./keyboard-jogging-code.cx --calibrate=600 --cpumap=0x8   (10 min latency test, writes cnc-machine.conf)
+// sudo ./keyboard-jogging-code.cx --machine-config=bench.conf   (measured PERIOD, TICK_TIME, max rates)
+//      ./keyboard-jogging-code.cx --backend=sim --gcode=part.ngc --gcode-dry-run   (parse speed only)
+// sudo ./keyboard-jogging-code.cx --backend=ppdev  (/dev/parport0 ioctl)
+// sudo ./keyboard-jogging-code.cx --backend=devport   (/dev/port pwrite, see port-access-bench.c)
+//      ./keyboard-jogging-code.cx --backend=sim    (simulated port, no root)
 
 // ==============================================
 // INCLUDE FILE HEADERS
+#define _GNU_SOURCE     // RUSAGE_THREAD
 #include <stdio.h>
 #include <stdlib.h>     // Use for exit(0)
 #include <time.h>	    // For local date-time with usec
@@ -46,6 +78,55 @@
 #include <termios.h>
 #include <term.h>
 #include <curses.h>
+#include <poll.h>
+#include <sys/resource.h>   // getrusage() for the idle CPU report
+
+// PARALLEL PORT OUTPUT BACKENDS (outb, ppdev, devport, sim)
+#include "cnc-time.h"
+#include "parport-backend.h"
+
+// ABSOLUTE-DEADLINE STEP TIMING (PERIOD per edge)
+#include "step-engine.h"
+
+// TRAPEZOIDAL / S-CURVE ACCELERATION RAMPS
+#include "motion-profile.h"
+
+// REAL-TIME STEPPING THREAD (SCHED_FIFO, mlockall, CPUMAP affinity)
+#include <pthread.h>
+#include "rt-thread.h"
+
+// LOCK-FREE SPSC COMMAND QUEUE (keyboard thread -> stepping thread)
+#include "motion-queue.h"
+
+// AXIS TO PIN MAP (step/dir pins and polarity, loaded from a config file)
+#include "pin-map.h"
+
+// PULSE-TRAIN COMPILER ((byte, delta) buffers streamed by the stepping thread)
+#include "pulse-compiler.h"
+
+// STEP-EDGE LATENESS HISTOGRAM (latency-test equivalent)
+#include "latency-hist.h"
+
+// ASYNCHRONOUS BINARY EVENT LOG (text formatted off the control path)
+#include "event-log.h"
+
+// STREAMING G-CODE FRONT END (mmap, zero-copy tokenizer)
+#include "gcode-stream.h"
+
+// LOOK-AHEAD PLANNER (junction-velocity blending of G-code segments)
+#include "motion-planner.h"
+
+// TWO-RATE BASE/SERVO THREADS FOR THE CONTINUOUS JOG
+#include "two-rate.h"
+
+// SHARED-MEMORY COMMAND/STATUS SEGMENT FOR OTHER PROCESSES
+#include "cnc-shm.h"
+
+// BINARY TRACE OF EVERY DATA_REG WRITE (capture and replay)
+#include "pulse-trace.h"
+
+// HOST LATENCY CALIBRATION AND THE MACHINE CONFIG FILE
+#include "machine-config.h"
 
 // ==================================================================
 // PARALLEL PORT HARDWARE INFORMATION
@@ -66,8 +147,8 @@
 #define PARPORT_ADDRESS  0x378		
 #define PARPORT_IRQ      5
 
-#define PERIOD		500000		// nanoseconds
-#define TICK_TIME	1000000		// nanoseconds
+#define PERIOD		500000		// nanoseconds, default of period_ns
+#define TICK_TIME	1000000		// nanoseconds, default of tick_time_ns
 // #define CPUMAP 	0xF  		// 16-cpus
 #define CPUMAP		0x8         // 8-cpus   (HPNotebook ) 
 // #define CPUMAP	0x4         // 4-cpus   (Blue-Workstation)
@@ -79,6 +160,358 @@ int  io_prio_lvl;   // I/O priority level
 int  io_perm;		// I/O permissions
 int  parport_fd;	// File descriptors
 
+// Output backend used for every DATA_REG write
+enum parport_backend_kind port_kind = PARPORT_BACKEND_OUTB;
+struct parport_backend    port;
+
+// Step/dir wiring of each axis; every edge goes through pin_map.lut
+struct pin_map            pin_map;
+const char               *pin_map_file;
+
+void    load_pin_map(void);
+
+// ==================================================================
+// MEASURED HOST LIMITS (--calibrate[=SECONDS], --machine-config=FILE)
+// ==================================================================
+// PERIOD, TICK_TIME and PROFILE_MAX_RATE are only the defaults.
+// At startup the machine config file (cnc-machine.conf unless
+// --machine-config names another) replaces them with what
+// --calibrate measured on this host, see machine-config.h.
+// --calibrate runs the latency test with the stepping thread's
+// priority and CPUMAP, writes the file and exits. The file's
+// max-rate is a ceiling that --max-rate can only lower, and no
+// start rate (nor the homing approach, which runs at it) may
+// be above its axis's max rate; build_profiles() applies both.
+long                      period_ns    = PERIOD;        // Time per edge
+long                      tick_time_ns = TICK_TIME;     // Servo tick
+const char               *machine_config_file = MACHINE_CONFIG_FILE;
+int                       machine_config_named;         // --machine-config given
+int                       machine_config_loaded;
+uint32_t                  machine_max_rate[NUM_AXES];   // From the file, 0 = none
+int                       max_rate_given;               // --max-rate on the command line
+double                    calibrate_s;                  // 0 = drive the machine
+
+void    load_machine_config(void);
+void    run_calibration(double seconds);
+
+// ==================================================================
+// EXTRA PORTS (--extra-port=ADDR[:PINMAP])
+// ==================================================================
+// More ports of the same backend kind, written back-to-back with
+// the first one on every edge (see parport-backend.h). ADDR is the
+// port address for outb/devport, or the device file for ppdev.
+// Without PINMAP the port repeats the first port's wiring; with it
+// the port can carry e.g. only the slave motor of a gantry axis.
+// Extra ports mirror or split the first port's axes (X/Y/Z and
+// the rotary A), they add none of their own, see pin-map.h.
+struct extra_port {
+    const char             *spec;
+    int                     address;        // outb, devport
+    const char             *device;         // ppdev
+    const char             *pin_map_file;   // NULL = first port's wiring
+    struct pin_map          map;
+    unsigned char           xlat[256];      // First port's byte -> this port's
+    struct parport_backend  port;
+};
+
+struct extra_port         extra_port[PARPORT_MAX_FOLLOWERS];
+int                       extra_ports;
+
+int     parse_extra_port(const char *spec);
+void    open_extra_ports(void);
+void    report_port_skew(void);
+void    build_cmd_descriptions(void);
+
+// ==================================================================
+// POSITION, LIMIT SWITCHES AND HOMING
+// ==================================================================
+// step_state counts every step the stepping thread writes and checks
+// the home switches on every step edge (see step-engine.h). Key 'h'
+// homes Z first (up, clear of the work), then X and Y, then A if
+// it has a switch (by default it has none).
+//
+// A tripped switch sets step_state.fault: the stepping thread stops
+// the move and drops every queued move until the keyboard thread has
+// reported the trip and cleared it. Moves away from the switch are
+// allowed again at once.
+//
+// Soft limits (--soft-min/--soft-max, steps from home; before homing,
+// steps from the start point) clip keyboard moves, brake continuous
+// jogs and reject G-code moves that would cross them.
+//
+// The sim backend has no switches unless --sim-home[=STEPS] is given;
+// then every switch closes STEPS below the start point.
+#define HOME_MAX_STEPS      200000  // Give up a homing phase after this
+#define HOME_SLOW_DIVISOR   10      // Back-off rate = start rate / 10
+#define SIM_HOME_DISTANCE   1500    // --sim-home without =STEPS
+
+struct step_state         step_state;
+int64_t                   soft_min[NUM_AXES] = { INT64_MIN, INT64_MIN, INT64_MIN, INT64_MIN };
+int64_t                   soft_max[NUM_AXES] = { INT64_MAX, INT64_MAX, INT64_MAX, INT64_MAX };
+int                       home_result[NUM_AXES];    // HOME_* of the last homing
+int32_t                   sim_home_steps;           // --sim-home=STEPS, 0 = no simulated switches
+
+void    init_step_state(void);
+void    home_all_axes(void);
+int     limit_fault_service(void);
+void    clip_to_soft_limits(int32_t delta[NUM_AXES]);
+int     gcode_move_outside_limits(const struct gcode_move *move, const int64_t base[NUM_AXES]);
+unsigned char sim_home_switches(void *arg);
+int     parse_axis_steps(const char *text, int64_t values[NUM_AXES]);
+
+// Every edge is timed against this timeline (one PERIOD per edge)
+struct step_timeline      step_tl;
+uint64_t                  missed_at_cmd;    // step_tl.missed when the command started
+
+// Lateness of every step edge, dumped by key 't', on exit and to --hist-file
+struct latency_hist       edge_hist;
+const char               *hist_file;
+
+void    report_latency(void);
+
+// ==================================================================
+// EDGE WAITING: SLEEP OR SLEEP-THEN-SPIN (--timing=sleep|hybrid)
+// ==================================================================
+// The hybrid mode sleeps until an adaptive margin before each
+// edge and spins the rest of the way on the TSC, see step-engine.h.
+// It is meant for an isolated core: the spinning is CPU the core
+// cannot give to anything else. Only step_tl spins; the idle and
+// servo ticks always sleep. --timing-bench=RATE plays the same
+// constant-rate move in both modes and compares them.
+#define TIMING_BENCH_STEPS  20000
+
+int                       timing_mode = STEP_WAIT_SLEEP;
+int64_t                   spin_margin_ns = HYBRID_MARGIN_NS;
+uint32_t                  timing_bench_rate;    // steps/s, 0 = skip
+struct tsc_clock          tsc_clock;
+
+void    init_edge_timing(void);
+void    run_timing_benchmark(uint32_t rate);
+
+// ==================================================================
+// CONTROL-PATH EVENT LOG
+// ==================================================================
+// Command lines are no longer printed by the keyboard thread right
+// before a move starts. It only appends a binary record; the drain
+// thread prints the same text as before.
+enum jog_event_id {
+    EV_CMD_BEGIN = 1,       // arg0 = key
+    EV_CMD_DONE,            // arg0 = missed deadlines
+    EV_JOG_MODE,            // arg0 = 1 continuous, 0 fixed
+    EV_JOG_BEGIN,           // arg0 = key, arg1 = hold (1) or latched (0)
+    EV_JOG_DONE,            // arg0 = steps, arg1 = stop-to-decel ns, arg2 = stop-to-last-pulse ns (-1 = n/a), arg3 = missed
+    EV_TIMING,              // 't' pressed
+    EV_INVALID,             // arg0 = key
+    EV_QUIT,                // 'q' pressed
+    EV_HOME_BEGIN,          // arg0 = axis
+    EV_HOME_DONE,           // arg0 = axis, arg1 = HOME_*, arg2 = raw step count of position 0, arg3 = missed
+    EV_LIMIT_TRIP,          // arg0 = axis, arg1 = position
+    EV_SOFT_LIMIT,          // arg0 = axis, arg1 = requested steps, arg2 = allowed steps
+    EV_SHM_MOVE             // arg0..3 = X, Y, Z, A steps
+};
+
+struct event_log          event_log;
+
+void    format_event(const struct event_rec *rec, FILE *fp);
+const char *cmd_description(int key);
+
+// Per-axis speed limits and their precomputed ramp tables
+struct axis_limits        axis_limits[NUM_AXES];
+struct ramp_table         axis_ramp[NUM_AXES];
+
+void    build_profiles(void);
+const struct ramp_table *select_ramp(const int32_t delta[NUM_AXES]);
+int     parse_axis_values(const char *text, uint32_t values[NUM_AXES]);
+
+// ==================================================================
+// STEPPING THREAD
+// ==================================================================
+// All port output runs on one SCHED_FIFO thread pinned by CPUMAP.
+// The keyboard side pushes fixed-size commands into motion_q; the
+// stepping thread pops them between moves and otherwise idles on
+// its own PERIOD timeline. Neither side ever takes a lock.
+struct rt_thread          step_rt;
+int                       rt_priority = RT_DEFAULT_PRIORITY;
+unsigned long             rt_cpumap   = CPUMAP;
+
+struct motion_queue       motion_q;
+struct pulse_pool         pulse_pool;       // Compiled moves waiting to be played
+struct step_timeline      idle_tl;          // Idle ticks, kept out of step_tl stats
+
+void    start_realtime(void);
+void   *step_thread_main(void *unused);
+void    execute_motion_cmd(const struct motion_cmd *cmd);
+void    motion_submit(uint32_t type, int dx, int dy, int dz, int da);
+void    motion_submit_move(int dx, int dy, int dz, int da);
+void    motion_submit_path(const int32_t delta[NUM_AXES], uint32_t min_interval_ns, uint32_t reset_edges);
+void    motion_submit_block(const struct plan_block *block, int continues);
+void    motion_submit_compiled(struct pulse_compiler *pc, int starts_move);
+int64_t motion_submit_arc(const struct gcode_move *move, int64_t pos_steps[NUM_AXES]);
+void    motion_wait_idle(void);
+void    report_motion_queue(void);
+
+// ==================================================================
+// FIFO (BURST) OUTPUT (--fifo)
+// ==================================================================
+// With --fifo[=BYTE_NS] compiled moves (keyboard moves, G-code) are
+// played through the port FIFO instead of one timed write per edge,
+// see parport-backend.h. Continuous jogs and homing react to every
+// single step and stay on the timed path. --fifo-bench=RATE plays a
+// constant-rate move both ways and compares CPU and timing. Both are
+// refused while a switch is on BUSY (pin 11), and on hardware the
+// byte time is the one measured when the FIFO mode is switched on.
+// A FIFO that stops draining puts every later move back on the
+// timed path.
+#define FIFO_BENCH_STEPS    20000
+
+int                       fifo_mode;            // PULSES go through the FIFO
+uint32_t                  fifo_byte_ns = PARPORT_FIFO_BYTE_NS;
+uint32_t                  fifo_depth   = PARPORT_FIFO_DEPTH;    // Simulated port only
+uint32_t                  fifo_bench_rate;      // steps/s, 0 = skip
+struct fifo_stream        fifo_stream;
+
+// Stepping thread CPU time spent playing PULSES: [0] timed edges, [1] FIFO
+uint64_t                  play_cpu_ns[2];
+uint64_t                  play_edges[2];
+
+void    init_fifo_output(void);
+void    run_fifo_benchmark(uint32_t rate);
+void    report_fifo(void);
+
+// ==================================================================
+// TWO-RATE BASE/SERVO SCHEDULING (--two-rate)
+// ==================================================================
+// With --two-rate a continuous jog is split in two: the stepping
+// thread becomes the base thread, waking every base_period_ns
+// (period_ns unless --base-period is given) only to sample the
+// switches and write step/dir bits, while a servo thread every
+// tick_time_ns runs the ramp, the soft limits and the stop request,
+// see two-rate.h. The servo thread runs one priority below the
+// stepping thread on the same CPUMAP. Compiled moves and homing
+// stay on the pulse-buffer path.
+int                       two_rate_mode;
+long                      base_period_ns;       // 0 = period_ns
+struct two_rate           two_rate;
+
+void    start_servo_thread(void);
+void    report_two_rate(void);
+
+// ==================================================================
+// G-CODE PROGRAM (--gcode=FILE)
+// ==================================================================
+// The file is parsed one move at a time and each move is compiled
+// straight into the pulse pool. Parsing therefore runs only as far
+// ahead as the pool and motion_q allow, whatever the file size.
+// G-code Z+ is up, which is the CCW (direction bit clear) side of
+// the Z axis, hence the sign flip.
+//
+// With lookahead > 0 the segments go through the look-ahead planner
+// and flow into each other; lookahead = 0 runs every segment like a
+// keyboard move (from rest, to rest, then reset_CNC()).
+//
+// G2/G3 arcs are stepped by the integer arc stepper (arc-stepper.h)
+// from rest to rest; a Z word makes a helix, Z stepped by the DDA
+// along the arc. Arcs need the same steps/mm on X and Y, and A
+// cannot turn during one.
+//
+// The A word is in degrees, and steps_per_mm[AXIS_A] is steps per
+// degree. Positive A is CW (direction bit set).
+#define STEPS_PER_MM        100
+#define STEPS_PER_DEG       10
+
+uint32_t                  steps_per_mm[NUM_AXES] = { STEPS_PER_MM, STEPS_PER_MM, STEPS_PER_MM, STEPS_PER_DEG };
+const int                 gcode_axis_sign[NUM_AXES] = { +1, +1, -1, +1 };
+const char               *gcode_file;
+int                       gcode_dry_run;        // Parse only, no motion
+uint32_t                  lookahead = PLANNER_LOOKAHEAD;
+double                    junction_dev = PLANNER_JUNCTION_DEV;
+struct planner            planner;
+
+int                       arc_bench_radius;     // --arc-bench=R, 0 = skip
+
+void    run_gcode_program(const char *path, int dry_run);
+void    run_arc_benchmark(int radius);
+
+// ==================================================================
+// PULSE TRACE CAPTURE AND REPLAY (--capture=FILE, --replay=FILE)
+// ==================================================================
+// --capture records every DATA_REG write of the first port into a
+// trace file (see pulse-trace.h), with a marker at each compiled
+// move, jog, homing and reset. --replay plays a trace back through
+// the selected backend after the startup reset; --replay-scale=F
+// stretches its timing by F (2 = half speed). The trace is compiled
+// into pulse buffers like a G-code program, so the stepping thread
+// counts the steps and checks the switches as usual, and the bytes
+// are translated from the trace's pin map to ours. Gaps longer than
+// REPLAY_MAX_GAP_NS are split by writing the same byte again.
+#define REPLAY_MAX_GAP_NS   1000000000u
+
+const char               *capture_file;
+const char               *replay_file;
+double                    replay_scale = 1.0;
+struct pulse_trace        capture;
+int                       capture_on;
+
+void    init_capture(void);
+void    close_capture(void);
+void    run_replay(const char *path);
+
+// Marker in the capture, from the stepping thread
+static inline void capture_mark(int type, int32_t a0, int32_t a1, int32_t a2, int32_t a3) {
+    if (capture_on)
+        pulse_trace_mark(&capture, type, a0, a1, a2, a3);
+}
+
+// ==================================================================
+// CONTINUOUS (HOLD-TO-MOVE) JOG
+// ==================================================================
+// In continuous mode (key 'c') a direction key starts a jog that
+// runs on the stepping thread while the UI keeps reading keys.
+// Keyboard auto-repeat keeps it alive; when no repeat arrives
+// within hold_timeout_ms (or the space bar is pressed) the jog
+// decelerates and stops. A repeat that still arrives while it
+// decelerates picks the jog up again. hold_timeout_ms = 0
+// latches the jog until the space bar is pressed.
+#define HOLD_TIMEOUT_MS     750     // Over the first auto-repeat delay (X11 660 ms, console 250 ms)
+
+struct jog_control        jog;
+int                       jog_continuous;       // 1 = continuous mode, 0 = 500-pulse mode
+int                       jog_active;           // A jog command is running
+int                       jog_stop_sent;        // jog.release_ns already set for it
+int                       jog_key;              // Key that started it
+uint64_t                  jog_last_key_ns;      // Last press/auto-repeat of jog_key
+int                       hold_timeout_ms = HOLD_TIMEOUT_MS;
+
+int     jog_key_direction(int key, int dir[NUM_AXES]);
+void    jog_press(int key);
+void    jog_request_stop(void);
+void    jog_stop_and_wait(void);
+void    jog_service(void);
+
+// ==================================================================
+// SHARED-MEMORY COMMAND/STATUS INTERFACE (--shm[=NAME])
+// ==================================================================
+// With --shm a POSIX shared-memory segment (cnc-shm.h) lets other
+// processes on this host command the jogger and read its position,
+// velocity, port bytes and edge timing. The keyboard thread serves
+// it: commands are carried out between keys just like keystrokes,
+// and the status block is rewritten every CNC_SHM_STATUS_NS, also
+// while a move is being waited for. The stepping thread does no
+// extra work; it already keeps positions and port shadows in
+// atomics.
+const char               *shm_name;             // NULL = no segment
+struct cnc_shm           *shm;
+uint64_t                  shm_status_ns;        // Last status update
+uint64_t                  shm_vel_ns;           // Start of the current velocity window
+int64_t                   shm_vel_pos[NUM_AXES];    // Positions at shm_vel_ns
+double                    shm_vel[NUM_AXES];
+uint64_t                  shm_cmds;             // Commands carried out
+
+void    init_shm(void);
+void    close_shm(void);
+void    shm_publish_status(int force);
+void    shm_poll_commands(void);
+
 void check_io_priority_level(void); 
 void check_io_permission(void);
 void open_parallel_port(void);
@@ -93,7 +526,7 @@ void close_parallel_port(void);
 time_t 		    WRYtimer;
 char 		    WRYbuffer[26];
 struct tm* 		WRYtm_info;
-struct timeval  WRYtval_now;
+struct timespec WRYts_now;
 
 void DTStamp(void);
 
@@ -117,12 +550,22 @@ void    drive_cnc_machine(void);
 void    init_keyboard();
 void    close_keyboard();
 int     keyboard_hit();
+int     keyboard_wait(int timeout_ms);
 int     read_charkey();
+int     keyboard_timeout_ms(void);
+void    measure_input_latency(int samples);
+void    report_input_cpu(void);
+
+int     input_latency_samples;      // --input-latency=N, 0 = skip the test
+uint64_t input_start_ns;            // When the keyboard loop started
+struct rusage input_start_ru;       // Keyboard thread CPU at that time
  
 // FUNCTION PROTOTYPES DECLARATION
 void    reset_CNC(void);
 void    cmd_interpreter(int);
 void    run_menu(void);
+void    report_done(void);
+void    report_step_timing(void);
 
 
 // DRIVE CNC ALONG X-AXIS
@@ -137,21 +580,32 @@ void    drive_backward(int valdrive);     // DRIVE (4,0, CCW)
 
 // DRIVE CNC ALONG Z-AXIS
 // ==================================================================
-void    drive_up(int valdrive);          // DRIVE (16,0  CW)
-void    drive_down(int valdrive);        // DRIVE (48,32 CCW)
+void    drive_up(int valdrive);          // DRIVE (16,0  CCW)
+void    drive_down(int valdrive);        // DRIVE (48,32 CW)
+
+// TURN CNC ROTARY A-AXIS
+// ==================================================================
+void    drive_cw(int valdrive);          // DRIVE (192,128 CW)
+void    drive_ccw(int valdrive);         // DRIVE (64,0 CCW)
+
+// DRIVE CNC ALONG X, Y, Z AND A TOGETHER (DDA)
+// ==================================================================
+void    drive_axes(int dx, int dy, int dz, int da);
+void    drive_diagonal(int valdrive);     // DRIVE (63,42 CW,CW,CW)
 
 
 // ==================================================================
 void DTStamp(void) {  // High resolution timer Date-Time stamp
 // ==================================================================
 
-    time(&WRYtimer);
+    // One clock read for both the seconds and the nanoseconds
+    clock_gettime(CLOCK_REALTIME, &WRYts_now);
+    WRYtimer   = WRYts_now.tv_sec;
     WRYtm_info = localtime(&WRYtimer);
     strftime(WRYbuffer, 26, "%Y-%m-%d %H:%M:%S", WRYtm_info);
-    gettimeofday(&WRYtval_now, NULL);
 
     printf("%s", WRYbuffer);
-    printf(".%09ld \t", (long int)WRYtval_now.tv_usec);
+    printf(".%09ld \t", (long int)WRYts_now.tv_nsec);
 }
 
 // ========================================================
@@ -181,21 +635,32 @@ void open_parallel_port(void) {
 	DTStamp(); 
 	printf("EXECUTING  open_parallel_port(void).\n");
 
-	if(parport_fd < 0) {
-		DTStamp(); printf("ERROR: Cannot open PARPORT_DEVICE (/dev/lp0).\n");
-		perror(PARPORT_DEVICE);
+	if (port_kind == PARPORT_BACKEND_OUTB) {
+		if(parport_fd < 0) {
+			DTStamp(); printf("ERROR: Cannot open PARPORT_DEVICE (/dev/lp0).\n");
+			perror(PARPORT_DEVICE);
+			exit(1);
+		} else {
+			DTStamp(); printf("SUCCESS: Open PARPORT_DEVICE (/dev/lp0).\n");
+			DTStamp(); printf("SUCCESS: Display file descriptor parport_fd \t= %d \n", parport_fd);
+		}
+	}
+
+	if (parport_backend_open(&port, port_kind, DATA_REG) != 0) {
+		DTStamp(); printf("ERROR: Cannot open output backend (%s).\n", port.name);
+		perror(port.name);
 		exit(1);
-	} else {
-		DTStamp(); printf("SUCCESS: Open PARPORT_DEVICE (/dev/lp0).\n");
-		DTStamp(); printf("SUCCESS: Display file descriptor parport_fd \t= %d \n", parport_fd);
 	}
+	DTStamp(); printf("SUCCESS: Display output backend \t= %s\n", port.name);
 
 	// Display details of PARALLEL_PORT 
 	DTStamp(); printf("SUCCESS: Display PARPORT_IRQ = %d\n", PARPORT_IRQ);
     DTStamp(); printf("SUCCESS: Display BASE_ADDRESS \t= 0x%02X\n", BASE_ADDRESS);
     DTStamp(); printf("SUCCESS: Display CPUMAP \t= 0x%02X\n", CPUMAP);
-	DTStamp(); printf("SUCCESS: Display PERIOD \t= %d (ns)\n", PERIOD);
-    DTStamp(); printf("SUCCESS: Display TICK_TIME \t= %d (ns)\n", TICK_TIME);
+	DTStamp(); printf("SUCCESS: Display PERIOD \t= %ld (ns, %s)\n", period_ns,
+        machine_config_loaded ? machine_config_file : "compile-time default");
+    DTStamp(); printf("SUCCESS: Display TICK_TIME \t= %ld (ns, %s)\n", tick_time_ns,
+        machine_config_loaded ? machine_config_file : "compile-time default");
 
     DTStamp(); printf("COMPLETED open_parallel_port(void).\n");
 }
@@ -206,7 +671,24 @@ void close_parallel_port(void) {
     printf("\n");
     DTStamp(); printf("EXECUTING close_parallel_port(void).\n");
 
-	int close_parport = close(parport_fd);
+	// Report the simulated write log before it is freed
+	if (port_kind == PARPORT_BACKEND_SIM) {
+		struct parport_sim_stats st;
+		parport_sim_get_stats(&port, &st);
+		DTStamp(); printf("SUCCESS: Display simulated writes \t= %llu\n", (unsigned long long)st.writes);
+		DTStamp(); printf("SUCCESS: Display write gap min/mean/max \t= %llu / %.0f / %llu (ns)\n",
+			(unsigned long long)st.min_gap_ns, st.mean_gap_ns, (unsigned long long)st.max_gap_ns);
+		for (int k = 0; k < extra_ports; k++) {
+			DTStamp(); printf("SUCCESS: Display port %d simulated writes \t= %llu\n", k + 2,
+				(unsigned long long)parport_sim_count(&extra_port[k].port));
+		}
+	}
+	for (int k = 0; k < extra_ports; k++)
+		parport_backend_close(&extra_port[k].port);
+	parport_backend_close(&port);
+
+	// /dev/lp0 is only held by the outb backend
+	int close_parport = (port_kind == PARPORT_BACKEND_OUTB) ? close(parport_fd) : 0;
 	if (close_parport != 0) {
 		DTStamp(); printf("ERROR: Cannot close PARALLEL_PORT (/dev/lp0).\n");
 		DTStamp(); printf("ERROR: Display close_parport value \t= %d\n", close_parport);
@@ -223,10 +705,11 @@ DTStamp(); printf("COMPLETED close_parallel_port(void).\n");
 // ================================================
 void reset_CNC(){
 // ================================================
+    step_timeline_start(&step_tl);
     for (count=0; count < 10; count++)
     { 
-        outb(0, DATA_REG);     // Send 00000000 to parallel port DATA_REG
-        usleep(500);
+        parport_write(&port, pin_map_byte(&pin_map, 0));   // All step/dir signals idle
+        step_timeline_wait(&step_tl);
     }
 }
 
@@ -241,99 +724,401 @@ Forward  f = 01100110 = 102
 Backward b = 01100010 = 98
 Up       u = 01110101 = 117
 Down     d = 01100100 = 100 
+A CW     a = 01100001 = 97
+A CCW    s = 01110011 = 115
+Diagonal x = 01111000 = 120
+Continuous c = 01100011 = 99
+Timing   t = 01110100 = 116
+Home     h = 01101000 = 104
 Quit     q = 01110001 = 113
 */
 
+// CONTINUOUS MODE: direction keys start/extend a jog, space stops it
+if (jog_continuous) {
+    int dir[NUM_AXES];
+    if (jog_key_direction(pressed_key, dir)) {
+        jog_press(pressed_key);
+        return;
+    }
+    if (pressed_key == ' ') {
+        jog_stop_and_wait();
+        return;
+    }
+}
+jog_stop_and_wait();
+
+missed_at_cmd = atomic_load_explicit(&step_tl.missed, memory_order_relaxed);
+
 switch (pressed_key) {
 
 	case 114 :    
         // pressed_key char = r or int = 114 
         // DRIVE CNC ALONG X-AXIS
-        DTStamp();printf(" r drive_right   (500) X-axis (3,2 CW)\t==> (1/0)(1) (0)(0) (0)(0) running ... ");
-        fflush(stdout);
+        event_log_write(&event_log, EV_CMD_BEGIN, pressed_key, 0, 0, 0);
 	    drive_right(distance);  // DRIVE (3,2 CW) = 00000011 and 00000010 binary
-        printf("done.\n");
+        report_done();
         break;
 
 	case 108 :    
         // pressed_key char = l or int = 108 
         // DRIVE CNC ALONG X-AXIS
-        DTStamp(); printf(" l drive_left    (500) X-axis (1,0 CCW)\t==> (1)(0) (0)(0) (0)(0)   running ... ");
-        fflush(stdout);
+        event_log_write(&event_log, EV_CMD_BEGIN, pressed_key, 0, 0, 0);
 	    drive_left(distance);   // DRIVE (1,0 CCW) = 00000001 and 00000000 binary
-        printf("done.\n");
+        report_done();
         break;	
 
 	case 102 :    
         // pressed_key char = f or int = 102 
         // DRIVE CNC ALONG Y-AXIS //front
-	    DTStamp();printf(" f drive_forward (500) Y-axis (12,8 CW)\t==> (0)(0) (1/0)(1) (0)(0) running ... ");
-	    fflush(stdout);
-	    drive_up(distance);    // DRIVE (12,8 CW) = 00001100 and 00001000 binary
-        printf("done.\n");
+	    event_log_write(&event_log, EV_CMD_BEGIN, pressed_key, 0, 0, 0);
+	    drive_forward(distance);   // DRIVE (12,8 CW) = 00001100 and 00001000 binary
+        report_done();
         break;	
 
 	case 98 :    
         // pressed_key char = b or int = 98 
         // DRIVE CNC ALONG Y-AXIS //back
-        DTStamp();printf(" b drive_backward(500) Y-axis (4,0 CCW)\t==> (0)(0) (1)(0) (0)(0)   running ... ");
-	    fflush(stdout);
-        drive_down(distance);  // DRIVE (4,0 CCW) = 00000100 and 00000000 binary
-        printf("done.\n");
+        event_log_write(&event_log, EV_CMD_BEGIN, pressed_key, 0, 0, 0);
+        drive_backward(distance);  // DRIVE (4,0 CCW) = 00000100 and 00000000 binary
+        report_done();
         break;	
 
 	case 117 :    
         // pressed_key char = u or int = 117 
         // DRIVE CNC ALONG Z-AXIS
-        DTStamp();printf(" u drive_up      (500) Z-axis (16,0 CW)\t==> (0)(0) (0)(0) (1)(0)   running ... ");
-        fflush(stdout);
-	    drive_up(distance);    // DRIVE (16,0 CW) = 00010000 and 00000000 binary
-        printf("done.\n");
+        event_log_write(&event_log, EV_CMD_BEGIN, pressed_key, 0, 0, 0);
+	    drive_up(distance);    // DRIVE (16,0 CCW) = 00010000 and 00000000 binary
+        report_done();
         break;
 
 	 case 100 :    
         // pressed_key char = d or int = 100 
         // DRIVE CNC ALONG Z-AXIS
-        DTStamp();printf(" d drive_down    (500) Z-axis (48,32 CCW)=> (0)(0) (0)(0) (1/0)(1) running ... ");
-        fflush(stdout);
-	    drive_down(distance);   // DRIVE (48,32 CCW) = 00110000 and 00100000 binary
-        printf("done.\n");
+        event_log_write(&event_log, EV_CMD_BEGIN, pressed_key, 0, 0, 0);
+	    drive_down(distance);   // DRIVE (48,32 CW) = 00110000 and 00100000 binary
+        report_done();
+        break;
+
+	 case 97 :
+        // pressed_key char = a or int = 97
+        // TURN CNC ROTARY A-AXIS
+        if (!pin_map_wired(&pin_map, AXIS_A)) {
+            event_log_write(&event_log, EV_INVALID, pressed_key, 0, 0, 0);
+            break;
+        }
+        event_log_write(&event_log, EV_CMD_BEGIN, pressed_key, 0, 0, 0);
+	    drive_cw(distance);    // DRIVE (192,128 CW) = 11000000 and 10000000 binary
+        report_done();
+        break;
+
+	 case 115 :
+        // pressed_key char = s or int = 115
+        // TURN CNC ROTARY A-AXIS
+        if (!pin_map_wired(&pin_map, AXIS_A)) {
+            event_log_write(&event_log, EV_INVALID, pressed_key, 0, 0, 0);
+            break;
+        }
+        event_log_write(&event_log, EV_CMD_BEGIN, pressed_key, 0, 0, 0);
+	    drive_ccw(distance);   // DRIVE (64,0 CCW) = 01000000 and 00000000 binary
+        report_done();
+        break;
+
+	 case 120 :    
+        // pressed_key char = x or int = 120 
+        // DRIVE CNC ALONG X, Y AND Z TOGETHER
+        event_log_write(&event_log, EV_CMD_BEGIN, pressed_key, 0, 0, 0);
+	    drive_diagonal(distance);   // DRIVE (63,42) = 00111111 and 00101010 binary
+        report_done();
+        break;
+
+	 case 99 :    
+        // pressed_key char = c or int = 99 
+        // TOGGLE CONTINUOUS (HOLD-TO-MOVE) JOG MODE
+        jog_continuous = !jog_continuous;
+        event_log_write(&event_log, EV_JOG_MODE, jog_continuous, 0, 0, 0);
+        break;
+	
+	 case 104 :    
+        // pressed_key char = h or int = 104 
+        // HOME Z, X AND Y ON THEIR SWITCHES
+        home_all_axes();
+        break;
+	
+	 case 116 :    
+        // pressed_key char = t or int = 116 
+        // DUMP STEP-EDGE LATENESS HISTOGRAM
+        event_log_write(&event_log, EV_TIMING, 0, 0, 0, 0);
+        event_log_flush(&event_log);
+        report_latency();
         break;
 	
         case 113 :
         // pressed_key char = q or int = 113 
         // QUIT AND EXIT PROGRAM
-        DTStamp();printf(" q Quit and exit. \t\t==> Alhamdulillah. Done. \n\n");
+        event_log_write(&event_log, EV_QUIT, 0, 0, 0, 0);
         
-        reset_CNC();
+        motion_submit(MOTION_CMD_RESET, 0, 0, 0, 0);
+        motion_wait_idle();
+        event_log_flush(&event_log);
+        event_log_stop(&event_log);
+        report_step_timing();
+        report_two_rate();
+        report_port_skew();
+        report_fifo();
+        report_latency();
+        report_motion_queue();
+        report_input_cpu();
+        DTStamp(); printf("SUCCESS: Display event log dropped records \t= %llu\n",
+            (unsigned long long)atomic_load(&event_log.dropped));
         
-        // CLOSE PARALLEL PORT AND KEYBOARD
+        // CLOSE SHARED MEMORY, TRACE, PARALLEL PORT AND KEYBOARD
+        close_shm();
+        close_capture();
         close_parallel_port();
         close_keyboard();
         DTStamp();printf("Alhamdulillah. Finished CNC keyboard jogging. \n\n");
         exit(0);
 
      default :
-        DTStamp();printf(" %c \tERROR: Invalid command: ==> char %c or int %d \n", pressed_key, pressed_key, pressed_key);
+        event_log_write(&event_log, EV_INVALID, pressed_key, 0, 0, 0);
     
 } // END switch..case
 		
+}
+// ================================================
+void    report_done(void) {
+// ================================================
+    // Close the "running ... " line of the current command
+    uint64_t missed = atomic_load_explicit(&step_tl.missed, memory_order_relaxed);
+
+    event_log_write(&event_log, EV_CMD_DONE, (int64_t)(missed - missed_at_cmd), 0, 0, 0);
+}
+// ================================================
+// DRIVE KEY TEXT, BUILT FROM THE PIN MAP
+// ================================================
+struct drive_key {
+    int         key;
+    const char *func;           // drive_* function
+    const char *menu;           // Menu label
+    const char *axis;           // Axis label
+    int         dir[NUM_AXES];  // +1 = CW (direction bit set)
+};
+
+static const struct drive_key drive_keys[] = {
+    { 'r', "drive_right",    "RIGHT-X",    "x-axis", { +1,  0,  0,  0 } },
+    { 'l', "drive_left",     "LEFT-X",     "x-axis", { -1,  0,  0,  0 } },
+    { 'f', "drive_forward",  "FORWARD-Y",  "y-axis", {  0, +1,  0,  0 } },
+    { 'b', "drive_backward", "BACKWARD-Y", "y-axis", {  0, -1,  0,  0 } },
+    { 'u', "drive_up",       "UP-Z",       "z-axis", {  0,  0, -1,  0 } },
+    { 'd', "drive_down",     "DOWN-Z",     "z-axis", {  0,  0, +1,  0 } },
+    { 'a', "drive_cw",       "CW-A",       "a-axis", {  0,  0,  0, +1 } },
+    { 's', "drive_ccw",      "CCW-A",      "a-axis", {  0,  0,  0, -1 } },
+    { 'x', "drive_diagonal", "DIAGONAL",   "x, y, z", { +1, +1, +1,  0 } },
+};
+#define NUM_DRIVE_KEYS    (int)(sizeof(drive_keys) / sizeof(drive_keys[0]))
+
+static char drive_menu_text[NUM_DRIVE_KEYS][160];
+static char drive_cmd_text[NUM_DRIVE_KEYS][160];
+
+// ================================================
+void    build_cmd_descriptions(void) {
+// ================================================
+    // Menu lines and command lines show the DATA_REG bytes and
+    // pin levels of the loaded pin map, so they cannot drift
+    // from what is actually written to the port.
+    const struct drive_key *dk;
+    unsigned char code_hi, code_lo;
+    char pins[64], bytes[32];
+    int i, axis;
+
+    for (i = 0; i < NUM_DRIVE_KEYS; i++) {
+        dk = &drive_keys[i];
+        code_hi = code_lo = 0;
+        for (axis = 0; axis < NUM_AXES; axis++) {
+            if (dk->dir[axis] != 0)
+                code_hi |= AXIS_STEP_BIT(axis);
+            if (dk->dir[axis] > 0) {
+                code_hi |= AXIS_DIR_BIT(axis);
+                code_lo |= AXIS_DIR_BIT(axis);
+            }
+        }
+        pin_map_describe(&pin_map, code_hi, code_lo, pins, sizeof(pins));
+        snprintf(bytes, sizeof(bytes), "(%u,%u %s)", pin_map_byte(&pin_map, code_hi),
+                 pin_map_byte(&pin_map, code_lo), code_lo != 0 ? "CW" : "CCW");
+        snprintf(drive_menu_text[i], sizeof(drive_menu_text[i]), " %c Drive %-11s the %-8s %-13s PINS = %s",
+                 dk->key, dk->menu, dk->axis, bytes, pins);
+        snprintf(drive_cmd_text[i], sizeof(drive_cmd_text[i]), " %c %-15s(%d) %-8s %-13s ==> %s running ... ",
+                 dk->key, dk->func, distance, dk->axis, bytes, pins);
+    }
+}
+// ================================================
+const char *cmd_description(int key) {
+// ================================================
+    int i;
+    for (i = 0; i < NUM_DRIVE_KEYS; i++)
+        if (drive_keys[i].key == key)
+            return drive_cmd_text[i];
+    return "";
+}
+// ================================================
+void    format_event(const struct event_rec *rec, FILE *fp) {
+// ================================================
+    // Runs on the event log drain thread
+    switch (rec->id) {
+
+    case EV_CMD_BEGIN:
+        event_log_stamp(&event_log, rec->t_ns, fp);
+        fprintf(fp, "%s", cmd_description((int)rec->arg[0]));
+        break;
+
+    case EV_CMD_DONE:
+        if (rec->arg[0] == 0)
+            fprintf(fp, "done.\n");
+        else
+            fprintf(fp, "done. (missed deadlines = %lld)\n", (long long)rec->arg[0]);
+        break;
+
+    case EV_JOG_MODE:
+        event_log_stamp(&event_log, rec->t_ns, fp);
+        fprintf(fp, " c continuous jog mode \t\t==> %s\n",
+            rec->arg[0] ? "ON (hold r/l/f/b/u/d/a/s, space stops)" : "OFF (500 pulses per key)");
+        break;
+
+    case EV_JOG_BEGIN:
+        event_log_stamp(&event_log, rec->t_ns, fp);
+        fprintf(fp, " %c jog (%s) continuous \t==> running ... ", (int)rec->arg[0],
+            rec->arg[1] ? "hold" : "space to stop");
+        break;
+
+    case EV_JOG_DONE:
+        fprintf(fp, "done. (%lld steps", (long long)rec->arg[0]);
+        if (rec->arg[2] >= 0)
+            fprintf(fp, ", stop-to-decel %lld us, stop-to-last-pulse %lld us",
+                (long long)rec->arg[1] / 1000, (long long)rec->arg[2] / 1000);
+        if (rec->arg[3] != 0)
+            fprintf(fp, ", missed deadlines = %lld", (long long)rec->arg[3]);
+        fprintf(fp, ")\n");
+        break;
+
+    case EV_TIMING:
+        event_log_stamp(&event_log, rec->t_ns, fp);
+        fprintf(fp, " t step-edge timing \t\t==> latency histogram so far\n");
+        break;
+
+    case EV_INVALID:
+        event_log_stamp(&event_log, rec->t_ns, fp);
+        fprintf(fp, " %c \tERROR: Invalid command: ==> char %c or int %d \n",
+            (int)rec->arg[0], (int)rec->arg[0], (int)rec->arg[0]);
+        break;
+
+    case EV_QUIT:
+        event_log_stamp(&event_log, rec->t_ns, fp);
+        fprintf(fp, " q Quit and exit. \t\t==> Alhamdulillah. Done. \n\n");
+        break;
+
+    case EV_HOME_BEGIN:
+        event_log_stamp(&event_log, rec->t_ns, fp);
+        fprintf(fp, " h home %c-axis \t\t\t==> seeking switch ... ", AXIS_NAME(rec->arg[0]));
+        break;
+
+    case EV_HOME_DONE:
+        if (rec->arg[1] == HOME_OK)
+            fprintf(fp, "done. (position 0 = step %lld", (long long)rec->arg[2]);
+        else
+            fprintf(fp, "ERROR: switch %s (", rec->arg[1] == HOME_NO_SWITCH ? "not found" : "never released");
+        if (rec->arg[3] != 0)
+            fprintf(fp, ", missed deadlines = %lld", (long long)rec->arg[3]);
+        fprintf(fp, ")\n");
+        break;
+
+    case EV_LIMIT_TRIP:
+        fprintf(fp, "STOPPED by %c-axis limit switch at %lld steps ... ",
+            AXIS_NAME(rec->arg[0]), (long long)rec->arg[1]);
+        break;
+
+    case EV_SOFT_LIMIT:
+        fprintf(fp, "clipped by %c-axis soft limit to %lld of %lld steps ... ",
+            AXIS_NAME(rec->arg[0]), (long long)rec->arg[2], (long long)rec->arg[1]);
+        break;
+
+    case EV_SHM_MOVE:
+        event_log_stamp(&event_log, rec->t_ns, fp);
+        fprintf(fp, " shm move X/Y/Z/A %lld / %lld / %lld / %lld \t==> running ... ",
+            (long long)rec->arg[0], (long long)rec->arg[1], (long long)rec->arg[2], (long long)rec->arg[3]);
+        break;
+    }
+}
+// ================================================
+void    report_step_timing(void) {
+// ================================================
+    printf("\n");
+    DTStamp(); printf("SUCCESS: Display step edges \t= %llu (PERIOD %ld ns)\n",
+        (unsigned long long)step_tl.edges, step_tl.period_ns);
+    DTStamp(); printf("SUCCESS: Display missed deadlines \t= %llu\n",
+        (unsigned long long)step_tl.missed);
+    DTStamp(); printf("SUCCESS: Display position X/Y/Z/A \t= %lld / %lld / %lld / %lld (steps, homed %c%c%c%c)\n",
+        (long long)step_position(&step_state, AXIS_X), (long long)step_position(&step_state, AXIS_Y),
+        (long long)step_position(&step_state, AXIS_Z), (long long)step_position(&step_state, AXIS_A),
+        atomic_load(&step_state.homed[AXIS_X]) ? 'X' : '-', atomic_load(&step_state.homed[AXIS_Y]) ? 'Y' : '-',
+        atomic_load(&step_state.homed[AXIS_Z]) ? 'Z' : '-', atomic_load(&step_state.homed[AXIS_A]) ? 'A' : '-');
+    if (step_tl.wakes > 0) {
+        DTStamp(); printf("SUCCESS: Display spin margin now/worst wake-up \t= %.1f / %.1f (us), %llu late wake-ups\n",
+            step_tl.margin_ns / 1000.0, step_tl.max_wake_ns / 1000.0, (unsigned long long)step_tl.overshoots);
+        DTStamp(); printf("SUCCESS: Display spin time per edge \t= %.1f (us)\n",
+            step_tl.edges ? step_tl.spin_ns / 1000.0 / step_tl.edges : 0.0);
+    }
+    if (step_state.checks > 0) {
+        DTStamp(); printf("SUCCESS: Display limit check per step mean/max \t= %.1f / %llu (ns), %llu checks, %llu trips\n",
+            (double)step_state.check_ns_sum / step_state.checks, (unsigned long long)step_state.check_ns_max,
+            (unsigned long long)step_state.checks, (unsigned long long)step_state.limit_trips);
+    }
+}
+// ================================================
+void    report_latency(void) {
+// ================================================
+    struct latency_summary ls;
+    FILE *fp;
+
+    latency_hist_summary(&edge_hist, &ls);
+    DTStamp(); printf("SUCCESS: Display edge lateness count/overruns \t= %llu / %llu\n",
+        (unsigned long long)ls.count, (unsigned long long)ls.overruns);
+    DTStamp(); printf("SUCCESS: Display edge lateness min/mean/max \t= %.1f / %.1f / %.1f (us)\n",
+        ls.min_ns / 1000.0, ls.mean_ns / 1000.0, ls.max_ns / 1000.0);
+    DTStamp(); printf("SUCCESS: Display edge lateness p99/p99.9/p99.99 \t= %.1f / %.1f / %.1f (us)\n",
+        ls.p99_ns / 1000.0, ls.p999_ns / 1000.0, ls.p9999_ns / 1000.0);
+
+    if (hist_file != NULL) {
+        fp = fopen(hist_file, "w");
+        if (fp == NULL) {
+            DTStamp(); printf("ERROR  : Cannot write histogram file %s\n", hist_file);
+            perror(hist_file);
+            return;
+        }
+        latency_hist_dump(&edge_hist, fp);
+        fclose(fp);
+        DTStamp(); printf("SUCCESS: Write edge lateness histogram \t= %s\n", hist_file);
+    }
 }
 // ================================================
 void    run_menu(void) {
 // ================================================
+    int i;
 
 	printf("\n\tMENU OF COMMANDS (ACTIONS). \n");
 	printf("\t===========================\n");
 
-	printf(" r Drive RIGHT-X     the x-axis (3,2    CW) PINS = (1/0)(1) (0)(0) (0)(0)\n");
-	printf(" l Drive LEFT-X      the x-axis (1,0   CCW) PINS =   (1)(0) (0)(0) (0)(0)\n");
-	
-	printf(" f Drive FORWARD-Y   the y-axis (12,8   CW) PINS = (0)(0) (1/0)(1) (0)(0)\n"); 
-    printf(" b Drive BACKWARD-Y  the y-axis (4,0   CCW) PINS = (0)(0)   (1)(0) (0)(0)\n");
-
-    printf(" u Drive UP-Z        the z-axis (16,0   CW) PINS = (0)(0) (0)(0)   (1)(0)\n");
-	printf(" d Drive DOWN-Z      the z-axis (48,32 CCW) PINS = (0)(0) (0)(0) (1/0)(0)\n");
+    for (i = 0; i < NUM_DRIVE_KEYS; i++) {
+        // No A keys when the pin map leaves A unwired
+        if (drive_keys[i].dir[AXIS_A] != 0 && !pin_map_wired(&pin_map, AXIS_A))
+            continue;
+        printf("%s\n", drive_menu_text[i]);
+        if (drive_keys[i].key == 'l' || drive_keys[i].key == 'b' || drive_keys[i].key == 'd'
+            || drive_keys[i].key == 's')
+            printf("\n");
+    }
+    printf(" c CONTINUOUS jog on/off (hold a direction key to move, space to stop)\n");
+    printf(" t TIMING: show the step-edge lateness histogram summary\n");
+    printf(" h HOME z, x, y (and a) on their limit switches (position 0 = just off the switch)\n");
 
 	printf(" q QUIT and exit this program.\n\n");
 
@@ -363,25 +1148,127 @@ void close_keyboard() {
 // ==============================================
 int keyboard_hit() {
 // ==============================================
+    return keyboard_wait(0);
+}
+// ==============================================
+int keyboard_wait(int timeout_ms) {
+// ==============================================
+    // Sleep in poll() until a key arrives or timeout_ms
+    // passes (-1 = forever). The tty keeps the VMIN = 1
+    // set once by init_keyboard(), so no termios calls here.
+    struct pollfd pfd;
     char ch;
     int nread;
 
     if(peek_character != -1)
       { return 1; }
 
-    new_settings.c_cc[VMIN]=0;
-    tcsetattr(0, TCSANOW, &new_settings);
-    nread = read(0,&ch,1);
-    new_settings.c_cc[VMIN]=1;
-    tcsetattr(0, TCSANOW, &new_settings);
+    pfd.fd      = 0;
+    pfd.events  = POLLIN;
+    pfd.revents = 0;
+    if (poll(&pfd, 1, timeout_ms) <= 0)
+        return 0;
 
+    nread = read(0,&ch,1);
     if(nread == 1) {
         peek_character = ch;
         return 1;
     }
+    if (nread == 0) {
+        // stdin closed (e.g. piped commands): behave as 'q'
+        peek_character = 'q';
+        return 1;
+    }
 return(0);
 }
 // ==============================================
+int keyboard_timeout_ms(void) {
+// ==============================================
+    // How long the keyboard loop may sleep: forever when idle,
+    // short while a jog runs so the hold timeout and the end
+    // of the jog are noticed promptly.
+    if (!jog_active && shm == NULL)
+        return -1;
+    return 10;
+}
+// ==============================================
+static int input_latency_pipe[2];
+static void *input_latency_writer(void *data) {
+// ==============================================
+    // Write our send time into the pipe once per millisecond
+    int i, samples = *(int *)data;
+    uint64_t t;
+    for (i = 0; i < samples; i++) {
+        usleep(1000);
+        t = monotonic_ns();
+        if (write(input_latency_pipe[1], &t, sizeof(t)) != sizeof(t))
+            break;
+    }
+    return NULL;
+}
+// ==============================================
+void measure_input_latency(int samples) {
+// ==============================================
+    // Wake-up latency of the poll() input path: a helper thread
+    // writes a timestamp into a pipe and we measure how long
+    // poll() takes to return with it.
+    struct pollfd pfd;
+    pthread_t writer;
+    uint64_t sent, woke, lat, min_lat = UINT64_MAX, max_lat = 0, sum_lat = 0;
+    int i, got = 0;
+
+    printf("\n");
+    DTStamp(); printf("EXECUTING  measure_input_latency(%d).\n", samples);
+    if (pipe(input_latency_pipe) != 0) {
+        DTStamp(); printf("ERROR  : Create pipe for input latency test\n");
+        perror("pipe");
+        return;
+    }
+    pthread_create(&writer, NULL, input_latency_writer, &samples);
+
+    pfd.fd     = input_latency_pipe[0];
+    pfd.events = POLLIN;
+    for (i = 0; i < samples; i++) {
+        if (poll(&pfd, 1, 1000) != 1)
+            break;
+        woke = monotonic_ns();
+        if (read(input_latency_pipe[0], &sent, sizeof(sent)) != sizeof(sent))
+            break;
+        lat = woke - sent;
+        if (lat < min_lat) min_lat = lat;
+        if (lat > max_lat) max_lat = lat;
+        sum_lat += lat;
+        got++;
+    }
+    pthread_join(writer, NULL);
+    close(input_latency_pipe[0]);
+    close(input_latency_pipe[1]);
+
+    if (got > 0) {
+        DTStamp(); printf("SUCCESS: Display input wake-up latency min/mean/max \t= %.1f / %.1f / %.1f (us), %d samples\n",
+            min_lat / 1000.0, sum_lat / 1000.0 / got, max_lat / 1000.0, got);
+    }
+    DTStamp(); printf("COMPLETED measure_input_latency(%d).\n", samples);
+}
+// ==============================================
+void report_input_cpu(void) {
+// ==============================================
+    // CPU time used by the keyboard (main) thread while waiting for keys
+    // (since input_start_ns, not the setup before it)
+    struct rusage ru;
+    double cpu_s, wall_s;
+
+    if (getrusage(RUSAGE_THREAD, &ru) != 0)
+        return;
+    cpu_s  = (ru.ru_utime.tv_sec - input_start_ru.ru_utime.tv_sec)
+           + (ru.ru_stime.tv_sec - input_start_ru.ru_stime.tv_sec)
+           + (ru.ru_utime.tv_usec - input_start_ru.ru_utime.tv_usec
+              + ru.ru_stime.tv_usec - input_start_ru.ru_stime.tv_usec) / 1e6;
+    wall_s = (monotonic_ns() - input_start_ns) / 1e9;
+    DTStamp(); printf("SUCCESS: Display keyboard thread CPU \t= %.3f s of %.3f s (%.2f %%)\n",
+        cpu_s, wall_s, wall_s > 0 ? 100.0 * cpu_s / wall_s : 0.0);
+}
+// ==============================================
 int read_charkey() {
 // ==============================================
     char ch;
@@ -395,110 +1282,2010 @@ return (ch);
 }
 
 
+// ==============================================
+// COORDINATED X/Y/Z/A MOVE (DDA, one DATA_REG write per edge)
+// ==============================================
+void    drive_axes(int dx, int dy, int dz, int da) {
+        // Positive = CW (direction bit set), see pulse-compiler.h.
+        // Clips the move to the soft limits, compiles and queues
+        // it, then waits for it.
+        int32_t delta[NUM_AXES];
+
+        delta[AXIS_X] = dx;
+        delta[AXIS_Y] = dy;
+        delta[AXIS_Z] = dz;
+        delta[AXIS_A] = da;
+        clip_to_soft_limits(delta);
+        motion_submit_move(delta[AXIS_X], delta[AXIS_Y], delta[AXIS_Z], delta[AXIS_A]);
+        motion_wait_idle();
+        if (limit_fault_service())
+            event_log_write(&event_log, EV_LIMIT_TRIP, step_state.fault_axis,
+                step_position(&step_state, step_state.fault_axis), 0, 0);
+}
+const struct ramp_table *select_ramp(const int32_t delta[NUM_AXES]) {
+        // The slowest moving axis sets the pace of the whole move
+        const struct ramp_table *ramp = NULL;
+        int axis;
+        for (axis = 0; axis < NUM_AXES; axis++) {
+            if (delta[axis] == 0)
+                continue;
+            if (ramp == NULL
+                || axis_limits[axis].max_rate < axis_limits[ramp - axis_ramp].max_rate
+                || (axis_limits[axis].max_rate == axis_limits[ramp - axis_ramp].max_rate
+                    && axis_limits[axis].accel < axis_limits[ramp - axis_ramp].accel))
+                ramp = &axis_ramp[axis];
+        }
+        return ramp;
+}
+void    drive_diagonal(int valdrive) {
+        // DRIVE X, Y AND Z TOGETHER (right, forward, down)
+        drive_axes(valdrive, valdrive, valdrive, 0);
+}
 // ==============================================
 // DRIVE CNC ALONG X-AXIS
 // ==============================================
+// (Byte values in these comments are for the default
+// pin map; the port gets pin_map.lut[] of them.)
 void    drive_right(int valdrive) {    
-        // DRIVE (3,2 CW) BINARY OUTPUT
-        for (count=0; count<valdrive; count++) {
-            outb(3, DATA_REG); usleep(500);     // 00000011
-            outb(2, DATA_REG); usleep(500);     // 00000010
-        }
-        reset_CNC();
+        // DRIVE (3,2 CW) BINARY OUTPUT       // 00000011 / 00000010
+        drive_axes(valdrive, 0, 0, 0);
 }
 void    drive_left(int valdrive) {    
-        // DRIVE (1,0 CCW) BINARY OUTPUT
-        for (count=0; count<valdrive; count++) {
-            outb(1, DATA_REG); usleep(500);     // 00000001
-            outb(0, DATA_REG); usleep(500);     // 00000000
-        }
-        reset_CNC();
+        // DRIVE (1,0 CCW) BINARY OUTPUT      // 00000001 / 00000000
+        drive_axes(-valdrive, 0, 0, 0);
 }
 // ==============================================
 // DRIVE CNC ALONG Y-AXIS 
 // ==============================================
 void    drive_forward(int valdrive)     {    
-        // DRIVE (12,8 CW) BINARY OUTPUT 
-        for (count=0; count<valdrive; count++) {
-            outb(12, DATA_REG); usleep(500);    // 00001100 
-            outb(8,  DATA_REG); usleep(500);    // 00001000
-        }
-        reset_CNC();
+        // DRIVE (12,8 CW) BINARY OUTPUT      // 00001100 / 00001000
+        drive_axes(0, valdrive, 0, 0);
 }
 void    drive_backward(int valdrive) {    
-        // DRIVE (4,0, CCW) BINARY OUTPUT
-        for (count=0; count<valdrive; count++) {
-            outb(4, DATA_REG); usleep(500);     // 00000100
-            outb(0, DATA_REG); usleep(500);     // 00000000
-        }
-        reset_CNC();
+        // DRIVE (4,0, CCW) BINARY OUTPUT     // 00000100 / 00000000
+        drive_axes(0, -valdrive, 0, 0);
 }
 // ==============================================
 // DRIVE CNC ALONG Z-AXIS
 // ==============================================
 void    drive_down(int valdrive){        
-        // DRIVE (48,32 CCW) BINARY OUTPUT 
-        for (count=0; count<valdrive; count++) {
-            outb(48, DATA_REG); usleep(500);   // 00110000
-            outb(32, DATA_REG); usleep(500);   // 00100000
-        }
-        reset_CNC();
+        // DRIVE (48,32 CW) BINARY OUTPUT     // 00110000 / 00100000
+        drive_axes(0, 0, valdrive, 0);
 }
 void    drive_up(int valdrive){        
-        // DRIVE (16,0  CW) BINARY OUTPUT    
-        for (count=0; count<valdrive; count++) {
-            outb(16, DATA_REG); usleep(500);    // 00010000
-            outb(0,  DATA_REG); usleep(500);    // 00000000
+        // DRIVE (16,0  CCW) BINARY OUTPUT    // 00010000 / 00000000
+        drive_axes(0, 0, -valdrive, 0);
+}
+// ==============================================
+// TURN CNC ROTARY A-AXIS
+// ==============================================
+void    drive_cw(int valdrive){
+        // DRIVE (192,128 CW) BINARY OUTPUT   // 11000000 / 10000000
+        drive_axes(0, 0, 0, valdrive);
+}
+void    drive_ccw(int valdrive){
+        // DRIVE (64,0  CCW) BINARY OUTPUT    // 01000000 / 00000000
+        drive_axes(0, 0, 0, -valdrive);
+}
+
+// ==================================================================
+// STEPPING THREAD
+// ==================================================================
+void   *step_thread_main(void *unused) {
+    // Pop and execute commands; between commands keep ticking
+    // at PERIOD so a new command starts within one PERIOD.
+    struct motion_cmd cmd;
+
+    (void)unused;
+
+    step_timeline_init(&idle_tl, period_ns);
+    step_timeline_start(&idle_tl);
+    for (;;) {
+        if (motion_queue_pop(&motion_q, &cmd)) {
+            execute_motion_cmd(&cmd);
+            motion_queue_complete(&motion_q, cmd.seq);
+            step_timeline_start(&idle_tl);
+        } else {
+            parport_fifo_finish(&port);     // Nothing more to feed it
+            step_timeline_wait(&idle_tl);
+        }
+    }
+    return NULL;
+}
+
+// ==============================================
+void    execute_motion_cmd(const struct motion_cmd *cmd) {
+// ==============================================
+    // Runs on the stepping thread
+    struct pulse_buffer *buf;
+    const struct ramp_table *ramp;
+    uint64_t t_cpu;
+    int dir[NUM_AXES];
+    int axis, tripped, use_fifo;
+
+    // Everything but a FIFO-played move writes the port directly
+    if (cmd->type != MOTION_CMD_PULSES || !fifo_mode)
+        parport_fifo_finish(&port);
+
+    switch (cmd->type) {
+
+    case MOTION_CMD_PULSES:
+        buf = &pulse_pool.buf[cmd->buffer];
+        if (atomic_load_explicit(&step_state.fault, memory_order_acquire)) {
+            pulse_buffer_release(buf);      // Dropped after a limit trip
+            break;
+        }
+        if (cmd->delta[AXIS_X] != 0 || cmd->delta[AXIS_Y] != 0 || cmd->delta[AXIS_Z] != 0 || cmd->delta[AXIS_A] != 0)
+            capture_mark(PULSE_TRACE_MARK_MOVE, cmd->delta[AXIS_X], cmd->delta[AXIS_Y], cmd->delta[AXIS_Z],
+                         cmd->delta[AXIS_A]);
+        if (buf->starts_move) {
+            step_timeline_start(&step_tl);
+            motion_queue_first_pulse(&motion_q, cmd, step_tl.start_ns);
+        }
+        t_cpu = thread_cpu_ns();
+        use_fifo = fifo_mode && (port.fifo_active || parport_fifo_start(&port, fifo_byte_ns, fifo_depth) == 0);
+        if (use_fifo) {
+            tripped = step_play_pulses_fifo(&port, &fifo_stream, buf, &step_state);
+        } else {
+            if (fifo_mode && !buf->starts_move)
+                step_timeline_start(&step_tl);  // FIFO stalled mid-move: time from here
+            tripped = step_play_pulses(&port, &step_tl, buf, &step_state);
+        }
+        play_cpu_ns[use_fifo] += thread_cpu_ns() - t_cpu;
+        play_edges[use_fifo]  += buf->count;
+        if (tripped != 0) {
+            parport_fifo_finish(&port);
+            reset_CNC();
+        }
+        pulse_buffer_release(buf);
+        break;
+
+    case MOTION_CMD_JOG:
+        if (atomic_load_explicit(&step_state.fault, memory_order_acquire))
+            break;
+        for (axis = 0; axis < NUM_AXES; axis++)
+            dir[axis] = cmd->delta[axis];
+        capture_mark(PULSE_TRACE_MARK_JOG, dir[AXIS_X], dir[AXIS_Y], dir[AXIS_Z], dir[AXIS_A]);
+        jog_control_reset(&jog, &motion_q, &step_state);
+        ramp = select_ramp(cmd->delta);
+        if (two_rate_mode && ramp != NULL)
+            two_rate_jog(&two_rate, &port, &step_tl, dir, &axis_limits[ramp - axis_ramp], &jog);
+        else
+            step_jog_continuous(&port, &step_tl, dir, ramp, &jog);
+        motion_queue_first_pulse(&motion_q, cmd, step_tl.start_ns);
+        reset_CNC();
+        break;
+
+    case MOTION_CMD_HOME:
+        {
+            struct home_config cfg;
+
+            axis = cmd->delta[0];
+            capture_mark(PULSE_TRACE_MARK_HOME, axis, 0, 0, 0);
+            cfg.fast_rate = axis_limits[axis].start_rate;
+            cfg.slow_rate = axis_limits[axis].start_rate / HOME_SLOW_DIVISOR;
+            if (cfg.slow_rate == 0)
+                cfg.slow_rate = 1;
+            cfg.max_steps = HOME_MAX_STEPS;
+            atomic_store_explicit(&step_state.fault, 0, memory_order_release);
+            home_result[axis] = step_home_axis(&port, &step_tl, &step_state, axis, &cfg);
+            reset_CNC();
         }
+        break;
+
+    case MOTION_CMD_RESET:
+        capture_mark(PULSE_TRACE_MARK_RESET, 0, 0, 0, 0);
         reset_CNC();
+        break;
+
+    case MOTION_CMD_STOP:
+        // The jog it was meant for has already stopped
+        break;
+    }
 }
 
-// ==================================================================    
-int main(int argc, char *argv[]) {
-// ==================================================================
-    DTStamp(); printf("Bismillah. Start CNC keyboard jogging. \n"); 
-    DTStamp(); printf("Note: You must run with root permission. \n\n");  
-    
-    DATA_REG     = PARPORT_ADDRESS + 0;
-    STATUS_REG   = PARPORT_ADDRESS + 1;
-    CONTROL_REG  = PARPORT_ADDRESS + 2;
-    BASE_ADDRESS = PARPORT_ADDRESS;
-    
-    // STEP (1) iopl - set I/O priority privilege level
-	io_prio_lvl = iopl(3);  		
-	check_io_priority_level();
+// ==============================================
+void    motion_submit(uint32_t type, int dx, int dy, int dz, int da) {
+// ==============================================
+    // Keyboard thread: queue one command, retrying while full
+    struct motion_cmd cmd;
+
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type = type;
+    cmd.delta[AXIS_X] = dx;
+    cmd.delta[AXIS_Y] = dy;
+    cmd.delta[AXIS_Z] = dz;
+    cmd.delta[AXIS_A] = da;
+    while (motion_queue_push(&motion_q, &cmd) != 0)
+        usleep(1000);
+}
 
-	// STEP (2) ioperm - set port input/output permissions
-	io_perm = ioperm(BASE_ADDRESS, 5, 1);
-	check_io_permission();
-	
-    // STEP (3) open parallel port devices (read/write) 
-	parport_fd = open(PARPORT_DEVICE, O_WRONLY); 
-	open_parallel_port();
-  
-  
-    // STEP (4) BEGIN CNC JOGGING
-    int charkey = 0;
-    run_menu();
-    init_keyboard();
-    
-    reset_CNC();
+// ==============================================
+void    motion_submit_move(int dx, int dy, int dz, int da) {
+// ==============================================
+    // Keyboard thread: compile the move (DDA, ramp and the
+    // trailing reset_CNC() zeros) chunk by chunk and queue each
+    // chunk as soon as it is ready, so the stepping thread
+    // starts playing while the rest is still being compiled.
+    int32_t delta[NUM_AXES];
+
+    delta[AXIS_X] = dx;
+    delta[AXIS_Y] = dy;
+    delta[AXIS_Z] = dz;
+    delta[AXIS_A] = da;
+    motion_submit_path(delta, 0, PULSE_RESET_EDGES);
+}
+
+// ==============================================
+void    motion_submit_path(const int32_t delta[NUM_AXES], uint32_t min_interval_ns, uint32_t reset_edges) {
+// ==============================================
+    // Same, with a feed limit per tick and a choice of
+    // trailing zero edges.
+    struct pulse_compiler pc;
+
+    pulse_compile_begin(&pc, delta, select_ramp(delta), period_ns, reset_edges, &pin_map);
+    pc.min_interval_ns = min_interval_ns;
+    motion_submit_compiled(&pc, 1);
+}
+
+// ==============================================
+void    motion_submit_block(const struct plan_block *block, int continues) {
+// ==============================================
+    // One planned segment. A segment that continues the
+    // previous one keeps the stepping timeline running and
+    // skips the direction setup edge unless a direction
+    // changes; no reset_CNC() zeros between segments.
+    static unsigned char last_dir_bits;
+    struct pulse_compiler pc;
+
+    pulse_compile_begin(&pc, block->delta, NULL, period_ns, 0, &pin_map);
+    pc.plan = &block->profile;
+    if (continues && pc.dir_bits == last_dir_bits)
+        pc.setup_done = 1;
+    last_dir_bits = pc.dir_bits;
+    motion_submit_compiled(&pc, !continues);
+}
+
+// ==============================================
+void    motion_submit_compiled(struct pulse_compiler *pc, int starts_move) {
+// ==============================================
+    // Fill pool buffers from pc and queue each one
+    struct pulse_buffer *buf;
+    struct motion_cmd cmd;
+    int done, first = starts_move, chunk = 0;
+
+    do {
+        buf  = pulse_pool_acquire(&pulse_pool);
+        done = pulse_compile_fill(pc, buf);
+        buf->starts_move = first;
+        first = 0;
+
+        memset(&cmd, 0, sizeof(cmd));
+        cmd.type   = MOTION_CMD_PULSES;
+        cmd.buffer = (uint32_t)(buf - pulse_pool.buf);
+        if (chunk++ == 0)
+            memcpy(cmd.delta, pc->net, sizeof(cmd.delta));     // Commanded steps, for the trace
+        while (motion_queue_push(&motion_q, &cmd) != 0)
+            usleep(1000);
+    } while (!done);
+}
+
+// ==============================================
+int64_t motion_submit_arc(const struct gcode_move *move, int64_t pos_steps[NUM_AXES]) {
+// ==============================================
+    // G2/G3 in the XY plane, with Z along it as a helix if the
+    // line has a Z word: compile the arc stepper's ticks at the
+    // programmed feed, from rest to rest. Leaves pos_steps on
+    // the (rounded) end point and returns the number of ticks,
+    // or -1 (nothing queued) if Z needs more steps than the arc
+    // has ticks.
+    struct arc_stepper arc;
+    struct pulse_compiler pc;
+    struct plan_profile plan;
+    int64_t centre[2], end[NUM_AXES];
+    double x0, y0, x1, y1, sweep, len_mm, rate, limit, scale;
+    int32_t dz;
+    int axis;
+
+    for (axis = AXIS_X; axis <= AXIS_Y; axis++)
+        centre[axis] = llround(move->center_mm[axis] * steps_per_mm[axis]) * gcode_axis_sign[axis];
+    for (axis = 0; axis < NUM_AXES; axis++)
+        end[axis] = llround(move->target_mm[axis] * steps_per_mm[axis]) * gcode_axis_sign[axis];
+    dz = (int32_t)(end[AXIS_Z] - pos_steps[AXIS_Z]);
+    arc_begin(&arc, pos_steps[AXIS_X] - centre[AXIS_X], pos_steps[AXIS_Y] - centre[AXIS_Y],
+              end[AXIS_X] - centre[AXIS_X], end[AXIS_Y] - centre[AXIS_Y], move->arc == 3);
+    if ((uint32_t)abs(dz) > arc_count_ticks(&arc))
+        return -1;
+    pulse_compile_begin_arc(&pc, &arc, dz, period_ns, 0, &pin_map);
+
+    // Path length for the feed; trig here on the keyboard
+    // thread only, never per tick
+    x0 = move->start_mm[AXIS_X] - move->center_mm[AXIS_X];
+    y0 = move->start_mm[AXIS_Y] - move->center_mm[AXIS_Y];
+    x1 = move->target_mm[AXIS_X] - move->center_mm[AXIS_X];
+    y1 = move->target_mm[AXIS_Y] - move->center_mm[AXIS_Y];
+    sweep = atan2(y1, x1) - atan2(y0, x0);
+    if (move->arc == 2)
+        sweep = -sweep;
+    if (sweep <= 1e-9)
+        sweep += 2.0 * M_PI;
+    len_mm = hypot(hypot(x0, y0) * sweep, move->target_mm[AXIS_Z] - move->start_mm[AXIS_Z]);
+
+    memset(&plan, 0, sizeof(plan));
+    rate = HUGE_VAL;
+    if (move->feed_mm_min > 0.0 && len_mm > 0.0)
+        rate = move->feed_mm_min / 60.0 * pc.major / len_mm;
+    plan.floor_rate = HUGE_VAL;
+    plan.accel      = HUGE_VAL;
+    for (axis = 0; axis < NUM_AXES; axis++) {
+        // Limits in ticks: X and Y can step every tick, Z
+        // steps |dz| times in pc.major ticks, A stands still
+        if (axis == AXIS_A || (axis == AXIS_Z && dz == 0))
+            continue;
+        scale = axis == AXIS_Z ? (double)pc.major / abs(dz) : 1.0;
+        limit = axis_limits[axis].max_rate * scale;
+        if (limit < rate) rate = limit;
+        limit = axis_limits[axis].accel * scale;
+        if (limit < plan.accel) plan.accel = limit;
+        limit = axis_limits[axis].start_rate * scale;
+        if (limit < plan.floor_rate) plan.floor_rate = limit;
+    }
+    plan.cruise_rate = rate;
+    pc.plan = &plan;
+    motion_submit_compiled(&pc, 1);
+
+    for (axis = 0; axis < NUM_AXES; axis++)
+        pos_steps[axis] = end[axis];
+    return pc.major;
+}
+
+// ==============================================
+void    motion_wait_idle(void) {
+// ==============================================
+    // Keyboard thread: wait until every queued command has run
+    while (!motion_queue_idle(&motion_q)) {
+        usleep(1000);
+        shm_publish_status(0);
+    }
+}
+
+// ==============================================
+void    report_motion_queue(void) {
+// ==============================================
+    DTStamp(); printf("SUCCESS: Display command queue pushed/max depth/full \t= %llu / %llu / %llu\n",
+        (unsigned long long)motion_q.pushed, (unsigned long long)motion_q.max_depth,
+        (unsigned long long)motion_q.full);
+    if (motion_q.latency_count > 0) {
+        DTStamp(); printf("SUCCESS: Display enqueue-to-first-pulse min/mean/max \t= %.1f / %.1f / %.1f (us)\n",
+            motion_q.latency_min_ns / 1000.0,
+            motion_q.latency_sum_ns / 1000.0 / motion_q.latency_count,
+            motion_q.latency_max_ns / 1000.0);
+    }
+}
+
+// ==============================================
+void    run_gcode_program(const char *path, int dry_run) {
+// ==============================================
+    // Stream a G-code file through the planner and the pulse
+    // pool and report the parse rate separately from the total
+    // job time.
+    struct gcode_reader reader;
+    struct gcode_move move;
+    struct plan_block block;
+    int64_t pos_steps[NUM_AXES] = { 0, 0, 0, 0 }, base[NUM_AXES], target;
+    int32_t delta[NUM_AXES];
+    double dist_mm, len_mm, major_ms, job_s, parse_s;
+    uint32_t major, min_interval;
+    uint64_t t_start, segments = 0, steps = 0, arcs = 0, arc_errors = 0;
+    int64_t arc_ticks;
+    int axis, continues = 0, bad_axis;
+
+    DTStamp(); printf("EXECUTING  run_gcode_program(%s).\n", path);
+    if (gcode_open(&reader, path) != 0) {
+        DTStamp(); printf("ERROR  : Open G-code file %s \t= %s\n", path, strerror(errno));
+        return;
+    }
+    DTStamp(); printf("SUCCESS: Display G-code file size \t= %zu (bytes, mmap)\n", reader.size);
+
+    // Program coordinates start where the machine stands
+    for (axis = 0; axis < NUM_AXES; axis++)
+        base[axis] = step_position(&step_state, axis);
+
+    planner_init(&planner, lookahead, junction_dev, axis_limits, steps_per_mm);
+    t_start = monotonic_ns();
+    while (gcode_next_move(&reader, &move)) {
+        if (atomic_load_explicit(&step_state.fault, memory_order_acquire)) {
+            DTStamp(); printf("ERROR  : G-code stopped by a limit switch before line %llu\n",
+                (unsigned long long)move.line);
+            break;
+        }
+        if ((bad_axis = gcode_move_outside_limits(&move, base)) >= 0) {
+            DTStamp(); printf("ERROR  : G-code line %llu crosses the %c-axis soft limit, program stopped\n",
+                (unsigned long long)move.line, AXIS_NAME(bad_axis));
+            break;
+        }
+        if (move.arc && steps_per_mm[AXIS_X] != steps_per_mm[AXIS_Y]) {
+            arc_errors++;           // Would be an ellipse: go straight
+        } else if (move.arc && move.target_mm[AXIS_A] != move.start_mm[AXIS_A]) {
+            DTStamp(); printf("ERROR  : G-code line %llu: A cannot turn along a G2/G3 arc, program stopped\n",
+                (unsigned long long)move.line);
+            break;
+        } else if (move.arc && !dry_run) {
+            // Arcs start and end at rest: drain the planner first
+            while (planner_pop(&planner, &block, 1)) {
+                motion_submit_block(&block, continues);
+                continues = 1;
+            }
+            arc_ticks = motion_submit_arc(&move, pos_steps);
+            if (arc_ticks < 0) {
+                DTStamp(); printf("ERROR  : G-code line %llu: helix Z is steeper than its arc, program stopped\n",
+                    (unsigned long long)move.line);
+                break;
+            }
+            steps += (uint64_t)arc_ticks;
+            arcs++;
+            continues = 0;
+        }
+
+        len_mm = 0.0;
+        major  = 0;
+        for (axis = 0; axis < NUM_AXES; axis++) {
+            // Round the absolute target, so no rounding error builds up
+            target      = llround(move.target_mm[axis] * steps_per_mm[axis]) * gcode_axis_sign[axis];
+            delta[axis] = (int32_t)(target - pos_steps[axis]);
+            pos_steps[axis] = target;
+            dist_mm = (double)delta[axis] / steps_per_mm[axis];
+            if (axis != AXIS_A)
+                len_mm += dist_mm * dist_mm;
+            if ((uint32_t)abs(delta[axis]) > major)
+                major = (uint32_t)abs(delta[axis]);
+        }
+        if (len_mm == 0.0) {
+            // A alone: F is in degrees/min
+            dist_mm = (double)delta[AXIS_A] / steps_per_mm[AXIS_A];
+            len_mm  = dist_mm * dist_mm;
+        }
+        if (major == 0 || dry_run)
+            continue;
+        segments++;
+        steps += major;
+
+        if (lookahead > 0) {
+            // Queue it, play whatever has left the window. Full
+            // (should not happen, we pop after every push): play
+            // the oldest block as it stands and retry.
+            while (planner_push(&planner, delta, move.rapid ? 0.0 : move.feed_mm_min) != 0) {
+                if (!planner_pop(&planner, &block, 1)) {
+                    DTStamp(); printf("ERROR  : G-code planner full at line %llu, segment dropped\n",
+                        (unsigned long long)move.line);
+                    break;
+                }
+                motion_submit_block(&block, continues);
+                continues = 1;
+            }
+            while (planner_pop(&planner, &block, 0)) {
+                motion_submit_block(&block, continues);
+                continues = 1;
+            }
+            continue;
+        }
+
+        // G1: time for the path at F, spread over the major-axis ticks
+        min_interval = 0;
+        if (!move.rapid && move.feed_mm_min > 0.0) {
+            major_ms = sqrt(len_mm) / move.feed_mm_min * 60000.0 / major;
+            if (major_ms * 1e6 < UINT32_MAX)
+                min_interval = (uint32_t)(major_ms * 1e6);
+        }
+        motion_submit_path(delta, min_interval, PULSE_RESET_EDGES);
+    }
+    while (planner_pop(&planner, &block, 1)) {
+        motion_submit_block(&block, continues);
+        continues = 1;
+    }
+    if (!dry_run) {
+        motion_submit(MOTION_CMD_RESET, 0, 0, 0, 0);
+        motion_wait_idle();
+        if (limit_fault_service()) {
+            DTStamp(); printf("ERROR  : G-code program stopped by the %c-axis limit switch at %lld steps\n",
+                AXIS_NAME(step_state.fault_axis), (long long)step_position(&step_state, step_state.fault_axis));
+        }
+    }
+    job_s   = (monotonic_ns() - t_start) / 1e9;
+    parse_s = reader.parse_ns / 1e9;
+    gcode_close(&reader);
+
+    DTStamp(); printf("SUCCESS: Display G-code lines/moves/segments \t= %llu / %llu / %llu\n",
+        (unsigned long long)reader.lines_read, (unsigned long long)reader.moves, (unsigned long long)segments);
+    if (reader.unsupported > 0 || reader.errors > 0) {
+        DTStamp(); printf("ERROR  : Display G-code unsupported/malformed words \t= %llu / %llu\n",
+            (unsigned long long)reader.unsupported, (unsigned long long)reader.errors);
+    }
+    if (arcs > 0) {
+        DTStamp(); printf("SUCCESS: Display G-code arcs (G2/G3) \t= %llu\n", (unsigned long long)arcs);
+    }
+    if (arc_errors > 0) {
+        DTStamp(); printf("ERROR  : Display G-code arcs run straight (X/Y steps/mm differ) \t= %llu\n",
+            (unsigned long long)arc_errors);
+    }
+    DTStamp(); printf("SUCCESS: Display G-code parse time \t= %.6f (s), %.0f (lines/s)\n",
+        parse_s, parse_s > 0.0 ? reader.lines_read / parse_s : 0.0);
+    if (!dry_run) {
+        DTStamp(); printf("SUCCESS: Display G-code job time/major steps \t= %.3f (s) / %llu\n",
+            job_s, (unsigned long long)steps);
+        DTStamp(); printf("SUCCESS: Display look-ahead window/blended junctions \t= %u / %llu\n",
+            lookahead, (unsigned long long)planner.blended);
+    }
+    DTStamp(); printf("COMPLETED run_gcode_program(%s).\n", path);
+}
+
+// ==============================================
+void    run_arc_benchmark(int radius) {
+// ==============================================
+    // Per-tick cost of a full circle of the given radius (steps):
+    // the bare arc stepper, the pulse compiler around it, and the
+    // DATA_REG writes of the compiled edges on the simulated port.
+    static struct pulse_buffer bench_buf;
+    struct arc_stepper arc;
+    struct pulse_compiler pc;
+    uint64_t t0, gen_ns, compile_ns = 0, write_ns = 0, edges = 0;
+    double err, max_err = 0.0, tick_budget_ns = 2.0 * period_ns;
+    uint32_t ticks, i;
+    int step[2], done;
+
+    DTStamp(); printf("EXECUTING  run_arc_benchmark(%d).\n", radius);
+
+    // (1) Arc stepper alone, with the radial error of every tick
+    arc_begin(&arc, radius, 0, radius, 0, 1);
+    t0 = monotonic_ns();
+    while (arc_step(&arc, step))
+        ;
+    gen_ns = monotonic_ns() - t0;
+    ticks  = arc.ticks;
+    arc_begin(&arc, radius, 0, radius, 0, 1);
+    while (arc_step(&arc, step)) {
+        err = fabs(sqrt((double)(arc.x * arc.x + arc.y * arc.y)) - radius);
+        if (err > max_err)
+            max_err = err;
+    }
+
+    // (2) Compiled into pulse buffers, (3) written to the port
+    arc_begin(&arc, radius, 0, radius, 0, 1);
+    pulse_compile_begin_arc(&pc, &arc, 0, period_ns, 0, &pin_map);
+    do {
+        bench_buf.count = 0;
+        t0 = monotonic_ns();
+        done = pulse_compile_fill(&pc, &bench_buf);
+        compile_ns += monotonic_ns() - t0;
+
+        if (port_kind == PARPORT_BACKEND_SIM) {
+            t0 = monotonic_ns();
+            for (i = 0; i < bench_buf.count; i++)
+                parport_write(&port, bench_buf.byte[i]);
+            write_ns += monotonic_ns() - t0;
+        }
+        edges += bench_buf.count;
+    } while (!done);
+    parport_write(&port, pin_map_byte(&pin_map, 0));
+
+    DTStamp(); printf("SUCCESS: Display arc ticks/max radial error \t= %u / %.3f (steps)\n", ticks, max_err);
+    DTStamp(); printf("SUCCESS: Display arc stepper per tick \t= %.1f (ns)\n", (double)gen_ns / ticks);
+    DTStamp(); printf("SUCCESS: Display arc compile per tick \t= %.1f (ns)\n", (double)compile_ns / ticks);
+    if (port_kind == PARPORT_BACKEND_SIM) {
+        DTStamp(); printf("SUCCESS: Display sim port write per tick \t= %.1f (ns, %llu edges)\n",
+            (double)write_ns / ticks, (unsigned long long)edges);
+    } else {
+        DTStamp(); printf("ERROR  : Port write cost only measured with --backend=sim\n");
+    }
+    DTStamp(); printf("SUCCESS: Display tick budget at PERIOD/used \t= %.0f (ns) / %.4f%%\n",
+        tick_budget_ns, 100.0 * (compile_ns + write_ns) / ticks / tick_budget_ns);
+    DTStamp(); printf("COMPLETED run_arc_benchmark(%d).\n", radius);
+}
+
+// ==================================================================
+// FIFO (BURST) OUTPUT
+// ==================================================================
+void    init_fifo_output(void) {
+    // Try the FIFO mode once before the stepping thread owns the port
+    int axis;
+
+    if (!fifo_mode && fifo_bench_rate == 0)
+        return;
+    for (axis = 0; axis < NUM_AXES; axis++) {
+        // The FIFO mode handshakes on BUSY: a switch there would stall it
+        if (pin_map.axis[axis].home_pin == PARPORT_BUSY_PIN) {
+            DTStamp(); printf("ERROR  : Switch %s port to FIFO mode \t= %c-axis switch on pin %d (BUSY)\n",
+                port.name, AXIS_NAME(axis), PARPORT_BUSY_PIN);
+            fifo_mode = 0;
+            fifo_bench_rate = 0;
+            return;
+        }
+    }
+    if (fifo_byte_ns == 0 || parport_fifo_start(&port, fifo_byte_ns, fifo_depth) != 0
+        || parport_fifo_finish(&port) != 0) {
+        DTStamp(); printf("ERROR  : Switch %s port to FIFO mode \t= %s\n", port.name,
+            fifo_byte_ns == 0 ? "zero ns per byte" : strerror(errno));
+        fifo_mode = 0;
+        fifo_bench_rate = 0;
+        return;
+    }
+    if (port.fifo_byte_ns != fifo_byte_ns) {
+        // Hardware: the port's own pace, measured by parport_fifo_start()
+        DTStamp(); printf("SUCCESS: Display FIFO measured byte time \t= %u ns (asked for %u)\n",
+            port.fifo_byte_ns, fifo_byte_ns);
+        fifo_byte_ns = port.fifo_byte_ns;
+    }
+    DTStamp(); printf("SUCCESS: Display FIFO output \t= %u bytes, %u ns per byte%s\n",
+        port.fifo_depth, fifo_byte_ns, fifo_mode ? "" : " (benchmark only)");
+}
+
+// ==============================================
+void    run_fifo_benchmark(uint32_t rate) {
+// ==============================================
+    // The same constant-rate X move, first as timed edges and
+    // then through the FIFO (and back): CPU per edge, job time,
+    // and on the simulated port the step period error.
+    static const char *mode_name[2] = { "timed edges", "FIFO" };
+    struct pulse_compiler pc;
+    struct plan_profile plan;
+    int32_t delta[NUM_AXES] = { 0, 0, 0, 0 };
+    uint64_t t0, sim0, cpu0, edges0, missed0, under0, i, n, prev, gap, err, max_err, sum_err, gaps;
+    const struct parport_sim_write *w;
+    double ideal_ns, wall_s;
+    unsigned char byte_hi;
+    int mode, saved_mode = fifo_mode;
+
+    DTStamp(); printf("EXECUTING  run_fifo_benchmark(%u).\n", rate);
+    memset(&plan, 0, sizeof(plan));
+    plan.entry_rate = plan.cruise_rate = plan.exit_rate = plan.floor_rate = rate;
+    plan.accel = HUGE_VAL;
+    ideal_ns = 1e9 / rate;
+
+    for (mode = 0; mode < 2; mode++) {
+        fifo_mode = mode;
+        delta[AXIS_X] = mode == 0 ? FIFO_BENCH_STEPS : -FIFO_BENCH_STEPS;
+        sim0    = port.sim_head;
+        cpu0    = play_cpu_ns[mode];
+        edges0  = play_edges[mode];
+        missed0 = atomic_load_explicit(&step_tl.missed, memory_order_relaxed);
+        under0  = fifo_stream.underruns;
+
+        t0 = monotonic_ns();
+        pulse_compile_begin(&pc, delta, NULL, period_ns, PULSE_RESET_EDGES, &pin_map);
+        pc.plan = &plan;
+        motion_submit_compiled(&pc, 1);
+        motion_submit(MOTION_CMD_RESET, 0, 0, 0, 0);
+        motion_wait_idle();
+        wall_s = (monotonic_ns() - t0) / 1e9;
+
+        DTStamp(); printf("SUCCESS: Display %s CPU per edge/job time \t= %.0f (ns) / %.3f (s, ideal %.3f)\n",
+            mode_name[mode], (double)(play_cpu_ns[mode] - cpu0) / (double)(play_edges[mode] - edges0),
+            wall_s, FIFO_BENCH_STEPS / (double)rate);
+        if (mode == 0) {
+            DTStamp(); printf("SUCCESS: Display %s missed deadlines \t= %llu\n", mode_name[mode],
+                (unsigned long long)(atomic_load_explicit(&step_tl.missed, memory_order_relaxed) - missed0));
+        } else {
+            DTStamp(); printf("SUCCESS: Display %s underruns \t= %llu\n", mode_name[mode],
+                (unsigned long long)(fifo_stream.underruns - under0));
+        }
+
+        if (port_kind != PARPORT_BACKEND_SIM)
+            continue;
+        // Period between the rising step edges actually logged
+        byte_hi = pin_map_byte(&pin_map, AXIS_STEP_BIT(AXIS_X) | (mode == 0 ? AXIS_DIR_BIT(AXIS_X) : 0));
+        n = port.sim_head - sim0;
+        if (n > parport_sim_count(&port))
+            n = parport_sim_count(&port);
+        prev = max_err = sum_err = gaps = 0;
+        for (i = parport_sim_count(&port) - n; i < parport_sim_count(&port); i++) {
+            w = parport_sim_at(&port, i);
+            if (w->value != byte_hi)
+                continue;
+            if (prev != 0) {
+                gap = w->t_ns - prev;
+                err = gap > ideal_ns ? (uint64_t)(gap - ideal_ns) : (uint64_t)(ideal_ns - gap);
+                if (err > max_err)
+                    max_err = err;
+                sum_err += err;
+                gaps++;
+            }
+            prev = w->t_ns;
+        }
+        DTStamp(); printf("SUCCESS: Display %s step period error mean/max \t= %.1f / %.1f (us, period %.1f us)\n",
+            mode_name[mode], gaps ? sum_err / 1000.0 / gaps : 0.0, max_err / 1000.0, ideal_ns / 1000.0);
+    }
+    fifo_mode = saved_mode;
+    DTStamp(); printf("COMPLETED run_fifo_benchmark(%u).\n", rate);
+}
+
+// ==============================================
+void    report_fifo(void) {
+// ==============================================
+    int mode;
+
+    for (mode = 0; mode < 2; mode++) {
+        if (play_edges[mode] == 0)
+            continue;
+        DTStamp(); printf("SUCCESS: Display %s playback CPU per edge \t= %.0f (ns, %llu edges)\n",
+            mode ? "FIFO" : "timed", (double)play_cpu_ns[mode] / play_edges[mode],
+            (unsigned long long)play_edges[mode]);
+    }
+    if (fifo_stream.refills > 0) {
+        DTStamp(); printf("SUCCESS: Display FIFO bytes/refills/underruns \t= %llu / %llu / %llu\n",
+            (unsigned long long)fifo_stream.bytes, (unsigned long long)fifo_stream.refills,
+            (unsigned long long)fifo_stream.underruns);
+        DTStamp(); printf("SUCCESS: Display FIFO waits sleep/spin \t= %llu / %llu\n",
+            (unsigned long long)fifo_stream.sleeps, (unsigned long long)fifo_stream.spins);
+    }
+    if (atomic_load_explicit(&port.fifo_stalled, memory_order_relaxed)) {
+        DTStamp(); printf("ERROR  : FIFO did not drain (BUSY held?) \t= fell back to timed edges\n");
+    }
+}
+
+// ==================================================================
+// PULSE TRACE CAPTURE AND REPLAY
+// ==================================================================
+void    init_capture(void) {
+    // Before the stepping thread starts; records the first port only
+    if (capture_file == NULL)
+        return;
+    if (pulse_trace_create(&capture, capture_file, &pin_map, (uint32_t)period_ns, port.name) != 0) {
+        DTStamp(); printf("ERROR  : Create trace file %s \t= %s\n", capture_file, strerror(errno));
+        exit(1);
+    }
+    port.tap_arg = &capture;
+    port.tap     = pulse_trace_tap;
+    capture_on   = 1;
+    DTStamp(); printf("SUCCESS: Display capture file \t= %s (%u-word ring, background writer)\n",
+        capture_file, PULSE_TRACE_RING_WORDS);
+}
+
+// ==============================================
+void    close_capture(void) {
+// ==============================================
+    // Machine idle: nothing writes the port any more
+    if (!capture_on)
+        return;
+    port.tap   = NULL;
+    capture_on = 0;
+    if (pulse_trace_close(&capture) != 0) {
+        DTStamp(); printf("ERROR  : Finish trace file %s \t= %s\n", capture_file, strerror(errno));
+    } else {
+        DTStamp(); printf("SUCCESS: Write trace file \t= %s (%llu bytes)\n", capture_file,
+            (unsigned long long)(PULSE_TRACE_DATA_OFFSET + capture.words * 4));
+    }
+    DTStamp(); printf("SUCCESS: Display capture writes/markers/dropped \t= %llu / %llu / %llu\n",
+        (unsigned long long)capture.writes, (unsigned long long)capture.marks,
+        (unsigned long long)capture.dropped);
+    DTStamp(); printf("SUCCESS: Display capture ring peak fill \t= %llu / %u (words)\n",
+        (unsigned long long)capture.max_fill, PULSE_TRACE_RING_WORDS);
+}
+
+struct pulse_buffer      *replay_buf;           // Buffer being filled
+int                       replay_starts;        // Next buffer restarts the timeline
+
+// ==============================================
+static void replay_flush(void) {
+// ==============================================
+    struct motion_cmd cmd;
+
+    if (replay_buf == NULL)
+        return;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type   = MOTION_CMD_PULSES;
+    cmd.buffer = (uint32_t)(replay_buf - pulse_pool.buf);
+    while (motion_queue_push(&motion_q, &cmd) != 0)
+        usleep(1000);
+    replay_buf = NULL;
+}
+
+// ==============================================
+static void replay_edge(unsigned char byte, unsigned char code, uint32_t delta_ns) {
+// ==============================================
+    uint32_t i;
+
+    if (replay_buf != NULL && replay_buf->count == PULSE_BUFFER_EDGES)
+        replay_flush();
+    if (replay_buf == NULL) {
+        replay_buf = pulse_pool_acquire(&pulse_pool);
+        replay_buf->starts_move = replay_starts;
+        replay_starts = 0;
+    }
+    i = replay_buf->count++;
+    replay_buf->byte[i]     = byte;
+    replay_buf->code[i]     = code;
+    replay_buf->delta_ns[i] = delta_ns;
+}
+
+// ==============================================
+void    run_replay(const char *path) {
+// ==============================================
+    // One edge per recorded write. An edge is queued once the
+    // next write is read, since its delta_ns is the time until
+    // that write.
+    struct pulse_trace_reader rd;
+    struct pulse_trace_event ev;
+    struct pin_map rec_map;
+    unsigned char xlat[256], code_of[256], byte = 0, code = 0;
+    uint64_t t_first = 0, t_last = 0, s_prev = 0, s_now, gap, t_start, missed_at;
+    uint64_t writes = 0, marks = 0, moves = 0;
+    unsigned c;
+    int r, pending = 0;
+
+    printf("\n");
+    DTStamp(); printf("EXECUTING  run_replay(%s).\n", path);
+    if (pulse_trace_open(&rd, path) != 0) {
+        DTStamp(); printf("ERROR  : Open trace file %s \t= %s\n", path,
+            errno == EPROTO ? "not a pulse trace of this version" : strerror(errno));
+        return;
+    }
+    DTStamp(); printf("SUCCESS: Display trace backend/period \t= %s / %u (ns)\n", rd.hdr.backend, rd.hdr.period_ns);
+    DTStamp(); printf("SUCCESS: Display trace writes/markers/dropped \t= %llu / %llu / %llu%s\n",
+        (unsigned long long)rd.hdr.writes, (unsigned long long)rd.hdr.marks, (unsigned long long)rd.hdr.dropped,
+        rd.hdr.complete ? "" : " (not closed, read to the last flush)");
+
+    // Recorded byte -> our byte, and -> logical code for the
+    // step counts and switch checks (lowest code on a tie, as
+    // an axis the trace did not wire never stepped)
+    pulse_trace_pin_map(&rd.hdr, &rec_map);
+    if (pin_map_translate(&rec_map, &pin_map, xlat) != 0) {
+        DTStamp(); printf("ERROR  : Trace pin map \t= an axis wired here was not recorded, it stays still\n");
+    }
+    memset(code_of, 0, sizeof(code_of));
+    for (c = PIN_MAP_CODES; c-- > 0; )
+        code_of[rec_map.lut[c]] = (unsigned char)c;
+
+    missed_at     = atomic_load_explicit(&step_tl.missed, memory_order_relaxed);
+    replay_starts = 1;
+    t_start       = monotonic_ns();
+    while ((r = pulse_trace_next(&rd, &ev)) > 0) {
+        if (ev.mark != 0) {
+            marks++;
+            moves += ev.mark == PULSE_TRACE_MARK_MOVE;
+            continue;
+        }
+        if (atomic_load_explicit(&step_state.fault, memory_order_acquire))
+            break;
+        if (!pending)
+            t_first = ev.t_ns;
+        s_now = (uint64_t)llround((double)(ev.t_ns - t_first) * replay_scale);
+        if (pending) {
+            // Long gaps: hold the pins with repeats of a no-step code
+            for (gap = s_now - s_prev; gap > REPLAY_MAX_GAP_NS; gap -= REPLAY_MAX_GAP_NS) {
+                replay_edge(byte, code, REPLAY_MAX_GAP_NS);
+                code &= ~STEP_STEP_BITS;
+            }
+            replay_edge(byte, code, (uint32_t)gap);
+        }
+        byte    = xlat[ev.byte];
+        code    = code_of[ev.byte];
+        s_prev  = s_now;
+        t_last  = ev.t_ns;
+        pending = 1;
+        writes++;
+    }
+    if (pending)
+        replay_edge(byte, code, 0);
+    replay_flush();
+    pulse_trace_close_reader(&rd);
+    if (r < 0) {
+        DTStamp(); printf("ERROR  : Trace read error or cut-off record after %llu writes\n", (unsigned long long)writes);
+    }
+
+    motion_submit(MOTION_CMD_RESET, 0, 0, 0, 0);
+    motion_wait_idle();
+    if (limit_fault_service()) {
+        DTStamp(); printf("ERROR  : Replay stopped by the %c-axis limit switch\n", AXIS_NAME(step_state.fault_axis));
+    }
+    DTStamp(); printf("SUCCESS: Display replayed writes/markers/moves \t= %llu / %llu / %llu\n",
+        (unsigned long long)writes, (unsigned long long)marks, (unsigned long long)moves);
+    DTStamp(); printf("SUCCESS: Display trace/replay time \t= %.3f / %.3f (s, scale %.2f, with the reset)\n",
+        (t_last - t_first) / 1e9, (monotonic_ns() - t_start) / 1e9, replay_scale);
+    DTStamp(); printf("SUCCESS: Display replay missed edges \t= %llu\n",
+        (unsigned long long)(atomic_load_explicit(&step_tl.missed, memory_order_relaxed) - missed_at));
+    DTStamp(); printf("SUCCESS: Display position X/Y/Z/A \t= %lld / %lld / %lld / %lld (steps)\n",
+        (long long)step_position(&step_state, AXIS_X), (long long)step_position(&step_state, AXIS_Y),
+        (long long)step_position(&step_state, AXIS_Z), (long long)step_position(&step_state, AXIS_A));
+    DTStamp(); printf("COMPLETED run_replay(%s).\n", path);
+}
+
+// ==================================================================
+// SHARED-MEMORY COMMAND/STATUS INTERFACE
+// ==================================================================
+void    init_shm(void) {
+    if (shm_name == NULL)
+        return;
+    if (cnc_shm_create(&shm, shm_name) != 0) {
+        DTStamp(); printf("ERROR  : Create shared memory %s \t= %s\n", shm_name, strerror(errno));
+        exit(1);
+    }
+    shm_publish_status(1);
+    DTStamp(); printf("SUCCESS: Display shared memory segment \t= /dev/shm%s (%zu bytes, version %d)\n",
+        shm_name, sizeof(struct cnc_shm), CNC_SHM_VERSION);
+}
+
+// ==============================================
+void    close_shm(void) {
+// ==============================================
+    if (shm == NULL)
+        return;
+    cnc_shm_destroy(shm, shm_name);
+    shm = NULL;
+    DTStamp(); printf("SUCCESS: Display shared memory commands carried out \t= %llu\n",
+        (unsigned long long)shm_cmds);
+}
+
+// ==============================================
+void    shm_publish_status(int force) {
+// ==============================================
+    // Keyboard thread: rewrite the status block if it is due
+    struct cnc_shm_status st;
+    uint64_t now;
+    int64_t sum_late_ns;
+    double dt;
+    int axis;
+
+    if (shm == NULL)
+        return;
+    now = monotonic_ns();
+    if (!force && now - shm_status_ns < CNC_SHM_STATUS_NS)
+        return;
+
+    memset(&st, 0, sizeof(st));
+    st.t_ns = now;
+    // Velocity over at least one status period, however often forced
+    dt = (now - shm_vel_ns) / 1e9;
+    for (axis = 0; axis < NUM_AXES; axis++) {
+        st.position[axis] = step_position(&step_state, axis);
+        if (now - shm_vel_ns >= CNC_SHM_STATUS_NS) {
+            shm_vel[axis]     = shm_vel_ns ? (st.position[axis] - shm_vel_pos[axis]) / dt : 0.0;
+            shm_vel_pos[axis] = st.position[axis];
+        }
+        st.velocity[axis] = shm_vel[axis];
+        if (atomic_load_explicit(&step_state.homed[axis], memory_order_acquire))
+            st.homed |= 1u << axis;
+    }
+    st.fault_axis     = atomic_load_explicit(&step_state.fault, memory_order_acquire) ? step_state.fault_axis : -1;
+    st.data_byte      = atomic_load_explicit(&port.data_shadow, memory_order_relaxed);
+    st.status_byte    = atomic_load_explicit(&port.status_shadow, memory_order_relaxed);
+    st.jog_active     = jog_active;
+    st.jog_continuous = jog_continuous;
+    st.queue_depth    = motion_queue_depth(&motion_q);
+    // Timeline statistics are written by the stepping thread:
+    // one relaxed load each, the mean from the loaded pair
+    st.edges          = atomic_load_explicit(&step_tl.edges, memory_order_relaxed);
+    st.missed         = atomic_load_explicit(&step_tl.missed, memory_order_relaxed);
+    st.max_late_ns    = atomic_load_explicit(&step_tl.max_late_ns, memory_order_relaxed);
+    sum_late_ns       = atomic_load_explicit(&step_tl.sum_late_ns, memory_order_relaxed);
+    st.mean_late_ns   = st.edges ? (double)sum_late_ns / st.edges : 0.0;
+    cnc_shm_status_write(shm, &st);
+    shm_status_ns = now;
+    if (now - shm_vel_ns >= CNC_SHM_STATUS_NS)
+        shm_vel_ns = now;
+}
+
+// ==============================================
+void    shm_poll_commands(void) {
+// ==============================================
+    // Keyboard thread: carry out what other processes queued
+    struct cnc_shm_cmd cmd;
+    int dir[NUM_AXES];
+
+    if (shm == NULL)
+        return;
+    while (cnc_shm_cmd_pop(shm, &cmd)) {
+        switch (cmd.type) {
+
+        case CNC_SHM_CMD_KEY:
+            cmd_interpreter(cmd.arg[0]);
+            break;
+
+        case CNC_SHM_CMD_JOG:
+            // Continuous whatever the mode; repeat it within the hold timeout
+            if (jog_key_direction(cmd.arg[0], dir))
+                jog_press(cmd.arg[0]);
+            break;
+
+        case CNC_SHM_CMD_STOP:
+            jog_stop_and_wait();
+            break;
+
+        case CNC_SHM_CMD_MOVE:
+            jog_stop_and_wait();
+            missed_at_cmd = atomic_load_explicit(&step_tl.missed, memory_order_relaxed);
+            event_log_write(&event_log, EV_SHM_MOVE, cmd.arg[0], cmd.arg[1], cmd.arg[2], cmd.arg[3]);
+            drive_axes(cmd.arg[0], cmd.arg[1], cmd.arg[2], cmd.arg[3]);
+            report_done();
+            break;
+        }
+        shm_cmds++;
+        cnc_shm_cmd_done(shm, cmd.seq);
+        shm_publish_status(1);
+    }
+}
+
+// ==================================================================
+// EDGE WAITING: SLEEP OR SLEEP-THEN-SPIN
+// ==================================================================
+void    init_edge_timing(void) {
+    // Runs before the stepping thread starts
+    step_tl.mode      = timing_mode;
+    step_tl.margin_ns = spin_margin_ns;
+    if (timing_mode != STEP_WAIT_HYBRID && timing_bench_rate == 0)
+        return;
+    if (tsc_clock_calibrate(&tsc_clock, TSC_CALIBRATE_NS) == 0) {
+        step_tl.tsc = &tsc_clock;
+        DTStamp(); printf("SUCCESS: Display spin clock \t= TSC, %.3f ticks/ns\n", tsc_clock.ticks_per_ns);
+    } else {
+        DTStamp(); printf("SUCCESS: Display spin clock \t= clock_gettime() (no invariant TSC)\n");
+    }
+    if (timing_mode == STEP_WAIT_HYBRID) {
+        DTStamp(); printf("SUCCESS: Display edge timing \t= sleep, then spin (margin from %lld ns)\n",
+            (long long)spin_margin_ns);
+    }
+}
+
+// ==============================================
+void    run_timing_benchmark(uint32_t rate) {
+// ==============================================
+    // The same constant-rate X move timed by sleeping and by
+    // sleep-then-spin: CPU per edge and edge lateness side by side
+    static const char *mode_name[2] = { "sleep", "hybrid" };
+    static struct latency_hist hist[2];
+    struct latency_summary ls[2];
+    struct pulse_compiler pc;
+    struct plan_profile plan;
+    int32_t delta[NUM_AXES] = { 0, 0, 0, 0 };
+    uint64_t cpu[2], edges[2], missed[2], spin[2], cpu0, edges0, missed0, spin0;
+    int mode, saved_fifo = fifo_mode, saved_mode = step_tl.mode;
+
+    DTStamp(); printf("EXECUTING  run_timing_benchmark(%u).\n", rate);
+    memset(&plan, 0, sizeof(plan));
+    plan.entry_rate = plan.cruise_rate = plan.exit_rate = plan.floor_rate = rate;
+    plan.accel = HUGE_VAL;
+    fifo_mode = 0;
+
+    for (mode = 0; mode < 2; mode++) {
+        // The stepping thread is idle here, so it is safe to switch
+        latency_hist_init(&hist[mode]);
+        step_tl.hist = &hist[mode];
+        step_tl.mode = mode == 0 ? STEP_WAIT_SLEEP : STEP_WAIT_HYBRID;
+        delta[AXIS_X] = mode == 0 ? TIMING_BENCH_STEPS : -TIMING_BENCH_STEPS;
+        cpu0    = play_cpu_ns[0];
+        edges0  = play_edges[0];
+        missed0 = atomic_load_explicit(&step_tl.missed, memory_order_relaxed);
+        spin0   = step_tl.spin_ns;
+
+        pulse_compile_begin(&pc, delta, NULL, period_ns, PULSE_RESET_EDGES, &pin_map);
+        pc.plan = &plan;
+        motion_submit_compiled(&pc, 1);
+        motion_submit(MOTION_CMD_RESET, 0, 0, 0, 0);
+        motion_wait_idle();
+
+        cpu[mode]    = play_cpu_ns[0] - cpu0;
+        edges[mode]  = play_edges[0] - edges0;
+        missed[mode] = atomic_load_explicit(&step_tl.missed, memory_order_relaxed) - missed0;
+        spin[mode]   = step_tl.spin_ns - spin0;
+        latency_hist_summary(&hist[mode], &ls[mode]);
+    }
+    step_tl.hist = &edge_hist;
+    step_tl.mode = saved_mode;
+    fifo_mode    = saved_fifo;
+
+    DTStamp(); printf("SUCCESS: Display step rate/period \t= %u steps/s / %.1f (us)\n", rate, 1e6 / rate);
+    DTStamp(); printf("SUCCESS: Display mode \t\t\t=   %12s %12s\n", mode_name[0], mode_name[1]);
+    DTStamp(); printf("SUCCESS: Display CPU per edge (ns) \t=   %12.0f %12.0f\n",
+        (double)cpu[0] / edges[0], (double)cpu[1] / edges[1]);
+    DTStamp(); printf("SUCCESS: Display spin per edge (ns) \t=   %12.0f %12.0f\n",
+        (double)spin[0] / edges[0], (double)spin[1] / edges[1]);
+    DTStamp(); printf("SUCCESS: Display lateness mean (ns) \t=   %12.0f %12.0f\n", ls[0].mean_ns, ls[1].mean_ns);
+    DTStamp(); printf("SUCCESS: Display lateness p99.9 (ns) \t=   %12llu %12llu\n",
+        (unsigned long long)ls[0].p999_ns, (unsigned long long)ls[1].p999_ns);
+    DTStamp(); printf("SUCCESS: Display lateness max (ns) \t=   %12llu %12llu\n",
+        (unsigned long long)ls[0].max_ns, (unsigned long long)ls[1].max_ns);
+    DTStamp(); printf("SUCCESS: Display missed deadlines \t=   %12llu %12llu\n",
+        (unsigned long long)missed[0], (unsigned long long)missed[1]);
+    DTStamp(); printf("SUCCESS: Display spin margin after hybrid run \t= %.1f (us)\n", step_tl.margin_ns / 1000.0);
+    DTStamp(); printf("COMPLETED run_timing_benchmark(%u).\n", rate);
+}
+
+// ==================================================================
+// TWO-RATE BASE/SERVO SCHEDULING
+// ==================================================================
+void    start_servo_thread(void) {
+    // Same CPUMAP, one priority below the base (stepping) thread
+    int prio = rt_priority > 1 ? rt_priority - 1 : 1;
+    int err;
+
+    err = two_rate_start_servo(&two_rate, prio, rt_cpumap);
+    if (err != 0) {
+        DTStamp(); printf("ERROR  : Create servo thread \t= %s\n", strerror(err));
+        exit(1);
+    }
+    if (two_rate.servo_rt.sched_err != 0) {
+        DTStamp(); printf("ERROR  : Set servo thread SCHED_FIFO priority %d \t= %s\n", prio,
+            strerror(two_rate.servo_rt.sched_err));
+    } else {
+        DTStamp(); printf("SUCCESS: Set servo thread SCHED_FIFO priority \t= %d\n", prio);
+    }
+    DTStamp(); printf("SUCCESS: Display base/servo period \t= %ld / %ld (ns), max %.0f steps/s\n",
+        two_rate.base_period_ns, two_rate.servo_period_ns, two_rate.max_rate);
+}
+
+// ==============================================
+void    report_two_rate(void) {
+// ==============================================
+    const struct exec_stats *es[2] = { &two_rate.base_stats, &two_rate.servo_stats };
+    const long period[2] = { two_rate.base_period_ns, two_rate.servo_period_ns };
+    static const char *name[2] = { "base", "servo" };
+    int t;
+
+    if (!two_rate_mode)
+        return;
+    for (t = 0; t < 2; t++) {
+        if (es[t]->cycles == 0)
+            continue;
+        DTStamp(); printf("SUCCESS: Display %s cycle min/mean/max \t= %llu / %.0f / %llu (ns, max %.2f%% of %ld ns, %llu cycles)\n",
+            name[t], (unsigned long long)es[t]->min_ns, exec_stats_mean(es[t]), (unsigned long long)es[t]->max_ns,
+            100.0 * es[t]->max_ns / period[t], period[t], (unsigned long long)es[t]->cycles);
+    }
+    DTStamp(); printf("SUCCESS: Display servo missed deadlines \t= %llu\n",
+        (unsigned long long)two_rate.servo_tl.missed);
+    DTStamp(); printf("SUCCESS: Display base/servo hand-off reads retried \t= %llu / %llu (rate / jog)\n",
+        (unsigned long long)two_rate.cmd.retries, (unsigned long long)two_rate.setup.retries);
+}
+
+// ==================================================================
+// POSITION, LIMIT SWITCHES AND HOMING
+// ==================================================================
+void    init_step_state(void) {
+    int axis;
+
+    step_state_init(&step_state, &pin_map);
+    for (axis = 0; axis < NUM_AXES; axis++) {
+        step_state.soft_min[axis] = soft_min[axis];
+        step_state.soft_max[axis] = soft_max[axis];
+        if (pin_map.axis[axis].home_pin != 0) {
+            DTStamp(); printf("SUCCESS: Display %c-axis home switch pin \t= %d%s\n", AXIS_NAME(axis),
+                pin_map.axis[axis].home_pin, pin_map.axis[axis].home_invert ? " (active high)" : "");
+        }
+    }
+    if (port_kind == PARPORT_BACKEND_SIM && sim_home_steps > 0) {
+        // Switches close sim_home_steps below the start point
+        DTStamp(); printf("SUCCESS: Display simulated home switches \t= %d (steps below the start point)\n",
+            sim_home_steps);
+        port.sim_status_fn  = sim_home_switches;
+        port.sim_status_arg = &step_state;
+    }
+}
+
+// ==============================================
+unsigned char sim_home_switches(void *arg) {
+// ==============================================
+    // Simulated port STATUS_REG (stepping thread)
+    struct step_state *st = arg;
+    unsigned active = 0;
+    int axis;
+
+    for (axis = 0; axis < NUM_AXES; axis++)
+        if (atomic_load_explicit(&st->raw[axis], memory_order_relaxed) <= -sim_home_steps)
+            active |= 1u << axis;
+    return pin_map_status(st->map, active);
+}
+
+// ==============================================
+void    home_all_axes(void) {
+// ==============================================
+    // Z first so the tool is clear of the work before X/Y move,
+    // A (if it has a switch) last
+    static const int order[NUM_AXES] = { AXIS_Z, AXIS_X, AXIS_Y, AXIS_A };
+    int i, axis;
+
+    if (port_kind == PARPORT_BACKEND_SIM && sim_home_steps == 0) {
+        DTStamp(); printf("ERROR  : Simulated port has no home switches (run with --sim-home[=STEPS])\n");
+        return;
+    }
+    for (i = 0; i < NUM_AXES; i++) {
+        axis = order[i];
+        if (pin_map.axis[axis].home_pin == 0)
+            continue;
+        missed_at_cmd = atomic_load_explicit(&step_tl.missed, memory_order_relaxed);
+        event_log_write(&event_log, EV_HOME_BEGIN, axis, 0, 0, 0);
+        motion_submit(MOTION_CMD_HOME, axis, 0, 0, 0);
+        motion_wait_idle();
+        event_log_write(&event_log, EV_HOME_DONE, axis, home_result[axis],
+            step_state.origin[axis],
+            (int64_t)(atomic_load_explicit(&step_tl.missed, memory_order_relaxed) - missed_at_cmd));
+        if (home_result[axis] != HOME_OK)
+            break;
+    }
+}
+
+// ==============================================
+int     limit_fault_service(void) {
+// ==============================================
+    // Keyboard thread, machine idle: acknowledge a limit trip
+    // so moves are accepted again. Returns 1 if there was one.
+    if (!atomic_load_explicit(&step_state.fault, memory_order_acquire))
+        return 0;
+    atomic_store_explicit(&step_state.fault, 0, memory_order_release);
+    return 1;
+}
+
+// ==============================================
+void    clip_to_soft_limits(int32_t delta[NUM_AXES]) {
+// ==============================================
+    int64_t pos, target;
+    int axis;
+
+    for (axis = 0; axis < NUM_AXES; axis++) {
+        pos    = step_position(&step_state, axis);
+        target = pos + delta[axis];
+        if (target > step_state.soft_max[axis])
+            target = pos > step_state.soft_max[axis] ? pos : step_state.soft_max[axis];
+        if (target < step_state.soft_min[axis])
+            target = pos < step_state.soft_min[axis] ? pos : step_state.soft_min[axis];
+        if (target - pos != delta[axis]) {
+            event_log_write(&event_log, EV_SOFT_LIMIT, axis, delta[axis], target - pos, 0);
+            delta[axis] = (int32_t)(target - pos);
+        }
+    }
+}
+
+// ==============================================
+static int gcode_point_outside(const int64_t base[NUM_AXES], int axis, double mm) {
+// ==============================================
+    int64_t pos = base[axis] + llround(mm * steps_per_mm[axis]) * gcode_axis_sign[axis];
+    return pos < step_state.soft_min[axis] || pos > step_state.soft_max[axis];
+}
+
+// ==============================================
+int     gcode_move_outside_limits(const struct gcode_move *move, const int64_t base[NUM_AXES]) {
+// ==============================================
+    // First axis the move would take past a soft limit, or -1.
+    // The start point was checked as the previous target; an arc
+    // also reaches its centre +/- radius on every axis crossing
+    // inside its sweep.
+    double r, a0, a, sweep, x0, y0, x1, y1, extreme[2];
+    int axis, q;
+
+    for (axis = 0; axis < NUM_AXES; axis++)
+        if (gcode_point_outside(base, axis, move->target_mm[axis]))
+            return axis;
+    if (!move->arc)
+        return -1;
+
+    x0 = move->start_mm[AXIS_X] - move->center_mm[AXIS_X];
+    y0 = move->start_mm[AXIS_Y] - move->center_mm[AXIS_Y];
+    x1 = move->target_mm[AXIS_X] - move->center_mm[AXIS_X];
+    y1 = move->target_mm[AXIS_Y] - move->center_mm[AXIS_Y];
+    r  = hypot(x0, y0);
+    a0 = atan2(y0, x0);
+    sweep = atan2(y1, x1) - a0;
+    if (move->arc == 2)
+        sweep = -sweep;
+    if (sweep <= 1e-9)
+        sweep += 2.0 * M_PI;
+
+    for (q = 0; q < 4; q++) {
+        // Quadrant point q at angle q * 90 degrees
+        a = q * M_PI / 2.0 - a0;
+        if (move->arc == 2)
+            a = -a;
+        a = fmod(a + 4.0 * M_PI, 2.0 * M_PI);
+        if (a > sweep)
+            continue;
+        extreme[AXIS_X] = move->center_mm[AXIS_X] + (q == 0 ? r : q == 2 ? -r : 0.0);
+        extreme[AXIS_Y] = move->center_mm[AXIS_Y] + (q == 1 ? r : q == 3 ? -r : 0.0);
+        for (axis = AXIS_X; axis <= AXIS_Y; axis++)
+            if (gcode_point_outside(base, axis, extreme[axis]))
+                return axis;
+    }
+    return -1;
+}
+
+// ==================================================================
+// CONTINUOUS (HOLD-TO-MOVE) JOG
+// ==================================================================
+int     jog_key_direction(int key, int dir[NUM_AXES]) {
+    // Map a direction key to per-axis directions (+1 = CW)
+    dir[AXIS_X] = dir[AXIS_Y] = dir[AXIS_Z] = dir[AXIS_A] = 0;
+    switch (key) {
+        case 'r': dir[AXIS_X] = +1; return 1;
+        case 'l': dir[AXIS_X] = -1; return 1;
+        case 'f': dir[AXIS_Y] = +1; return 1;
+        case 'b': dir[AXIS_Y] = -1; return 1;
+        case 'd': dir[AXIS_Z] = +1; return 1;
+        case 'u': dir[AXIS_Z] = -1; return 1;
+        case 'a': dir[AXIS_A] = +1; return pin_map_wired(&pin_map, AXIS_A);
+        case 's': dir[AXIS_A] = -1; return pin_map_wired(&pin_map, AXIS_A);
+    }
+    return 0;
+}
+
+// ==============================================
+void    jog_press(int key) {
+// ==============================================
+    int dir[NUM_AXES];
+
+    jog_last_key_ns = monotonic_ns();
+    if (jog_active && key == jog_key) {
+        // Auto-repeat of the held key; if the hold timed out
+        // meanwhile, take the release back
+        if (jog_stop_sent) {
+            jog_stop_sent = 0;
+            atomic_store_explicit(&jog.release_ns, 0, memory_order_release);
+        }
+        return;
+    }
+
+    if (jog_active)
+        jog_stop_and_wait();        // Direction change: stop first
+
+    jog_key       = key;
+    jog_active    = 1;
+    jog_stop_sent = 0;
+    atomic_store_explicit(&jog.release_ns, 0, memory_order_release);
+    missed_at_cmd = atomic_load_explicit(&step_tl.missed, memory_order_relaxed);
+    jog_key_direction(key, dir);
+    event_log_write(&event_log, EV_JOG_BEGIN, key, hold_timeout_ms > 0, 0, 0);
+    motion_submit(MOTION_CMD_JOG, dir[AXIS_X], dir[AXIS_Y], dir[AXIS_Z], dir[AXIS_A]);
+}
+
+// ==============================================
+void    jog_request_stop(void) {
+// ==============================================
+    // Decelerate until stopped, or until a repeat of the key
+    if (jog_active && !jog_stop_sent) {
+        jog_stop_sent = 1;
+        atomic_store_explicit(&jog.release_ns, monotonic_ns(), memory_order_release);
+    }
+}
+
+// ==============================================
+void    jog_stop_and_wait(void) {
+// ==============================================
+    if (!jog_active)
+        return;
+    jog_request_stop();
+    motion_wait_idle();
+    jog_service();
+}
+
+// ==============================================
+void    jog_service(void) {
+// ==============================================
+    // Called from the keyboard loop: enforce the hold timeout
+    // and report a finished jog.
+    if (!jog_active)
+        return;
+
+    if (hold_timeout_ms > 0
+        && monotonic_ns() - jog_last_key_ns > (uint64_t)hold_timeout_ms * 1000000)
+        jog_request_stop();
+
+    if (!motion_queue_idle(&motion_q))
+        return;
+
+    jog_active = 0;
+    if (limit_fault_service())
+        event_log_write(&event_log, EV_LIMIT_TRIP, step_state.fault_axis,
+            step_position(&step_state, step_state.fault_axis), 0, 0);
+    if (jog.last_pulse_ns > jog.stop_request_ns && jog.stop_request_ns != 0) {
+        event_log_write(&event_log, EV_JOG_DONE, (int64_t)jog.steps,
+            (int64_t)(jog.decel_start_ns - jog.stop_request_ns),
+            (int64_t)(jog.last_pulse_ns - jog.stop_request_ns),
+            (int64_t)(atomic_load_explicit(&step_tl.missed, memory_order_relaxed) - missed_at_cmd));
+    } else {
+        event_log_write(&event_log, EV_JOG_DONE, (int64_t)jog.steps, 0, -1,
+            (int64_t)(atomic_load_explicit(&step_tl.missed, memory_order_relaxed) - missed_at_cmd));
+    }
+}
+
+// ========================================================
+int     parse_axis_values(const char *text, uint32_t values[NUM_AXES]) {
+// ========================================================
+    // "N" sets every axis, "X,Y,Z,A" sets each axis and
+    // "X,Y,Z" all but A. Returns the number of axes set, or -1.
+    char *end;
+    int axis;
+    for (axis = 0; axis < NUM_AXES; axis++) {
+        values[axis] = strtoul(text, &end, 0);
+        if (end == text)
+            return -1;
+        if (*end == '\0') {
+            if (axis == 0) {
+                for (axis = 1; axis < NUM_AXES; axis++)
+                    values[axis] = values[AXIS_X];
+                return NUM_AXES;
+            }
+            return axis == AXIS_Z || axis == NUM_AXES - 1 ? axis + 1 : -1;
+        }
+        if (*end != ',')
+            return -1;
+        text = end + 1;
+    }
+    return -1;
+}
+
+// ========================================================
+int     parse_axis_steps(const char *text, int64_t values[NUM_AXES]) {
+// ========================================================
+    // Signed step counts, "N", "X,Y,Z,A" or "X,Y,Z" as above
+    char *end;
+    int axis;
+    for (axis = 0; axis < NUM_AXES; axis++) {
+        values[axis] = strtoll(text, &end, 0);
+        if (end == text)
+            return -1;
+        if (*end == '\0') {
+            if (axis == 0) {
+                for (axis = 1; axis < NUM_AXES; axis++)
+                    values[axis] = values[AXIS_X];
+                return NUM_AXES;
+            }
+            return axis == AXIS_Z || axis == NUM_AXES - 1 ? axis + 1 : -1;
+        }
+        if (*end != ',')
+            return -1;
+        text = end + 1;
+    }
+    return -1;
+}
+
+// ========================================================
+void    build_profiles(void) {
+// ========================================================
+    int axis;
+
+    printf("\n");
+    DTStamp(); printf("EXECUTING  build_profiles(void).\n");
+    for (axis = 0; axis < NUM_AXES; axis++) {
+        if (machine_max_rate[axis] != 0 && axis_limits[axis].max_rate > machine_max_rate[axis]) {
+            DTStamp(); printf("SUCCESS: Display %c-axis max rate \t= %u steps/s, limit of %s (asked for %u)\n",
+                AXIS_NAME(axis), machine_max_rate[axis], machine_config_file, axis_limits[axis].max_rate);
+            axis_limits[axis].max_rate = machine_max_rate[axis];
+        }
+        if (axis_limits[axis].start_rate > axis_limits[axis].max_rate) {
+            // Also the homing approach rate
+            DTStamp(); printf("SUCCESS: Display %c-axis start rate \t= %u steps/s, the max rate (asked for %u)\n",
+                AXIS_NAME(axis), axis_limits[axis].max_rate, axis_limits[axis].start_rate);
+            axis_limits[axis].start_rate = axis_limits[axis].max_rate;
+        }
+        if (profile_build_ramp(&axis_ramp[axis], &axis_limits[axis]) < 0) {
+            DTStamp(); printf("ERROR  : Invalid %c-axis limits (rates must be > 0)\n", AXIS_NAME(axis));
+            exit(1);
+        }
+        DTStamp(); printf("SUCCESS: Display %c-axis %s \t= %u -> %u steps/s, accel %u, ramp %u steps\n",
+            AXIS_NAME(axis), axis_limits[axis].jerk ? "S-curve" : "trapezoid",
+            axis_limits[axis].start_rate, axis_limits[axis].max_rate,
+            axis_limits[axis].accel, axis_ramp[axis].n);
+    }
+    DTStamp(); printf("COMPLETED build_profiles(void).\n");
+}
+
+// ========================================================
+void    start_realtime(void) {
+// ========================================================
+    int err;
+
+    printf("\n");
+    DTStamp(); printf("EXECUTING  start_realtime(void).\n");
+
+    // STEP (a) lock all memory (current and future pages)
+    err = rt_lock_memory();
+    if (err != 0) {
+        DTStamp(); printf("ERROR  : Lock memory mlockall(MCL_CURRENT|MCL_FUTURE) \t= %s\n", strerror(err));
+    } else {
+        DTStamp(); printf("SUCCESS: Lock memory mlockall(MCL_CURRENT|MCL_FUTURE)\n");
+    }
+
+    // STEP (b) start the stepping thread (affinity, SCHED_FIFO, stack)
+    motion_queue_init(&motion_q);
+    pulse_pool_init(&pulse_pool);
+    latency_hist_init(&edge_hist);
+    step_timeline_init(&step_tl, period_ns);
+    step_tl.hist = &edge_hist;
+    init_edge_timing();
+    two_rate_init(&two_rate, base_period_ns, tick_time_ns);
+    err = rt_thread_start(&step_rt, rt_priority, rt_cpumap, step_thread_main, NULL);
+    if (err != 0) {
+        DTStamp(); printf("ERROR  : Create stepping thread \t= %s\n", strerror(err));
+        exit(1);
+    }
+
+    if (step_rt.affinity_err != 0) {
+        DTStamp(); printf("ERROR  : Pin stepping thread to CPUMAP 0x%02lX \t= %s\n", rt_cpumap, strerror(step_rt.affinity_err));
+    } else if (rt_cpumap == 0) {
+        DTStamp(); printf("SUCCESS: Stepping thread not pinned (CPUMAP = 0)\n");
+    } else {
+        DTStamp(); printf("SUCCESS: Pin stepping thread to CPUMAP 0x%02lX (%s)\n", rt_cpumap,
+            step_rt.cpus_isolated ? "isolcpus" : "NOT isolated, see isolcpus=");
+    }
+
+    if (step_rt.sched_err != 0) {
+        DTStamp(); printf("ERROR  : Set SCHED_FIFO priority %d \t= %s\n", rt_priority, strerror(step_rt.sched_err));
+    } else {
+        DTStamp(); printf("SUCCESS: Set SCHED_FIFO priority \t= %d\n", rt_priority);
+    }
+
+    DTStamp(); printf("SUCCESS: Prefault stepping thread stack \t= %d bytes\n", RT_STACK_PREFAULT);
+    if (two_rate_mode)
+        start_servo_thread();
+    DTStamp(); printf("COMPLETED start_realtime(void).\n");
+}
+
+// ==============================================
+void    load_pin_map(void) {
+// ==============================================
+    char err[256];
+    int axis;
+
+    pin_map_default(&pin_map);
+    if (pin_map_file != NULL) {
+        if (pin_map_load(&pin_map, pin_map_file, err, sizeof(err)) != 0) {
+            DTStamp(); printf("ERROR  : Load pin map \t= %s\n", err);
+            exit(1);
+        }
+        DTStamp(); printf("SUCCESS: Display pin map file \t= %s\n", pin_map_file);
+    }
+    for (axis = 0; axis < NUM_AXES; axis++) {
+        if (!pin_map_wired(&pin_map, axis)) {
+            DTStamp(); printf("SUCCESS: Display %c-axis step/dir pins \t= not wired\n", AXIS_NAME(axis));
+            continue;
+        }
+        DTStamp(); printf("SUCCESS: Display %c-axis step/dir pins \t= %d%s / %d%s\n", AXIS_NAME(axis),
+            pin_map.axis[axis].step_pin, pin_map.axis[axis].step_invert ? " (active low)" : "",
+            pin_map.axis[axis].dir_pin, pin_map.axis[axis].dir_invert ? " (inverted)" : "");
+    }
+    build_cmd_descriptions();
+}
+
+// ==============================================
+void    load_machine_config(void) {
+// ==============================================
+    // Before the other options, so they can override the file.
+    // A missing default file means the host was never calibrated.
+    struct machine_config cfg;
+    char err[256];
+    int axis;
+
+    if (!machine_config_named && access(machine_config_file, F_OK) != 0)
+        return;
+    machine_config_default(&cfg, PERIOD, TICK_TIME, PROFILE_MAX_RATE);
+    if (machine_config_load(&cfg, machine_config_file, err, sizeof(err)) != 0) {
+        DTStamp(); printf("ERROR  : Load machine config \t= %s\n", err);
+        exit(1);
+    }
+    period_ns    = cfg.period_ns;
+    tick_time_ns = cfg.tick_ns;
+    for (axis = 0; axis < NUM_AXES; axis++) {
+        axis_limits[axis].max_rate = cfg.max_rate[axis];
+        machine_max_rate[axis]     = cfg.max_rate[axis];
+    }
+    machine_config_loaded = 1;
+}
+
+// ==============================================
+void    run_calibration(double seconds) {
+// ==============================================
+    // Latency test on the stepping thread's priority and CPUMAP,
+    // writing idle bytes only, then the derived limits to the file
+    static struct calib_run run;
+    struct machine_config cfg;
+    struct latency_summary ls;
+    uint64_t t_report;
+    int err, axis;
+
+    printf("\n");
+    DTStamp(); printf("EXECUTING  run_calibration(%.0f).\n", seconds);
+    err = rt_lock_memory();
+    if (err != 0) {
+        DTStamp(); printf("ERROR  : Lock memory mlockall(MCL_CURRENT|MCL_FUTURE) \t= %s\n", strerror(err));
+    }
+    err = calib_start(&run, &port, pin_map_byte(&pin_map, 0), seconds, rt_priority, rt_cpumap);
+    if (err != 0) {
+        DTStamp(); printf("ERROR  : Create calibration thread \t= %s\n", strerror(err));
+        exit(1);
+    }
+    if (run.rt.affinity_err != 0) {
+        DTStamp(); printf("ERROR  : Pin calibration thread to CPUMAP 0x%02lX \t= %s\n",
+            rt_cpumap, strerror(run.rt.affinity_err));
+    }
+    if (run.rt.sched_err != 0) {
+        DTStamp(); printf("ERROR  : Set calibration thread SCHED_FIFO priority %d \t= %s\n",
+            rt_priority, strerror(run.rt.sched_err));
+    }
+    if (run.rt.affinity_err != 0 || run.rt.sched_err != 0) {
+        DTStamp(); printf("ERROR  : Calibration thread not real-time \t= the result is pessimistic\n");
+    } else {
+        DTStamp(); printf("SUCCESS: Display calibration thread \t= SCHED_FIFO %d, CPUMAP 0x%02lX (%s)\n",
+            rt_priority, rt_cpumap, run.rt.cpus_isolated ? "isolcpus" : "NOT isolated, see isolcpus=");
+    }
+    DTStamp(); printf("SUCCESS: Display probe interval/duration \t= %d (ns) / %.0f (s), load the machine as in use\n",
+        CALIB_PROBE_NS, seconds);
+
+    // Progress every 10 s while the probe thread runs
+    t_report = monotonic_ns() + 10 * (uint64_t)NSEC_PER_SEC;
+    while (!atomic_load_explicit(&run.done, memory_order_acquire)) {
+        usleep(100000);
+        if (monotonic_ns() < t_report)
+            continue;
+        t_report += 10 * (uint64_t)NSEC_PER_SEC;
+        DTStamp(); printf("SUCCESS: Display wake-ups/worst lateness so far \t= %llu / %.1f (us)\n",
+            (unsigned long long)atomic_load(&run.probes), atomic_load(&run.hist.max_ns) / 1000.0);
+        fflush(stdout);
+    }
+    calib_wait(&run);
+
+    latency_hist_summary(&run.hist, &ls);
+    DTStamp(); printf("SUCCESS: Display wake-ups/missed \t= %llu / %llu\n",
+        (unsigned long long)ls.count, (unsigned long long)ls.overruns);
+    DTStamp(); printf("SUCCESS: Display lateness mean/p99.99/max \t= %.1f / %.1f / %.1f (us)\n",
+        ls.mean_ns / 1000.0, ls.p9999_ns / 1000.0, ls.max_ns / 1000.0);
+    DTStamp(); printf("SUCCESS: Display port write + read mean/max \t= %.0f / %llu (ns)\n",
+        ls.count ? (double)run.io_sum_ns / ls.count : 0.0, (unsigned long long)run.io_max_ns);
+    if (hist_file != NULL) {
+        FILE *fp = fopen(hist_file, "w");
+        if (fp != NULL) {
+            latency_hist_dump(&run.hist, fp);
+            fclose(fp);
+            DTStamp(); printf("SUCCESS: Write wake-up lateness histogram \t= %s\n", hist_file);
+        }
+    }
+
+    // Configured rates: only what --max-rate asked for, not the defaults
+    machine_config_default(&cfg, period_ns, tick_time_ns, 0);
+    for (axis = 0; axis < NUM_AXES && max_rate_given; axis++)
+        cfg.max_rate[axis] = axis_limits[axis].max_rate;
+    calib_derive(&run, &cfg);
+    DTStamp(); printf("SUCCESS: Display PERIOD/TICK_TIME \t= %ld / %ld (ns), was %d / %d\n",
+        cfg.period_ns, cfg.tick_ns, PERIOD, TICK_TIME);
+    for (axis = 0; axis < NUM_AXES; axis++) {
+        DTStamp(); printf("SUCCESS: Display %c-axis max rate \t= %u (steps/s)\n", AXIS_NAME(axis), cfg.max_rate[axis]);
+    }
+    if (machine_config_save(&cfg, machine_config_file, &run) != 0) {
+        DTStamp(); printf("ERROR  : Write machine config %s \t= %s\n", machine_config_file, strerror(errno));
+        exit(1);
+    }
+    DTStamp(); printf("SUCCESS: Write machine config \t= %s\n", machine_config_file);
+    DTStamp(); printf("COMPLETED run_calibration(%.0f).\n", seconds);
+}
+
+// ==================================================================
+// EXTRA PORTS
+// ==================================================================
+int     parse_extra_port(const char *spec) {
+    // "ADDR[:PINMAP]"; ADDR is a number, or a device file for ppdev
+    struct extra_port *ep;
+    char *copy, *colon, *end;
+
+    if (extra_ports >= PARPORT_MAX_FOLLOWERS)
+        return -1;
+    ep = &extra_port[extra_ports];
+    memset(ep, 0, sizeof(*ep));
+    ep->spec = spec;
+    copy = strdup(spec);
+    colon = strchr(copy, ':');
+    if (colon != NULL) {
+        *colon = '\0';
+        ep->pin_map_file = colon + 1;
+    }
+    if (copy[0] == '/') {
+        ep->device = copy;
+    } else {
+        ep->address = (int)strtol(copy, &end, 0);
+        if (end == copy || *end != '\0') {
+            free(copy);
+            return -1;
+        }
+    }
+    extra_ports++;
+    return 0;
+}
+
+// ==============================================
+void    open_extra_ports(void) {
+// ==============================================
+    // After load_pin_map() and before the stepping thread starts
+    struct extra_port *ep;
+    char err[256];
+    int k, axis;
+
+    for (k = 0; k < extra_ports; k++) {
+        ep = &extra_port[k];
+        if (ep->pin_map_file == NULL) {
+            ep->map = pin_map;
+        } else if (pin_map_load(&ep->map, ep->pin_map_file, err, sizeof(err)) != 0) {
+            DTStamp(); printf("ERROR  : Load port %d pin map \t= %s\n", k + 2, err);
+            exit(1);
+        }
+        if (pin_map_translate(&pin_map, &ep->map, ep->xlat) != 0) {
+            DTStamp(); printf("ERROR  : Port %d pin map \t= wires an axis the first port does not\n", k + 2);
+            exit(1);
+        }
+        if (port_kind == PARPORT_BACKEND_PPDEV ? ep->device == NULL : ep->device != NULL) {
+            DTStamp(); printf("ERROR  : Port %d \t= %s needs a %s\n", k + 2, ep->spec,
+                port_kind == PARPORT_BACKEND_PPDEV ? "device file (/dev/parportN)" : "port address");
+            exit(1);
+        }
+        if (parport_backend_open_device(&ep->port, port_kind, ep->address, ep->device) != 0
+            || parport_add_follower(&port, &ep->port, ep->xlat) != 0) {
+            DTStamp(); printf("ERROR  : Open port %d (%s) \t= %s\n", k + 2, ep->spec, strerror(errno));
+            exit(1);
+        }
+        parport_write(&ep->port, pin_map_byte(&ep->map, 0));
+        DTStamp(); printf("SUCCESS: Display port %d \t= %s %s, pin map %s\n", k + 2, port.name,
+            ep->device != NULL ? ep->device : ep->spec, ep->pin_map_file != NULL ? ep->pin_map_file : "of port 1");
+        for (axis = 0; axis < NUM_AXES; axis++) {
+            if (!pin_map_wired(&ep->map, axis))
+                continue;
+            DTStamp(); printf("SUCCESS: Display port %d %c-axis step/dir pins \t= %d%s / %d%s\n", k + 2, AXIS_NAME(axis),
+                ep->map.axis[axis].step_pin, ep->map.axis[axis].step_invert ? " (active low)" : "",
+                ep->map.axis[axis].dir_pin, ep->map.axis[axis].dir_invert ? " (inverted)" : "");
+        }
+    }
+}
+
+// ==============================================
+void    report_port_skew(void) {
+// ==============================================
+    const struct parport_skew *sk;
+    int k;
+
+    if (extra_ports == 0)
+        return;
+    printf("\n");
+    DTStamp(); printf("EXECUTING  report_port_skew(void).\n");
+    DTStamp(); printf("SUCCESS: Display fan-out writes \t= %u (every %d timed)\n",
+        port.fanout_writes, PARPORT_SKEW_EVERY);
+    for (k = 0; k < extra_ports; k++) {
+        sk = &port.skew[k];
+        DTStamp(); printf("SUCCESS: Display port 1 -> %d skew min/mean/max \t= %llu / %.0f / %llu (ns), %llu samples\n",
+            k + 2, (unsigned long long)sk->min_ns, sk->samples ? (double)sk->sum_ns / sk->samples : 0.0,
+            (unsigned long long)sk->max_ns, (unsigned long long)sk->samples);
+    }
+    DTStamp(); printf("COMPLETED report_port_skew(void).\n");
+}
+
+// ==================================================================    
+int main(int argc, char *argv[]) {
+// ==================================================================
+    int argi, axis, n;
+    uint32_t values[NUM_AXES];
+
+    for (axis = 0; axis < NUM_AXES; axis++) {
+        axis_limits[axis].start_rate = PROFILE_START_RATE;
+        axis_limits[axis].max_rate   = PROFILE_MAX_RATE;
+        axis_limits[axis].accel      = PROFILE_ACCEL;
+        axis_limits[axis].jerk       = PROFILE_JERK;
+    }
+
+    // MEASURED HOST LIMITS, before the options that override them
+    for (argi = 1; argi < argc; argi++) {
+        if (strncmp(argv[argi], "--machine-config=", 17) == 0) {
+            machine_config_file  = argv[argi] + 17;
+            machine_config_named = 1;
+        } else if (strcmp(argv[argi], "--calibrate") == 0) {
+            calibrate_s = CALIB_DEFAULT_S;
+        } else if (strncmp(argv[argi], "--calibrate=", 12) == 0) {
+            calibrate_s = atof(argv[argi] + 12);
+        }
+    }
+    if (calibrate_s == 0.0)
+        load_machine_config();
+
+    // COMMAND LINE OPTIONS
+    for (argi = 1; argi < argc; argi++) {
+        if (strncmp(argv[argi], "--backend=", 10) == 0) {
+            if (parport_backend_parse(argv[argi] + 10, &port_kind) != 0) {
+                printf("ERROR: Unknown backend %s (use outb, ppdev, devport or sim)\n", argv[argi] + 10);
+                exit(1);
+            }
+        } else if (strncmp(argv[argi], "--rt-priority=", 14) == 0) {
+            rt_priority = atoi(argv[argi] + 14);
+        } else if (strncmp(argv[argi], "--cpumap=", 9) == 0) {
+            rt_cpumap = strtoul(argv[argi] + 9, NULL, 0);
+        } else if (strncmp(argv[argi], "--start-rate=", 13) == 0 && (n = parse_axis_values(argv[argi] + 13, values)) > 0) {
+            for (axis = 0; axis < n; axis++) axis_limits[axis].start_rate = values[axis];
+        } else if (strncmp(argv[argi], "--max-rate=", 11) == 0 && (n = parse_axis_values(argv[argi] + 11, values)) > 0) {
+            for (axis = 0; axis < n; axis++) axis_limits[axis].max_rate = values[axis];
+            max_rate_given = 1;
+        } else if (strncmp(argv[argi], "--accel=", 8) == 0 && (n = parse_axis_values(argv[argi] + 8, values)) > 0) {
+            for (axis = 0; axis < n; axis++) axis_limits[axis].accel = values[axis];
+        } else if (strncmp(argv[argi], "--jerk=", 7) == 0 && (n = parse_axis_values(argv[argi] + 7, values)) > 0) {
+            for (axis = 0; axis < n; axis++) axis_limits[axis].jerk = values[axis];
+        } else if (strncmp(argv[argi], "--hold-timeout=", 15) == 0) {
+            hold_timeout_ms = atoi(argv[argi] + 15);
+        } else if (strncmp(argv[argi], "--input-latency=", 16) == 0) {
+            input_latency_samples = atoi(argv[argi] + 16);
+        } else if (strncmp(argv[argi], "--hist-file=", 12) == 0) {
+            hist_file = argv[argi] + 12;
+        } else if (strncmp(argv[argi], "--gcode=", 8) == 0) {
+            gcode_file = argv[argi] + 8;
+        } else if (strcmp(argv[argi], "--gcode-dry-run") == 0) {
+            gcode_dry_run = 1;
+        } else if (strncmp(argv[argi], "--pin-map=", 10) == 0) {
+            pin_map_file = argv[argi] + 10;
+        } else if (strncmp(argv[argi], "--extra-port=", 13) == 0 && parse_extra_port(argv[argi] + 13) == 0) {
+            // Parsed into extra_port[]
+        } else if (strncmp(argv[argi], "--soft-min=", 11) == 0 && parse_axis_steps(argv[argi] + 11, soft_min) > 0) {
+            // Parsed into soft_min[]
+        } else if (strncmp(argv[argi], "--soft-max=", 11) == 0 && parse_axis_steps(argv[argi] + 11, soft_max) > 0) {
+            // Parsed into soft_max[]
+        } else if (strcmp(argv[argi], "--sim-home") == 0) {
+            sim_home_steps = SIM_HOME_DISTANCE;
+        } else if (strncmp(argv[argi], "--sim-home=", 11) == 0 && atoi(argv[argi] + 11) > 0) {
+            sim_home_steps = atoi(argv[argi] + 11);
+        } else if (strcmp(argv[argi], "--timing=sleep") == 0) {
+            timing_mode = STEP_WAIT_SLEEP;
+        } else if (strcmp(argv[argi], "--timing=hybrid") == 0) {
+            timing_mode = STEP_WAIT_HYBRID;
+        } else if (strncmp(argv[argi], "--spin-margin=", 14) == 0 && atol(argv[argi] + 14) > 0) {
+            spin_margin_ns = atol(argv[argi] + 14);
+        } else if (strncmp(argv[argi], "--timing-bench=", 15) == 0) {
+            timing_bench_rate = (uint32_t)atoi(argv[argi] + 15);
+        } else if (strcmp(argv[argi], "--shm") == 0) {
+            shm_name = CNC_SHM_DEFAULT_NAME;
+        } else if (strncmp(argv[argi], "--shm=", 6) == 0 && argv[argi][6] == '/') {
+            shm_name = argv[argi] + 6;
+        } else if (strncmp(argv[argi], "--capture=", 10) == 0) {
+            capture_file = argv[argi] + 10;
+        } else if (strncmp(argv[argi], "--replay=", 9) == 0) {
+            replay_file = argv[argi] + 9;
+        } else if (strncmp(argv[argi], "--replay-scale=", 15) == 0 && atof(argv[argi] + 15) > 0.0) {
+            replay_scale = atof(argv[argi] + 15);
+        } else if (strncmp(argv[argi], "--machine-config=", 17) == 0
+                   || strcmp(argv[argi], "--calibrate") == 0
+                   || (strncmp(argv[argi], "--calibrate=", 12) == 0 && calibrate_s > 0.0)) {
+            // Taken before the other options
+        } else if (strcmp(argv[argi], "--two-rate") == 0) {
+            two_rate_mode = 1;
+        } else if (strncmp(argv[argi], "--base-period=", 14) == 0 && atol(argv[argi] + 14) > 0) {
+            base_period_ns = atol(argv[argi] + 14);
+        } else if (strcmp(argv[argi], "--fifo") == 0) {
+            fifo_mode = 1;
+        } else if (strncmp(argv[argi], "--fifo=", 7) == 0) {
+            fifo_mode = 1;
+            fifo_byte_ns = (uint32_t)atoi(argv[argi] + 7);
+        } else if (strncmp(argv[argi], "--fifo-depth=", 13) == 0) {
+            fifo_depth = (uint32_t)atoi(argv[argi] + 13);
+        } else if (strncmp(argv[argi], "--fifo-bench=", 13) == 0) {
+            fifo_bench_rate = (uint32_t)atoi(argv[argi] + 13);
+        } else if (strncmp(argv[argi], "--arc-bench=", 12) == 0) {
+            arc_bench_radius = atoi(argv[argi] + 12);
+        } else if (strncmp(argv[argi], "--lookahead=", 12) == 0) {
+            lookahead = (uint32_t)atoi(argv[argi] + 12);
+            if (lookahead > PLANNER_MAX_LOOKAHEAD - 1)
+                lookahead = PLANNER_MAX_LOOKAHEAD - 1;
+        } else if (strncmp(argv[argi], "--junction-deviation=", 21) == 0) {
+            junction_dev = atof(argv[argi] + 21);
+        } else if (strncmp(argv[argi], "--steps-per-mm=", 15) == 0 && (n = parse_axis_values(argv[argi] + 15, values)) > 0
+                   && values[AXIS_X] > 0 && values[AXIS_Y] > 0 && values[AXIS_Z] > 0
+                   && (n < NUM_AXES || values[AXIS_A] > 0)) {
+            for (axis = 0; axis < n; axis++) steps_per_mm[axis] = values[axis];
+        } else {
+            printf("Usage: %s [--backend=outb|ppdev|devport|sim] [--rt-priority=N] [--cpumap=MASK]\n", argv[0]);
+            printf("       [--start-rate=N|X,Y,Z[,A]] [--max-rate=N|X,Y,Z[,A]]\n");
+            printf("       [--accel=N|X,Y,Z[,A]] [--jerk=N|X,Y,Z[,A]]\n");
+            printf("       [--hold-timeout=MS] [--input-latency=N] [--hist-file=PATH]\n");
+            printf("       [--gcode=FILE] [--gcode-dry-run] [--steps-per-mm=N|X,Y,Z[,A]]\n");
+            printf("       [--lookahead=N] [--junction-deviation=MM] [--arc-bench=R] [--pin-map=FILE]\n");
+            printf("       [--extra-port=ADDR[:PINMAP]] (up to %d times)\n", PARPORT_MAX_FOLLOWERS);
+            printf("       [--soft-min=N|X,Y,Z[,A]] [--soft-max=N|X,Y,Z[,A]] [--sim-home[=STEPS]]\n");
+            printf("       [--fifo[=BYTE_NS]] [--fifo-depth=N] [--fifo-bench=RATE]\n");
+            printf("       [--two-rate] [--base-period=NS] [--shm[=/NAME]]\n");
+            printf("       [--capture=FILE] [--replay=FILE] [--replay-scale=F]\n");
+            printf("       [--timing=sleep|hybrid] [--spin-margin=NS] [--timing-bench=RATE]\n");
+            printf("       [--calibrate[=SECONDS]] [--machine-config=FILE]\n");
+            exit(1);
+        }
+    }
+    if (base_period_ns == 0)
+        base_period_ns = period_ns;
+
+    DTStamp(); printf("Bismillah. Start CNC keyboard jogging. \n"); 
+    if (port_kind == PARPORT_BACKEND_OUTB) {
+        DTStamp(); printf("Note: You must run with root permission. \n\n");  
+    } else {
+        printf("\n");
+    }
+    
+    DATA_REG     = PARPORT_ADDRESS + 0;
+    STATUS_REG   = PARPORT_ADDRESS + 1;
+    CONTROL_REG  = PARPORT_ADDRESS + 2;
+    BASE_ADDRESS = PARPORT_ADDRESS;
+    
+    // STEP (1)(2)(3) are only needed for direct port I/O
+    if (port_kind == PARPORT_BACKEND_OUTB) {
+        // STEP (1) iopl - set I/O priority privilege level
+        io_prio_lvl = iopl(3);  		
+        check_io_priority_level();
+
+        // STEP (2) ioperm - set port input/output permissions
+        io_perm = ioperm(BASE_ADDRESS, 5, 1);
+        if (io_perm == 0 && (fifo_mode || fifo_bench_rate > 0))
+            io_perm = ioperm(BASE_ADDRESS + PARPORT_FIFO_OFFSET, 3, 1);    // ECP FIFO and ECR
+        for (int k = 0; k < extra_ports && io_perm == 0; k++)
+            io_perm = ioperm(extra_port[k].address, 3, 1);                  // DATA, STATUS, CONTROL
+        check_io_permission();
+	
+        // STEP (3) open parallel port devices (read/write) 
+        parport_fd = open(PARPORT_DEVICE, O_WRONLY); 
+    }
+	open_parallel_port();
+    load_pin_map();
+    open_extra_ports();
+    if (calibrate_s > 0.0) {
+        run_calibration(calibrate_s);
+        close_parallel_port();
+        exit(0);
+    }
+    init_step_state();
+    init_fifo_output();
+    init_capture();
+
+    // STEP (4) acceleration ramps and real-time stepping thread
+    build_profiles();
+    start_realtime();
+    init_shm();
+    if (input_latency_samples > 0)
+        measure_input_latency(input_latency_samples);
+  
+    // STEP (5) BEGIN CNC JOGGING
+    int charkey = 0;
+    run_menu();
+    fflush(stdout);
+    if (event_log_start(&event_log, format_event, stdout) != 0) {
+        DTStamp(); printf("ERROR  : Start event log drain thread\n");
+        exit(1);
+    }
+    init_keyboard();
+    
+    motion_submit(MOTION_CMD_RESET, 0, 0, 0, 0);
+    motion_wait_idle();
+    if (arc_bench_radius > 0) {
+        event_log_flush(&event_log);
+        run_arc_benchmark(arc_bench_radius);
+    }
+    if (fifo_bench_rate > 0) {
+        event_log_flush(&event_log);
+        run_fifo_benchmark(fifo_bench_rate);
+    }
+    if (timing_bench_rate > 0) {
+        event_log_flush(&event_log);
+        run_timing_benchmark(timing_bench_rate);
+    }
+    if (replay_file != NULL) {
+        event_log_flush(&event_log);
+        run_replay(replay_file);
+    }
+    if (gcode_file != NULL) {
+        event_log_flush(&event_log);
+        run_gcode_program(gcode_file, gcode_dry_run);
+    }
     
-    // Forever running this for..loop until key q is pressed
+    // Forever running this for..loop until key q is pressed.
+    // The loop sleeps in poll() between keys instead of spinning.
+    getrusage(RUSAGE_THREAD, &input_start_ru);
+    input_start_ns = monotonic_ns();
     for (; ;) {
-        if(keyboard_hit()) {
+        if(keyboard_wait(keyboard_timeout_ms())) {
             charkey = read_charkey();
 	        // printf("You hit keyboard key: char = %c or int = %d \n", charkey, charkey);
 	        cmd_interpreter(charkey);
         } //END IF 
+        jog_service();
+        shm_poll_commands();
+        shm_publish_status(0);
     } // END FOR
     
     reset_CNC(); 
     
-    // STEP (5) Close parallel port 
+    // STEP (6) Close parallel port 
 	// close_parallel_port();  PLACED INSIDE cmd_interpreter(charkey);
     
-    // STEP (6)cmd_interpreter(charkey);
+    // STEP (7)cmd_interpreter(charkey);
     // close_keyboard(); PLACED INSIDE cmd_interpreter(charkey);
     
    
@@ -0,0 +1,153 @@
+// File: latency-hist.c
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// Log-bucketed step-edge lateness histogram,
+// see latency-hist.h
+
+// ==============================================
+// INCLUDE FILE HEADERS
+#include "latency-hist.h"
+
+// ==================================================================
+static inline uint32_t bucket_of(uint64_t v) {
+// ==================================================================
+    uint32_t e;
+
+    if (v < LATENCY_SUB)
+        return (uint32_t)v;
+    e = 63 - (uint32_t)__builtin_clzll(v);          // floor(log2 v) >= SUB_BITS
+    if (e >= LATENCY_MAX_BITS)
+        return LATENCY_BUCKETS - 1;
+    return (e - LATENCY_SUB_BITS + 1) * LATENCY_SUB
+         + (uint32_t)((v >> (e - LATENCY_SUB_BITS)) & (LATENCY_SUB - 1));
+}
+
+// ==================================================================
+static inline uint64_t bucket_low(uint32_t b) {
+// ==================================================================
+    // Smallest value that lands in bucket b
+    uint32_t e;
+    if (b < LATENCY_SUB)
+        return b;
+    e = b / LATENCY_SUB + LATENCY_SUB_BITS - 1;
+    return ((uint64_t)LATENCY_SUB + (b % LATENCY_SUB)) << (e - LATENCY_SUB_BITS);
+}
+
+// ==================================================================
+static inline uint64_t bucket_high(uint32_t b) {
+// ==================================================================
+    // Largest value that lands in bucket b
+    return b + 1 < LATENCY_BUCKETS ? bucket_low(b + 1) - 1 : UINT64_MAX;
+}
+
+// ========================================================
+void latency_hist_init(struct latency_hist *h) {
+// ========================================================
+    uint32_t b;
+    atomic_init(&h->count, 0);
+    atomic_init(&h->sum_ns, 0);
+    atomic_init(&h->min_ns, UINT64_MAX);
+    atomic_init(&h->max_ns, 0);
+    atomic_init(&h->overruns, 0);
+    for (b = 0; b < LATENCY_BUCKETS; b++)
+        atomic_init(&h->bucket[b], 0);
+}
+
+// ========================================================
+void latency_hist_record(struct latency_hist *h, int64_t late_ns, int overrun) {
+// ========================================================
+    // Single writer (the stepping thread): plain load/store of
+    // min/max is enough, readers just see relaxed values.
+    uint64_t v = late_ns > 0 ? (uint64_t)late_ns : 0;
+
+    atomic_fetch_add_explicit(&h->bucket[bucket_of(v)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->sum_ns, v, memory_order_relaxed);
+    if (v < atomic_load_explicit(&h->min_ns, memory_order_relaxed))
+        atomic_store_explicit(&h->min_ns, v, memory_order_relaxed);
+    if (v > atomic_load_explicit(&h->max_ns, memory_order_relaxed))
+        atomic_store_explicit(&h->max_ns, v, memory_order_relaxed);
+    if (overrun)
+        atomic_fetch_add_explicit(&h->overruns, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->count, 1, memory_order_release);
+}
+
+// ========================================================
+uint64_t latency_hist_percentile(struct latency_hist *h, double fraction) {
+// ========================================================
+    // Upper edge of the bucket holding the given fraction of
+    // samples (never under-reports the true percentile).
+    uint64_t total = 0, target, seen = 0;
+    uint32_t b;
+
+    for (b = 0; b < LATENCY_BUCKETS; b++)
+        total += atomic_load_explicit(&h->bucket[b], memory_order_relaxed);
+    if (total == 0)
+        return 0;
+
+    target = (uint64_t)(fraction * (double)total);
+    if (target >= total)
+        target = total - 1;
+    for (b = 0; b < LATENCY_BUCKETS; b++) {
+        seen += atomic_load_explicit(&h->bucket[b], memory_order_relaxed);
+        if (seen > target) {
+            uint64_t high = bucket_high(b);
+            uint64_t max  = atomic_load_explicit(&h->max_ns, memory_order_relaxed);
+            return high < max ? high : max;
+        }
+    }
+    return atomic_load_explicit(&h->max_ns, memory_order_relaxed);
+}
+
+// ========================================================
+void latency_hist_summary(struct latency_hist *h, struct latency_summary *s) {
+// ========================================================
+    s->count    = atomic_load_explicit(&h->count, memory_order_acquire);
+    s->overruns = atomic_load_explicit(&h->overruns, memory_order_relaxed);
+    s->min_ns   = s->count ? atomic_load_explicit(&h->min_ns, memory_order_relaxed) : 0;
+    s->max_ns   = atomic_load_explicit(&h->max_ns, memory_order_relaxed);
+    s->mean_ns  = s->count ? (double)atomic_load_explicit(&h->sum_ns, memory_order_relaxed) / s->count : 0.0;
+    s->p99_ns   = latency_hist_percentile(h, 0.99);
+    s->p999_ns  = latency_hist_percentile(h, 0.999);
+    s->p9999_ns = latency_hist_percentile(h, 0.9999);
+}
+
+// ========================================================
+void latency_hist_dump(struct latency_hist *h, FILE *fp) {
+// ========================================================
+    // Summary lines as '#' comments, then one line per
+    // non-empty bucket: low_ns high_ns count
+    struct latency_summary s;
+    uint64_t n;
+    uint32_t b;
+
+    latency_hist_summary(h, &s);
+    fprintf(fp, "# step-edge lateness histogram (ns)\n");
+    fprintf(fp, "# count %llu overruns %llu\n", (unsigned long long)s.count, (unsigned long long)s.overruns);
+    fprintf(fp, "# min %llu mean %.0f max %llu\n", (unsigned long long)s.min_ns, s.mean_ns, (unsigned long long)s.max_ns);
+    fprintf(fp, "# p99 %llu p99.9 %llu p99.99 %llu\n", (unsigned long long)s.p99_ns,
+        (unsigned long long)s.p999_ns, (unsigned long long)s.p9999_ns);
+    fprintf(fp, "# low_ns high_ns count\n");
+    for (b = 0; b < LATENCY_BUCKETS; b++) {
+        n = atomic_load_explicit(&h->bucket[b], memory_order_relaxed);
+        if (n != 0)
+            fprintf(fp, "%llu %llu %llu\n", (unsigned long long)bucket_low(b),
+                (unsigned long long)bucket_high(b), (unsigned long long)n);
+    }
+}
+
+// ========================================================
+void latency_hist_write_buckets(struct latency_hist *h, FILE *fp, const char *prefix) {
+// ========================================================
+    // One line per non-empty bucket: prefix low_ns high_ns count
+    uint64_t n;
+    uint32_t b;
+
+    for (b = 0; b < LATENCY_BUCKETS; b++) {
+        n = atomic_load_explicit(&h->bucket[b], memory_order_relaxed);
+        if (n != 0)
+            fprintf(fp, "%s %llu %llu %llu\n", prefix, (unsigned long long)bucket_low(b),
+                (unsigned long long)bucket_high(b), (unsigned long long)n);
+    }
+}
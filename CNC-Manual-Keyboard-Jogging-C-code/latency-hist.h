@@ -0,0 +1,57 @@
+// File: latency-hist.h
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// Step-edge lateness histogram, the equivalent of
+// LinuxCNC's latency-test for this driver. The
+// stepping thread records how late every edge fired
+// compared with its deadline; any other thread may
+// read or dump the histogram at the same time.
+//
+// Buckets are log-linear: values below 16 ns get one
+// bucket each, above that every power of two is split
+// into 16 linear sub-buckets (<= 6.25 % bucket width).
+// Recording is a few shifts plus relaxed atomic adds:
+// no locks, no allocation, no syscalls.
+
+#ifndef LATENCY_HIST_H
+#define LATENCY_HIST_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#define LATENCY_SUB_BITS    4
+#define LATENCY_SUB         (1 << LATENCY_SUB_BITS)
+#define LATENCY_MAX_BITS    40                  // Up to ~1100 s, far beyond any edge
+#define LATENCY_BUCKETS     ((LATENCY_MAX_BITS - LATENCY_SUB_BITS + 1) * LATENCY_SUB)
+
+struct latency_hist {
+    atomic_uint_fast64_t count;
+    atomic_uint_fast64_t sum_ns;
+    atomic_uint_fast64_t min_ns;
+    atomic_uint_fast64_t max_ns;
+    atomic_uint_fast64_t overruns;      // Edges late by a full interval or more
+    atomic_uint_fast64_t bucket[LATENCY_BUCKETS];
+};
+
+struct latency_summary {
+    uint64_t    count;
+    uint64_t    overruns;
+    uint64_t    min_ns;
+    uint64_t    max_ns;
+    double      mean_ns;
+    uint64_t    p99_ns;
+    uint64_t    p999_ns;
+    uint64_t    p9999_ns;
+};
+
+void    latency_hist_init(struct latency_hist *h);
+void    latency_hist_record(struct latency_hist *h, int64_t late_ns, int overrun);
+uint64_t latency_hist_percentile(struct latency_hist *h, double fraction);
+void    latency_hist_summary(struct latency_hist *h, struct latency_summary *s);
+void    latency_hist_dump(struct latency_hist *h, FILE *fp);
+void    latency_hist_write_buckets(struct latency_hist *h, FILE *fp, const char *prefix);
+
+#endif // LATENCY_HIST_H
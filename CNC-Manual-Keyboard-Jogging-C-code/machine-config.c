@@ -0,0 +1,190 @@
+// File: machine-config.c
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// Host calibration and the machine config file,
+// see machine-config.h
+
+// ==============================================
+// INCLUDE FILE HEADERS
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cnc-time.h"
+#include "machine-config.h"
+
+// ========================================================
+void machine_config_default(struct machine_config *cfg, long period_ns, long tick_ns, uint32_t max_rate) {
+// ========================================================
+    int axis;
+
+    cfg->period_ns = period_ns;
+    cfg->tick_ns   = tick_ns;
+    for (axis = 0; axis < NUM_AXES; axis++)
+        cfg->max_rate[axis] = max_rate;
+}
+
+// ========================================================
+int machine_config_load(struct machine_config *cfg, const char *path, char *err, size_t err_len) {
+// ========================================================
+    // Read the file over *cfg. Returns 0, or -1 with a message
+    // in err; *cfg is unchanged on error. Keys left out keep
+    // their value.
+    struct machine_config next = *cfg;
+    char line[256], key[32];
+    long value[NUM_AXES];
+    int n, lineno = 0, axis;
+    FILE *fp;
+
+    fp = fopen(path, "r");
+    if (fp == NULL) {
+        snprintf(err, err_len, "cannot open %s", path);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        lineno++;
+        if (sscanf(line, " %31s", key) != 1 || key[0] == '#')
+            continue;
+        n = sscanf(line, " %31s %ld %ld %ld %ld", key, &value[0], &value[1], &value[2], &value[3]);
+        if (strcmp(key, "period") == 0 && n >= 2 && value[0] >= CALIB_MIN_PERIOD_NS) {
+            next.period_ns = value[0];
+        } else if (strcmp(key, "tick") == 0 && n >= 2 && value[0] > 0) {
+            next.tick_ns = value[0];
+        } else if (strcmp(key, "max-rate") == 0 && (n == 2 || n == NUM_AXES || n == 1 + NUM_AXES)
+                   && value[0] > 0 && (n == 2 || (value[1] > 0 && value[2] > 0))
+                   && (n != 1 + NUM_AXES || value[3] > 0)) {
+            // One value for all, X Y Z A, or X Y Z from a file
+            // written before the A axis (A keeps its rate)
+            for (axis = 0; axis < NUM_AXES; axis++)
+                if (n == 2 || axis < n - 1)
+                    next.max_rate[axis] = (uint32_t)value[n == 2 ? 0 : axis];
+        } else {
+            snprintf(err, err_len, "%s:%d: expected \"period NS\" (at least %d), \"tick NS\""
+                     " or \"max-rate N|X Y Z [A]\"", path, lineno, CALIB_MIN_PERIOD_NS);
+            fclose(fp);
+            return -1;
+        }
+    }
+    fclose(fp);
+    *cfg = next;
+    return 0;
+}
+
+// ========================================================
+int machine_config_save(const struct machine_config *cfg, const char *path, struct calib_run *run) {
+// ========================================================
+    // Write a new file (via path.tmp, so a crash leaves the old
+    // one) with the measurement behind it as comments
+    struct latency_summary ls;
+    char tmp[4096], host[64] = "?", date[32];
+    time_t now = time(NULL);
+    uint64_t probes;
+    FILE *fp;
+
+    if ((size_t)snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= sizeof(tmp))
+        return -1;
+    fp = fopen(tmp, "w");
+    if (fp == NULL)
+        return -1;
+    gethostname(host, sizeof(host) - 1);
+    strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", localtime(&now));
+    latency_hist_summary(&run->hist, &ls);
+    probes = atomic_load(&run->probes);
+
+    fprintf(fp, "# Machine timing limits, written by --calibrate on %s at %s\n", host, date);
+    fprintf(fp, "# %.0f s, %llu wake-ups every %d ns on the %s backend, %llu missed\n",
+        run->duration_ns / 1e9, (unsigned long long)probes, CALIB_PROBE_NS, run->be->name,
+        (unsigned long long)ls.overruns);
+    fprintf(fp, "# lateness mean/p99.99/max = %.0f / %llu / %llu (ns)\n",
+        ls.mean_ns, (unsigned long long)ls.p9999_ns, (unsigned long long)ls.max_ns);
+    fprintf(fp, "# port write + read mean/max = %.0f / %llu (ns)\n",
+        probes ? (double)run->io_sum_ns / probes : 0.0, (unsigned long long)run->io_max_ns);
+    fprintf(fp, "period    %ld\n", cfg->period_ns);
+    fprintf(fp, "tick      %ld\n", cfg->tick_ns);
+    fprintf(fp, "max-rate  %u %u %u %u\n", cfg->max_rate[AXIS_X], cfg->max_rate[AXIS_Y], cfg->max_rate[AXIS_Z],
+        cfg->max_rate[AXIS_A]);
+    if (fclose(fp) != 0 || rename(tmp, path) != 0) {
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+// ========================================================
+static void *calib_thread(void *data) {
+// ========================================================
+    // One edge's work every CALIB_PROBE_NS until the time is up
+    struct calib_run *run = data;
+    uint64_t t_end, t0, io;
+
+    step_timeline_start(&run->tl);
+    t_end = run->tl.start_ns + run->duration_ns;
+    while (monotonic_ns() < t_end) {
+        step_timeline_wait(&run->tl);
+        t0 = monotonic_ns();
+        parport_write(run->be, run->idle_byte);
+        parport_read_status(run->be);
+        io = monotonic_ns() - t0;
+        if (io > run->io_max_ns)
+            run->io_max_ns = io;
+        run->io_sum_ns += io;
+        atomic_store_explicit(&run->probes, run->tl.edges, memory_order_relaxed);
+    }
+    atomic_store_explicit(&run->done, 1, memory_order_release);
+    return NULL;
+}
+
+// ========================================================
+int calib_start(struct calib_run *run, struct parport_backend *be, unsigned char idle_byte,
+                double seconds, int priority, unsigned long cpumap) {
+// ========================================================
+    // Start the probe thread; returns 0 or the pthread error.
+    // rt (affinity_err, sched_err) tells how real-time it got.
+    memset(run, 0, sizeof(*run));
+    run->be          = be;
+    run->idle_byte   = idle_byte;
+    run->duration_ns = (uint64_t)(seconds * 1e9);
+    latency_hist_init(&run->hist);
+    step_timeline_init(&run->tl, CALIB_PROBE_NS);
+    run->tl.hist = &run->hist;
+    atomic_init(&run->probes, 0);
+    atomic_init(&run->done, 0);
+    return rt_thread_start(&run->rt, priority, cpumap, calib_thread, run);
+}
+
+// ========================================================
+void calib_wait(struct calib_run *run) {
+// ========================================================
+    pthread_join(run->rt.tid, NULL);
+}
+
+// ========================================================
+void calib_derive(struct calib_run *run, struct machine_config *cfg) {
+// ========================================================
+    // Shortest safe period, servo tick and step rates from the
+    // worst edge seen (see machine-config.h). cfg->max_rate[]
+    // comes in as the configured rates (0 = none) and goes out
+    // as the lower of those and what the period allows.
+    struct latency_summary ls;
+    uint32_t measured;
+    long period;
+    int axis;
+
+    latency_hist_summary(&run->hist, &ls);
+    period = (long)(CALIB_PERIOD_FACTOR * (ls.max_ns + run->io_max_ns));
+    period = (period + CALIB_PERIOD_ROUND_NS - 1) / CALIB_PERIOD_ROUND_NS * CALIB_PERIOD_ROUND_NS;
+    if (period < CALIB_MIN_PERIOD_NS)
+        period = CALIB_MIN_PERIOD_NS;
+
+    cfg->period_ns = period;
+    cfg->tick_ns   = CALIB_TICK_PERIODS * period;
+    if (cfg->tick_ns < CALIB_MIN_TICK_NS)
+        cfg->tick_ns = CALIB_MIN_TICK_NS;
+    measured = (uint32_t)(1e9 / (2.0 * period));
+    for (axis = 0; axis < NUM_AXES; axis++)
+        if (cfg->max_rate[axis] == 0 || cfg->max_rate[axis] > measured)
+            cfg->max_rate[axis] = measured;
+}
@@ -0,0 +1,107 @@
+// File: machine-config.h
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// Timing limits measured on the host the driver runs
+// on, in place of the compile-time PERIOD, TICK_TIME
+// and PROFILE_MAX_RATE guesses.
+//
+// CALIBRATION (--calibrate[=SECONDS]): a thread with the
+// stepping thread's SCHED_FIFO priority and CPUMAP wakes
+// every CALIB_PROBE_NS on an absolute timeline, exactly
+// as it would for a step edge, and each time writes the
+// idle byte to the port and reads STATUS_REG (the work
+// of one edge). Its wake-up lateness goes into a
+// latency_hist, the write + read time is kept apart.
+// Run it for minutes, with the machine as loaded as it
+// will be in use (desktop, network, disk), like
+// LinuxCNC's latency-test. From the worst case seen:
+//
+//   edge_ns  = worst lateness + worst write/read time
+//   period   = CALIB_PERIOD_FACTOR * edge_ns, rounded up
+//              to CALIB_PERIOD_ROUND_NS, at least
+//              CALIB_MIN_PERIOD_NS. An edge as late as the
+//              worst one seen still leaves every step high
+//              and low time at least half a period.
+//   tick     = CALIB_TICK_PERIODS * period, at least
+//              CALIB_MIN_TICK_NS
+//   max-rate = 1e9 / (2 * period) steps/s on every axis,
+//              one step being two edges, or the axis's
+//              --max-rate if that is lower
+//
+// The axes share one edge timeline, so the measured rate is
+// the same for all; lower an axis with --max-rate while
+// calibrating, or by hand in the file, if its drive or
+// mechanics need it.
+//
+// CONFIG FILE (--machine-config=FILE, default
+// MACHINE_CONFIG_FILE), read at startup if it exists:
+//
+//   # comment lines (calibration details)
+//   period    40000               # ns per edge (PERIOD)
+//   tick      1000000             # ns per servo tick (TICK_TIME)
+//   max-rate  12500 12500 12500 12500   # steps/s, X Y Z A (or one value)
+//
+// Options on the command line still override the file, but
+// the file's max-rate is a ceiling: --max-rate can only
+// lower an axis below it. The start rate (also the homing
+// approach rate) is held at or below the max rate.
+
+#ifndef MACHINE_CONFIG_H
+#define MACHINE_CONFIG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#include "parport-backend.h"
+#include "step-engine.h"
+#include "rt-thread.h"
+#include "latency-hist.h"
+#include "pin-map.h"
+
+#define MACHINE_CONFIG_FILE     "cnc-machine.conf"
+
+#define CALIB_DEFAULT_S         60          // Test length without --calibrate=SECONDS
+#define CALIB_PROBE_NS          100000      // Probe wake-up interval
+#define CALIB_PERIOD_FACTOR     2           // Period per worst-case edge time
+#define CALIB_PERIOD_ROUND_NS   1000
+#define CALIB_MIN_PERIOD_NS     5000
+#define CALIB_TICK_PERIODS      2           // Servo tick per period, as TICK_TIME / PERIOD
+#define CALIB_MIN_TICK_NS       1000000
+
+struct machine_config {
+    long        period_ns;              // Time per edge (PERIOD)
+    long        tick_ns;                // Servo tick (TICK_TIME)
+    uint32_t    max_rate[NUM_AXES];     // steps/s
+};
+
+// One calibration run
+struct calib_run {
+    struct parport_backend *be;
+    unsigned char   idle_byte;          // Written every probe, no edges
+    uint64_t        duration_ns;
+
+    struct rt_thread    rt;
+    struct step_timeline tl;
+    struct latency_hist hist;           // Wake-up lateness
+    uint64_t        io_max_ns;          // Worst port write + STATUS_REG read
+    uint64_t        io_sum_ns;
+    atomic_uint_fast64_t probes;
+    atomic_int      done;
+};
+
+// ==================================================================
+// FUNCTION PROTOTYPES
+// ==================================================================
+void    machine_config_default(struct machine_config *cfg, long period_ns, long tick_ns, uint32_t max_rate);
+int     machine_config_load(struct machine_config *cfg, const char *path, char *err, size_t err_len);
+int     machine_config_save(const struct machine_config *cfg, const char *path, struct calib_run *run);
+
+int     calib_start(struct calib_run *run, struct parport_backend *be, unsigned char idle_byte,
+                    double seconds, int priority, unsigned long cpumap);
+void    calib_wait(struct calib_run *run);
+void    calib_derive(struct calib_run *run, struct machine_config *cfg);
+
+#endif // MACHINE_CONFIG_H
@@ -0,0 +1,185 @@
+// File: motion-planner.c
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// Junction-velocity look-ahead planner, see
+// motion-planner.h
+
+// ==============================================
+// INCLUDE FILE HEADERS
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "motion-planner.h"
+
+#define PLANNER_MASK    (PLANNER_MAX_LOOKAHEAD - 1)
+
+// ========================================================
+void planner_init(struct planner *pl, uint32_t lookahead, double junction_dev,
+                  const struct axis_limits limits[NUM_AXES], const uint32_t steps_per_mm[NUM_AXES]) {
+// ========================================================
+    int axis;
+
+    memset(pl, 0, sizeof(*pl));
+    if (lookahead < 1)
+        lookahead = 1;
+    if (lookahead > PLANNER_MAX_LOOKAHEAD - 1)
+        lookahead = PLANNER_MAX_LOOKAHEAD - 1;
+    pl->lookahead    = lookahead;
+    pl->junction_dev = junction_dev;
+    for (axis = 0; axis < NUM_AXES; axis++) {
+        pl->limits[axis]       = limits[axis];
+        pl->steps_per_mm[axis] = steps_per_mm[axis];
+    }
+}
+
+// ========================================================
+static double junction_speed(const struct planner *pl, const struct plan_segment *seg) {
+// ========================================================
+    // Highest speed through the corner between the previous
+    // segment and seg (mm/s), from the junction deviation
+    double cos_t = 0.0, prev_len = 0.0, seg_len = 0.0, sin_half;
+    int axis;
+
+    if (!pl->has_prev)
+        return 0.0;                             // Starting from rest
+    // unit[] is not of length 1 once A turns along with a
+    // linear move
+    for (axis = 0; axis < NUM_AXES; axis++) {
+        cos_t    -= pl->prev_unit[axis] * seg->unit[axis];
+        prev_len += pl->prev_unit[axis] * pl->prev_unit[axis];
+        seg_len  += seg->unit[axis] * seg->unit[axis];
+    }
+    cos_t /= sqrt(prev_len * seg_len);
+    if (cos_t > 0.999999)
+        return 0.0;                             // Full reversal
+    if (cos_t < -0.999999)
+        return seg->nominal;                    // Straight on
+    sin_half = sqrt(0.5 * (1.0 - cos_t));
+    return sqrt(seg->accel * pl->junction_dev * sin_half / (1.0 - sin_half));
+}
+
+// ========================================================
+static void planner_recalculate(struct planner *pl) {
+// ========================================================
+    struct plan_segment *seg, *next;
+    double v;
+    uint32_t i;
+
+    // Backward: the window ends at rest, each entry must
+    // still brake down to the entry of the next segment.
+    v = 0.0;
+    for (i = pl->count - 1; i >= 1; i--) {
+        seg = &pl->seg[(pl->head + i) & PLANNER_MASK];
+        v = sqrt(v * v + 2.0 * seg->accel * seg->length_mm);
+        seg->entry = v < seg->max_entry ? v : seg->max_entry;
+        v = seg->entry;
+    }
+
+    // Forward: no entry above what the previous segment can
+    // accelerate to. The head entry is already committed.
+    for (i = 0; i + 1 < pl->count; i++) {
+        seg  = &pl->seg[(pl->head + i) & PLANNER_MASK];
+        next = &pl->seg[(pl->head + i + 1) & PLANNER_MASK];
+        v = sqrt(seg->entry * seg->entry + 2.0 * seg->accel * seg->length_mm);
+        if (next->entry > v)
+            next->entry = v;
+    }
+}
+
+// ========================================================
+int planner_push(struct planner *pl, const int32_t delta[NUM_AXES], double feed_mm_min) {
+// ========================================================
+    // Append a segment (feed_mm_min == 0 for a rapid).
+    // Returns -1 if the window is full: pop first.
+    struct plan_segment *seg;
+    double mm[NUM_AXES], u, limit, prev_nominal;
+    int axis;
+
+    if (pl->count >= pl->lookahead + 1)
+        return -1;
+    seg = &pl->seg[(pl->head + pl->count) & PLANNER_MASK];
+    memset(seg, 0, sizeof(*seg));
+
+    for (axis = 0; axis < NUM_AXES; axis++) {
+        seg->delta[axis] = delta[axis];
+        if ((uint32_t)abs(delta[axis]) > seg->major)
+            seg->major = (uint32_t)abs(delta[axis]);
+        mm[axis] = delta[axis] / pl->steps_per_mm[axis];
+        if (axis != AXIS_A)
+            seg->length_mm += mm[axis] * mm[axis];
+    }
+    if (seg->major == 0)
+        return 0;
+    seg->length_mm = seg->length_mm > 0.0 ? sqrt(seg->length_mm) : fabs(mm[AXIS_A]);
+
+    // Path limits: the tightest moving axis wins
+    seg->nominal = feed_mm_min > 0.0 ? feed_mm_min / 60.0 : HUGE_VAL;
+    seg->accel   = HUGE_VAL;
+    seg->floor   = HUGE_VAL;
+    for (axis = 0; axis < NUM_AXES; axis++) {
+        seg->unit[axis] = mm[axis] / seg->length_mm;
+        u = fabs(seg->unit[axis]) * pl->steps_per_mm[axis];
+        if (u == 0.0)
+            continue;
+        limit = pl->limits[axis].max_rate / u;
+        if (limit < seg->nominal) seg->nominal = limit;
+        limit = pl->limits[axis].accel / u;
+        if (limit < seg->accel) seg->accel = limit;
+        limit = pl->limits[axis].start_rate / u;
+        if (limit < seg->floor) seg->floor = limit;
+    }
+
+    // Entry limited by the corner and by both cruise speeds
+    prev_nominal = pl->count > 0
+        ? pl->seg[(pl->head + pl->count - 1) & PLANNER_MASK].nominal : 0.0;
+    seg->max_entry = junction_speed(pl, seg);
+    if (pl->has_prev && seg->max_entry > prev_nominal)
+        seg->max_entry = prev_nominal;
+    if (seg->max_entry > seg->nominal)
+        seg->max_entry = seg->nominal;
+    if (pl->count == 0)
+        seg->entry = seg->max_entry;            // New head: committed now
+
+    memcpy(pl->prev_unit, seg->unit, sizeof(pl->prev_unit));
+    pl->has_prev = 1;
+    pl->count++;
+    pl->segments++;
+    planner_recalculate(pl);
+    return 0;
+}
+
+// ========================================================
+int planner_pop(struct planner *pl, struct plan_block *block, int flush) {
+// ========================================================
+    // Hand out the oldest segment once the window is full,
+    // or whatever is left when flushing at the end of a
+    // program. Returns 1 with *block filled, 0 otherwise.
+    struct plan_segment *seg;
+    double exit, scale;
+
+    if (pl->count == 0 || (!flush && pl->count <= pl->lookahead))
+        return 0;
+
+    seg  = &pl->seg[pl->head];
+    exit = pl->count > 1 ? pl->seg[(pl->head + 1) & PLANNER_MASK].entry : 0.0;
+    if (exit > seg->floor)
+        pl->blended++;
+
+    // mm/s -> major-axis steps/s
+    scale = seg->major / seg->length_mm;
+    memcpy(block->delta, seg->delta, sizeof(block->delta));
+    block->profile.entry_rate  = seg->entry * scale;
+    block->profile.cruise_rate = seg->nominal * scale;
+    block->profile.exit_rate   = exit * scale;
+    block->profile.accel       = seg->accel * scale;
+    block->profile.floor_rate  = seg->floor * scale;
+
+    pl->head = (pl->head + 1) & PLANNER_MASK;
+    pl->count--;
+    if (pl->count == 0)
+        pl->has_prev = 0;                       // Ends at rest
+    return 1;
+}
@@ -0,0 +1,91 @@
+// File: motion-planner.h
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// Look-ahead trajectory planner for G-code segments.
+// Without it every segment starts from rest, stops,
+// and is followed by reset_CNC(). On a path made of
+// many short segments the machine spends most of its
+// time accelerating and braking.
+//
+// The planner keeps a window of up to `lookahead`
+// queued segments. For each junction it limits the
+// speed by the corner angle (junction deviation):
+//
+//   sin(t/2) = sqrt((1 - cos t) / 2)
+//   v_j^2    = a * deviation * sin(t/2) / (1 - sin(t/2))
+//
+// where t is the corner angle between the incoming
+// and outgoing paths (180 deg straight on = no limit,
+// 0 deg full reversal = stop).
+// After every new segment a backward pass (from a
+// stop at the end of the window) and a forward pass
+// (what acceleration can reach) settle the entry
+// speed of each segment. The oldest segment is handed
+// out once the window is full, with its entry, cruise
+// and exit rates, and the next segment's entry speed
+// becomes fixed.
+//
+// Speeds are in mm/s along the path. Handed-out
+// segments are in major-axis steps/s for the pulse
+// compiler.
+//
+// The rotary A axis is in degrees (steps_per_mm[A] is
+// steps per degree). As in most controllers the path
+// length is the X/Y/Z length, and a move of A alone is
+// as long as its degrees, so F is mm/min or deg/min.
+#ifndef MOTION_PLANNER_H
+#define MOTION_PLANNER_H
+
+#include <stdint.h>
+
+#include "motion-profile.h"
+#include "pulse-compiler.h"
+
+#define PLANNER_MAX_LOOKAHEAD   64      // Window size limit (power of 2)
+#define PLANNER_LOOKAHEAD       16      // Default window
+#define PLANNER_JUNCTION_DEV    0.02    // Default junction deviation (mm)
+
+struct plan_segment {
+    int32_t     delta[NUM_AXES];    // Steps per axis
+    uint32_t    major;              // Steps of the longest axis
+    double      unit[NUM_AXES];     // Axis mm (A: degrees) per mm of path
+    double      length_mm;
+    double      nominal;            // mm/s cruise (feed and axis limits)
+    double      accel;              // mm/s^2 (axis limits)
+    double      floor;              // mm/s at which an axis reaches its start rate
+    double      max_entry;          // mm/s junction and nominal limit
+    double      entry;              // mm/s planned entry speed
+};
+
+// One segment ready for the pulse compiler
+struct plan_block {
+    int32_t     delta[NUM_AXES];
+    struct plan_profile profile;
+};
+
+struct planner {
+    struct plan_segment seg[PLANNER_MAX_LOOKAHEAD];
+    uint32_t    head;               // Oldest segment (entry speed fixed)
+    uint32_t    count;
+    uint32_t    lookahead;
+    double      junction_dev;
+    double      prev_unit[NUM_AXES];
+    int         has_prev;           // Last pushed segment still in motion
+
+    // Axis limits in steps and steps/mm
+    struct axis_limits limits[NUM_AXES];
+    double      steps_per_mm[NUM_AXES];
+
+    // Counters
+    uint64_t    segments;
+    uint64_t    blended;            // Junctions passed above the floor speed
+};
+
+void    planner_init(struct planner *pl, uint32_t lookahead, double junction_dev,
+                     const struct axis_limits limits[NUM_AXES], const uint32_t steps_per_mm[NUM_AXES]);
+int     planner_push(struct planner *pl, const int32_t delta[NUM_AXES], double feed_mm_min);
+int     planner_pop(struct planner *pl, struct plan_block *block, int flush);
+
+#endif // MOTION_PLANNER_H
@@ -0,0 +1,89 @@
+// File: motion-profile.c
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// Builds the precomputed step-interval ramp
+// tables described in motion-profile.h
+
+// ==============================================
+// INCLUDE FILE HEADERS
+#include <string.h>
+#include <math.h>
+
+#include "motion-profile.h"
+
+#define PROFILE_DT      1e-6        // Integration time step (s)
+
+// ========================================================
+int profile_build_ramp(struct ramp_table *ramp, const struct axis_limits *lim) {
+// ========================================================
+    // Integrate the velocity profile from start_rate up to
+    // max_rate and record the time between successive whole
+    // steps. Returns the ramp length in steps, or -1 if the
+    // limits are unusable.
+    double v, a = 0.0, pos = 0.0, t = 0.0, t_last = 0.0;
+    double vmax = lim->max_rate, amax = lim->accel, jerk = lim->jerk;
+    uint32_t n = 0;
+
+    memset(ramp, 0, sizeof(*ramp));
+    if (lim->start_rate == 0 || lim->max_rate == 0)
+        return -1;
+
+    v = lim->start_rate;
+    if (v >= vmax || amax <= 0.0) {
+        // No ramp: run at the lower of the two rates
+        ramp->cruise_ns = (uint32_t)(1e9 / (v < vmax ? v : vmax));
+        return 0;
+    }
+
+    if (jerk <= 0.0)
+        a = amax;
+
+    while (v < vmax && n < PROFILE_MAX_RAMP) {
+        if (jerk > 0.0) {
+            // S-curve: bring accel back to zero exactly as v reaches vmax
+            if (v + a * a / (2.0 * jerk) >= vmax)
+                a -= jerk * PROFILE_DT;
+            else if (a < amax)
+                a += jerk * PROFILE_DT;
+            if (a > amax) a = amax;
+            if (a <= 0.0) break;
+        }
+        v += a * PROFILE_DT;
+        if (v > vmax) v = vmax;
+        pos += v * PROFILE_DT;
+        t   += PROFILE_DT;
+
+        if (pos >= n + 1) {
+            ramp->interval_ns[n++] = (uint32_t)((t - t_last) * 1e9);
+            t_last = t;
+        }
+    }
+
+    ramp->n = n;
+    if (n == PROFILE_MAX_RAMP && v < vmax)
+        ramp->cruise_ns = ramp->interval_ns[n - 1];  // Table full before vmax
+    else
+        ramp->cruise_ns = (uint32_t)(1e9 / vmax);
+    return (int)n;
+}
+
+// ========================================================
+uint32_t profile_plan_interval_ns(const struct plan_profile *plan, uint32_t i, uint32_t n) {
+// ========================================================
+    // Step i of n: the lowest of the rate reachable from the
+    // entry, the cruise rate and the rate that still brakes
+    // down to the exit rate by the last step. The floor
+    // (start rate) never lifts it above the cruise rate: a
+    // feed slower than the start rate is run at the feed.
+    double v_min = plan->floor_rate < plan->cruise_rate ? plan->floor_rate : plan->cruise_rate;
+    double v_acc = sqrt(plan->entry_rate * plan->entry_rate + 2.0 * plan->accel * i);
+    double v_dec = sqrt(plan->exit_rate * plan->exit_rate + 2.0 * plan->accel * (n - 1 - i));
+    double v = plan->cruise_rate;
+
+    if (v_acc < v) v = v_acc;
+    if (v_dec < v) v = v_dec;
+    if (v < v_min) v = v_min;
+    return (uint32_t)(1e9 / v);
+}
@@ -0,0 +1,76 @@
+// File: motion-profile.h
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// Acceleration profiles for jog moves. Each axis
+// has a start rate (what the motor can start at
+// from rest), a maximum rate, an acceleration and
+// an optional jerk limit:
+//
+//   jerk == 0 : trapezoidal profile (constant accel)
+//   jerk  > 0 : S-curve profile (accel ramps with jerk)
+//
+// profile_build_ramp() integrates the profile once at
+// startup into a table of step intervals in integer
+// nanoseconds. The stepping loop only indexes that
+// table: no floating-point math on the real-time path.
+//
+// Segments from the look-ahead planner do not start and
+// end at rest, so they use a plan_profile instead: a
+// trapezoid between given entry and exit rates. Those
+// intervals are computed by the pulse compiler on the
+// keyboard thread, never by the stepping thread.
+
+#ifndef MOTION_PROFILE_H
+#define MOTION_PROFILE_H
+
+#include <stdint.h>
+
+#define PROFILE_MAX_RAMP        4096    // Longest ramp (steps) kept in a table
+
+// Default limits, in steps/s, steps/s^2 and steps/s^3.
+// PROFILE_START_RATE is the old fixed rate (2 x 500 us per step).
+#define PROFILE_START_RATE      1000
+#define PROFILE_MAX_RATE        4000
+#define PROFILE_ACCEL           20000
+#define PROFILE_JERK            0
+
+struct axis_limits {
+    uint32_t    start_rate;     // steps/s reachable from rest
+    uint32_t    max_rate;       // steps/s cruise limit
+    uint32_t    accel;          // steps/s^2
+    uint32_t    jerk;           // steps/s^3, 0 = trapezoidal
+};
+
+struct ramp_table {
+    uint32_t    n;                              // Steps in the ramp
+    uint32_t    cruise_ns;                      // Step interval after the ramp
+    uint32_t    interval_ns[PROFILE_MAX_RAMP];  // Interval of ramp step i
+};
+
+// Trapezoid of one planned segment, in major-axis steps
+struct plan_profile {
+    double      entry_rate;     // steps/s at the first step
+    double      cruise_rate;    // steps/s limit inside the segment
+    double      exit_rate;      // steps/s at the last step
+    double      accel;          // steps/s^2
+    double      floor_rate;     // Never slower than this (start rate)
+};
+
+int     profile_build_ramp(struct ramp_table *ramp, const struct axis_limits *lim);
+uint32_t profile_plan_interval_ns(const struct plan_profile *plan, uint32_t i, uint32_t n);
+
+// Step interval (ns) of step i of an n-step move: accelerate
+// along the table, cruise, then decelerate along the mirrored
+// table. Integer only, safe for the stepping loop.
+static inline uint32_t profile_interval_ns(const struct ramp_table *ramp, uint32_t i, uint32_t n) {
+    uint32_t r = ramp->n < n / 2 ? ramp->n : n / 2;
+    if (i < r)
+        return ramp->interval_ns[i];
+    if (i >= n - r)
+        return ramp->interval_ns[n - 1 - i];
+    return ramp->cruise_ns;
+}
+
+#endif // MOTION_PROFILE_H
@@ -0,0 +1,90 @@
+// File: motion-queue.c
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// Wait-free SPSC motion command ring, see motion-queue.h
+
+// ==============================================
+// INCLUDE FILE HEADERS
+#include <string.h>
+
+#include "cnc-time.h"
+#include "motion-queue.h"
+
+// ========================================================
+void motion_queue_init(struct motion_queue *q) {
+// ========================================================
+    memset(q, 0, sizeof(*q));
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+    atomic_init(&q->completed_seq, 0);
+    q->latency_min_ns = UINT64_MAX;
+}
+
+// ========================================================
+int motion_queue_push(struct motion_queue *q, struct motion_cmd *cmd) {
+// ========================================================
+    // UI thread only. Returns 0, or -1 if the queue is full.
+    uint64_t head  = atomic_load_explicit(&q->head, memory_order_relaxed);
+    uint64_t tail  = atomic_load_explicit(&q->tail, memory_order_acquire);
+    uint64_t depth = head - tail;
+
+    if (depth >= MOTION_QUEUE_SIZE) {
+        q->full++;
+        return -1;
+    }
+    cmd->seq          = ++q->pushed;
+    cmd->t_enqueue_ns = monotonic_ns();
+    q->slot[head & (MOTION_QUEUE_SIZE - 1)] = *cmd;
+    atomic_store_explicit(&q->head, head + 1, memory_order_release);
+
+    if (depth + 1 > q->max_depth)
+        q->max_depth = depth + 1;
+    return 0;
+}
+
+// ========================================================
+int motion_queue_pop(struct motion_queue *q, struct motion_cmd *cmd) {
+// ========================================================
+    // Stepping thread only. Returns 1 with *cmd filled, or 0 if empty.
+    uint64_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    uint64_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+
+    if (tail == head)
+        return 0;
+    *cmd = q->slot[tail & (MOTION_QUEUE_SIZE - 1)];
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+    return 1;
+}
+
+// ========================================================
+const struct motion_cmd *motion_queue_peek(struct motion_queue *q) {
+// ========================================================
+    // Stepping thread only. Oldest queued command, or NULL.
+    uint64_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    uint64_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+
+    if (tail == head)
+        return NULL;
+    return &q->slot[tail & (MOTION_QUEUE_SIZE - 1)];
+}
+
+// ========================================================
+void motion_queue_complete(struct motion_queue *q, uint64_t seq) {
+// ========================================================
+    // Stepping thread only. Publishes that command seq is done.
+    atomic_store_explicit(&q->completed_seq, seq, memory_order_release);
+}
+
+// ========================================================
+void motion_queue_first_pulse(struct motion_queue *q, const struct motion_cmd *cmd, uint64_t pulse_ns) {
+// ========================================================
+    // Stepping thread only. Records enqueue-to-first-pulse latency.
+    uint64_t lat = pulse_ns > cmd->t_enqueue_ns ? pulse_ns - cmd->t_enqueue_ns : 0;
+
+    q->latency_count++;
+    q->latency_sum_ns += lat;
+    if (lat < q->latency_min_ns) q->latency_min_ns = lat;
+    if (lat > q->latency_max_ns) q->latency_max_ns = lat;
+}
@@ -0,0 +1,81 @@
+// File: motion-queue.h
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// Bounded single-producer/single-consumer ring of
+// fixed-size motion commands between the keyboard
+// (UI) thread and the real-time stepping thread.
+//
+// Push and pop are wait-free: one atomic load, one
+// copy and one atomic store each. No locks, no
+// syscalls and no allocation, so the stepping
+// thread never blocks on the UI and a slow printf
+// on the UI side can never delay a pulse.
+//
+// Only the UI thread may call motion_queue_push();
+// only the stepping thread may call _pop(), _peek()
+// and _complete().
+
+#ifndef MOTION_QUEUE_H
+#define MOTION_QUEUE_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+#define MOTION_QUEUE_SIZE   64      // Slots (power of 2)
+#define MOTION_AXES         4       // X, Y, Z, A
+
+enum motion_cmd_type {
+    MOTION_CMD_PULSES = 1,          // Play compiled pulse buffer[buffer]
+    MOTION_CMD_JOG    = 2,          // Continuous jog in delta[] until preempted
+    MOTION_CMD_STOP   = 3,          // Ends a running jog
+    MOTION_CMD_RESET  = 4,          // reset_CNC()
+    MOTION_CMD_HOME   = 5           // Home axis delta[0] on its switch
+};
+
+struct motion_cmd {
+    uint32_t    type;               // enum motion_cmd_type
+    int32_t     delta[MOTION_AXES]; // JOG: -1/0/+1 per axis
+    uint32_t    buffer;             // PULSES: index into the pulse pool
+    uint64_t    seq;                // Set by motion_queue_push()
+    uint64_t    t_enqueue_ns;       // Set by motion_queue_push()
+};
+
+struct motion_queue {
+    // Producer side (UI thread)
+    _Alignas(64) atomic_uint_fast64_t head;     // Next slot to write
+    uint64_t    pushed;
+    uint64_t    full;                           // Pushes refused, queue full
+    uint64_t    max_depth;
+
+    // Consumer side (stepping thread)
+    _Alignas(64) atomic_uint_fast64_t tail;     // Next slot to read
+    atomic_uint_fast64_t completed_seq;         // Last command fully executed
+    uint64_t    latency_count;                  // Enqueue-to-first-pulse
+    uint64_t    latency_min_ns;
+    uint64_t    latency_max_ns;
+    uint64_t    latency_sum_ns;
+
+    _Alignas(64) struct motion_cmd slot[MOTION_QUEUE_SIZE];
+};
+
+void    motion_queue_init(struct motion_queue *q);
+int     motion_queue_push(struct motion_queue *q, struct motion_cmd *cmd);
+int     motion_queue_pop(struct motion_queue *q, struct motion_cmd *cmd);
+const struct motion_cmd *motion_queue_peek(struct motion_queue *q);
+void    motion_queue_complete(struct motion_queue *q, uint64_t seq);
+void    motion_queue_first_pulse(struct motion_queue *q, const struct motion_cmd *cmd, uint64_t pulse_ns);
+
+// Commands queued but not yet popped
+static inline uint64_t motion_queue_depth(struct motion_queue *q) {
+    return atomic_load_explicit(&q->head, memory_order_acquire)
+         - atomic_load_explicit(&q->tail, memory_order_acquire);
+}
+
+// 1 when every pushed command has been executed (UI side)
+static inline int motion_queue_idle(struct motion_queue *q) {
+    return atomic_load_explicit(&q->completed_seq, memory_order_acquire) == q->pushed;
+}
+
+#endif // MOTION_QUEUE_H
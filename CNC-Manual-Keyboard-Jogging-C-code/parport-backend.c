@@ -0,0 +1,508 @@
+// File: parport-backend.c
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// Implementations of the parallel port output
+// backends declared in parport-backend.h.
+
+// ==============================================
+// INCLUDE FILE HEADERS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/io.h>
+#include <sys/ioctl.h>
+#include <linux/ppdev.h>
+#include <linux/parport.h>
+
+#include "cnc-time.h"
+#include "parport-backend.h"
+
+// ==================================================================
+// DIRECT PORT I/O (outb)
+// ==================================================================
+static void outb_write_data(struct parport_backend *be, unsigned char value) {
+    outb(value, be->base_address);
+}
+
+static unsigned char outb_read_status(struct parport_backend *be) {
+    return inb(be->base_address + 1);
+}
+
+// ECR mode field (bits 7..5) and status bits
+#define ECR_MODE_SPP        (0u << 5)
+#define ECR_MODE_FIFO       (2u << 5)       // Parallel port FIFO mode
+#define ECR_NO_INTR         0x14            // nErrIntrEn + serviceIntr: no interrupts, no DMA
+#define ECR_FULL            0x02
+#define ECR_EMPTY           0x01
+
+static size_t outb_fifo_write(struct parport_backend *be, const unsigned char *bytes, size_t n) {
+    size_t i;
+    for (i = 0; i < n; i++) {
+        if (inb(be->base_address + PARPORT_ECR_OFFSET) & ECR_FULL)
+            break;
+        outb(bytes[i], be->base_address + PARPORT_FIFO_OFFSET);
+    }
+    return i;
+}
+
+static int outb_fifo_empty(struct parport_backend *be) {
+    return (inb(be->base_address + PARPORT_ECR_OFFSET) & ECR_EMPTY) != 0;
+}
+
+// ==================================================================
+// PPDEV (/dev/parport0 ioctl)
+// ==================================================================
+static void ppdev_write_data(struct parport_backend *be, unsigned char value) {
+    ioctl(be->fd, PPWDATA, &value);
+}
+
+static unsigned char ppdev_read_status(struct parport_backend *be) {
+    unsigned char status = 0;
+    ioctl(be->fd, PPRSTATUS, &status);
+    return status;
+}
+
+static size_t ppdev_fifo_write(struct parport_backend *be, const unsigned char *bytes, size_t n) {
+    // Non-blocking: the driver takes what its FIFO/DMA can hold now
+    ssize_t done = write(be->fd, bytes, n);
+    return done > 0 ? (size_t)done : 0;
+}
+
+static int ppdev_fifo_empty(struct parport_backend *be) {
+    (void)be;
+    return -1;      // Hidden inside the kernel driver
+}
+
+// ==================================================================
+// /dev/port (one pwrite/pread per access, offset = port address)
+// ==================================================================
+static void devport_write_data(struct parport_backend *be, unsigned char value) {
+    if (pwrite(be->fd, &value, 1, be->base_address) != 1)
+        return;
+}
+
+static unsigned char devport_read_status(struct parport_backend *be) {
+    unsigned char status = 0;
+    if (pread(be->fd, &status, 1, be->base_address + 1) != 1)
+        return 0;
+    return status;
+}
+
+// ==================================================================
+// SIMULATED PORT (in-memory ring of timestamped writes)
+// ==================================================================
+static void sim_log(struct parport_backend *be, uint64_t t_ns, unsigned char value) {
+    struct parport_sim_write *w = &be->sim_ring[be->sim_head & (PARPORT_SIM_CAPACITY - 1)];
+    w->t_ns  = t_ns;
+    w->value = value;
+    be->sim_data = value;
+    be->sim_head++;
+}
+
+static void sim_write_data(struct parport_backend *be, unsigned char value) {
+    sim_log(be, monotonic_ns(), value);
+}
+
+static void sim_fifo_drain(struct parport_backend *be, uint64_t now) {
+    // Move every byte whose time has come onto the pins
+    unsigned char value;
+
+    while (be->sim_fifo_level > 0 && be->sim_fifo_next_ns <= now) {
+        value = be->sim_fifo[be->sim_fifo_rd];
+        if (value != be->sim_data)
+            sim_log(be, be->sim_fifo_next_ns, value);
+        be->sim_fifo_rd = (be->sim_fifo_rd + 1) % be->fifo_depth;
+        be->sim_fifo_level--;
+        be->sim_fifo_next_ns += be->fifo_byte_ns;
+    }
+}
+
+static size_t sim_fifo_write(struct parport_backend *be, const unsigned char *bytes, size_t n) {
+    uint64_t now = monotonic_ns();
+    size_t i;
+
+    sim_fifo_drain(be, now);
+    if (be->sim_fifo_level == 0 && be->sim_fifo_next_ns < now)
+        be->sim_fifo_next_ns = now;         // Idle (or underrun): restart the clock
+    for (i = 0; i < n && be->sim_fifo_level < be->fifo_depth; i++) {
+        be->sim_fifo[(be->sim_fifo_rd + be->sim_fifo_level) % be->fifo_depth] = bytes[i];
+        be->sim_fifo_level++;
+    }
+    return i;
+}
+
+static int sim_fifo_empty(struct parport_backend *be) {
+    sim_fifo_drain(be, monotonic_ns());
+    return be->sim_fifo_level == 0;
+}
+
+static unsigned char sim_read_status(struct parport_backend *be) {
+    if (be->sim_status_fn != NULL)
+        return be->sim_status_fn(be->sim_status_arg);
+    return be->sim_status;
+}
+
+// ========================================================
+int parport_backend_parse(const char *name, enum parport_backend_kind *kind) {
+// ========================================================
+    if (strcmp(name, "outb") == 0)  { *kind = PARPORT_BACKEND_OUTB;  return 0; }
+    if (strcmp(name, "ppdev") == 0) { *kind = PARPORT_BACKEND_PPDEV; return 0; }
+    if (strcmp(name, "sim") == 0)   { *kind = PARPORT_BACKEND_SIM;   return 0; }
+    if (strcmp(name, "devport") == 0) { *kind = PARPORT_BACKEND_DEVPORT; return 0; }
+    return -1;
+}
+
+// ========================================================
+int parport_backend_open(struct parport_backend *be, enum parport_backend_kind kind, int base_address) {
+// ========================================================
+    return parport_backend_open_device(be, kind, base_address, NULL);
+}
+
+// ========================================================
+int parport_backend_open_device(struct parport_backend *be, enum parport_backend_kind kind,
+                                int base_address, const char *device) {
+// ========================================================
+    // device: ppdev device file, NULL for /dev/parport0
+    memset(be, 0, sizeof(*be));
+    be->kind = kind;
+    be->base_address = base_address;
+    be->device = device != NULL ? device : PARPORT_PPDEV_DEVICE;
+    be->fd = -1;
+
+    switch (kind) {
+
+    case PARPORT_BACKEND_OUTB:
+        // iopl()/ioperm() are done by the caller, as before
+        be->name        = "outb";
+        be->write_data  = outb_write_data;
+        be->read_status = outb_read_status;
+        be->fifo_write  = outb_fifo_write;
+        be->fifo_empty  = outb_fifo_empty;
+        return 0;
+
+    case PARPORT_BACKEND_PPDEV:
+        be->name        = "ppdev";
+        be->write_data  = ppdev_write_data;
+        be->read_status = ppdev_read_status;
+        be->fifo_write  = ppdev_fifo_write;
+        be->fifo_empty  = ppdev_fifo_empty;
+        be->fd = open(be->device, O_RDWR);
+        if (be->fd < 0)
+            return -1;
+        if (ioctl(be->fd, PPCLAIM) != 0) {
+            close(be->fd);
+            be->fd = -1;
+            return -1;
+        }
+        return 0;
+
+    case PARPORT_BACKEND_DEVPORT:
+        be->name        = "devport";
+        be->write_data  = devport_write_data;
+        be->read_status = devport_read_status;
+        be->fd = open(PARPORT_DEVPORT_DEVICE, O_RDWR);
+        return be->fd < 0 ? -1 : 0;
+
+    case PARPORT_BACKEND_SIM:
+        be->name        = "sim";
+        be->write_data  = sim_write_data;
+        be->read_status = sim_read_status;
+        be->fifo_write  = sim_fifo_write;
+        be->fifo_empty  = sim_fifo_empty;
+        be->sim_status  = 0x78;     // Idle status lines (no switches, BUSY low)
+        be->sim_ring = malloc(PARPORT_SIM_CAPACITY * sizeof(*be->sim_ring));
+        be->sim_fifo = malloc(PARPORT_FIFO_MAX_DEPTH);
+        if (be->sim_ring == NULL || be->sim_fifo == NULL)
+            return -1;
+        // Touch every page now so writes never page-fault later
+        memset(be->sim_ring, 0, PARPORT_SIM_CAPACITY * sizeof(*be->sim_ring));
+        return 0;
+    }
+    return -1;
+}
+
+// ========================================================
+void parport_backend_close(struct parport_backend *be) {
+// ========================================================
+    if (be->kind == PARPORT_BACKEND_PPDEV && be->fd >= 0) {
+        ioctl(be->fd, PPRELEASE);
+        close(be->fd);
+        be->fd = -1;
+    }
+    if (be->kind == PARPORT_BACKEND_DEVPORT && be->fd >= 0) {
+        close(be->fd);
+        be->fd = -1;
+    }
+    if (be->kind == PARPORT_BACKEND_SIM) {
+        free(be->sim_ring);
+        free(be->sim_fifo);
+        be->sim_ring = NULL;
+        be->sim_fifo = NULL;
+    }
+}
+
+// ========================================================
+static int fifo_probe_byte_ns(struct parport_backend *be, int fd_blocking) {
+// ========================================================
+    // Clock PARPORT_FIFO_PROBE_BYTES copies of the byte on the
+    // pins out of the hardware FIFO (the pins do not change)
+    // and set fifo_byte_ns to the time per byte. ppdev: one
+    // blocking write(), which returns once the driver has
+    // sent it all. Returns -1 with ETIMEDOUT if BUSY stalls.
+    unsigned char fill[PARPORT_FIFO_PROBE_BYTES];
+    uint64_t t0, t_end, dt;
+    size_t done = 0;
+    ssize_t n;
+
+    memset(fill, atomic_load_explicit(&be->data_shadow, memory_order_relaxed), sizeof(fill));
+    t0    = monotonic_ns();
+    t_end = t0 + (uint64_t)sizeof(fill) * be->fifo_byte_ns + PARPORT_FIFO_STALL_NS;
+    if (fd_blocking) {
+        n = write(be->fd, fill, sizeof(fill));
+        if (n != (ssize_t)sizeof(fill)) {
+            errno = ETIMEDOUT;
+            return -1;
+        }
+    } else {
+        while (done < sizeof(fill) || !outb_fifo_empty(be)) {
+            if (monotonic_ns() >= t_end) {
+                errno = ETIMEDOUT;
+                return -1;
+            }
+            if (done < sizeof(fill))
+                done += outb_fifo_write(be, fill + done, sizeof(fill) - done);
+        }
+    }
+    dt = monotonic_ns() - t0;
+    be->fifo_byte_ns = (uint32_t)(dt / sizeof(fill));
+    if (be->fifo_byte_ns == 0)
+        be->fifo_byte_ns = 1;
+    return 0;
+}
+
+// ========================================================
+int parport_fifo_start(struct parport_backend *be, uint32_t byte_ns, uint32_t depth) {
+// ========================================================
+    // Switch the port to FIFO output. depth only applies to
+    // the simulated port; the hardware FIFOs are what they are,
+    // and so is their byte time, which is measured here.
+    int mode = IEEE1284_MODE_COMPAT, flags;
+
+    if (be->fifo_active)
+        return 0;
+    if (atomic_load_explicit(&be->fifo_stalled, memory_order_relaxed)) {
+        errno = ETIMEDOUT;
+        return -1;
+    }
+    if (be->followers > 0) {
+        // The followers would still get one CPU-timed write per byte
+        errno = EOPNOTSUPP;
+        return -1;
+    }
+    be->fifo_byte_ns = byte_ns;
+    be->fifo_depth   = PARPORT_FIFO_DEPTH;
+
+    switch (be->kind) {
+
+    case PARPORT_BACKEND_OUTB:
+        // Mode changes go through SPP; the FIFO starts empty
+        outb(ECR_MODE_SPP | ECR_NO_INTR, be->base_address + PARPORT_ECR_OFFSET);
+        outb(ECR_MODE_FIFO | ECR_NO_INTR, be->base_address + PARPORT_ECR_OFFSET);
+        if (fifo_probe_byte_ns(be, 0) != 0) {
+            outb(ECR_MODE_SPP | ECR_NO_INTR, be->base_address + PARPORT_ECR_OFFSET);
+            atomic_store_explicit(&be->fifo_stalled, 1, memory_order_relaxed);
+            errno = ETIMEDOUT;
+            return -1;
+        }
+        break;
+
+    case PARPORT_BACKEND_PPDEV:
+        if (ioctl(be->fd, PPSETMODE, &mode) != 0)
+            return -1;
+        if (fifo_probe_byte_ns(be, 1) != 0) {
+            atomic_store_explicit(&be->fifo_stalled, 1, memory_order_relaxed);
+            return -1;
+        }
+        flags = fcntl(be->fd, F_GETFL);
+        if (flags < 0 || fcntl(be->fd, F_SETFL, flags | O_NONBLOCK) != 0)
+            return -1;
+        break;
+
+    case PARPORT_BACKEND_DEVPORT:
+        errno = EOPNOTSUPP;
+        return -1;
+
+    case PARPORT_BACKEND_SIM:
+        if (depth == 0 || depth > PARPORT_FIFO_MAX_DEPTH) {
+            errno = EINVAL;
+            return -1;
+        }
+        be->fifo_depth       = depth;
+        be->sim_fifo_rd      = 0;
+        be->sim_fifo_level   = 0;
+        be->sim_fifo_next_ns = 0;
+        break;
+    }
+    be->fifo_last   = be->kind == PARPORT_BACKEND_SIM ? be->sim_data
+                    : atomic_load_explicit(&be->data_shadow, memory_order_relaxed);
+    be->fifo_active = 1;
+    return 0;
+}
+
+// ========================================================
+int parport_fifo_finish(struct parport_backend *be) {
+// ========================================================
+    // Let the FIFO run empty, then go back to single writes
+    // with the pins where the last byte left them. Returns
+    // -1 (ETIMEDOUT) if it had to give up on the drain.
+    struct timespec ts;
+    uint64_t t_end;
+    int flags, stalled = 0;
+
+    if (!be->fifo_active)
+        return 0;
+    t_end = monotonic_ns() + (uint64_t)be->fifo_depth * be->fifo_byte_ns + PARPORT_FIFO_STALL_NS;
+    while (parport_fifo_empty(be) == 0) {
+        if (monotonic_ns() >= t_end) {
+            stalled = 1;
+            break;
+        }
+        ts.tv_sec  = 0;
+        ts.tv_nsec = (long)be->fifo_byte_ns;
+        nanosleep(&ts, NULL);
+    }
+
+    switch (be->kind) {
+
+    case PARPORT_BACKEND_OUTB:
+        outb(ECR_MODE_SPP | ECR_NO_INTR, be->base_address + PARPORT_ECR_OFFSET);
+        break;
+
+    case PARPORT_BACKEND_PPDEV:
+        // Blocking again: the next PPWDATA waits for the driver
+        flags = fcntl(be->fd, F_GETFL);
+        if (flags >= 0)
+            fcntl(be->fd, F_SETFL, flags & ~O_NONBLOCK);
+        break;
+
+    case PARPORT_BACKEND_DEVPORT:
+    case PARPORT_BACKEND_SIM:
+        break;
+    }
+    be->fifo_active = 0;
+    if (be->kind != PARPORT_BACKEND_SIM)
+        parport_write(be, be->fifo_last);   // DATA_REG latch of the SPP mode
+    if (stalled) {
+        atomic_store_explicit(&be->fifo_stalled, 1, memory_order_relaxed);
+        errno = ETIMEDOUT;
+        return -1;
+    }
+    return 0;
+}
+
+// ========================================================
+int parport_add_follower(struct parport_backend *be, struct parport_backend *follower,
+                         const unsigned char xlat[256]) {
+// ========================================================
+    // Chain another port onto this one. Call before the
+    // stepping thread starts; xlat must stay valid.
+    if (be->followers >= PARPORT_MAX_FOLLOWERS || be->fifo_active
+        || follower->followers > 0 || follower == be) {
+        errno = EINVAL;
+        return -1;
+    }
+    memset(&be->skew[be->followers], 0, sizeof(be->skew[0]));
+    be->follower_xlat[be->followers] = xlat;
+    be->follower[be->followers++]    = follower;
+    return 0;
+}
+
+// ========================================================
+void parport_write_followers(struct parport_backend *be, unsigned char value) {
+// ========================================================
+    // Called by parport_write() right after this port's own write
+    struct parport_skew *sk;
+    uint64_t t0, dt;
+    int k;
+
+    if ((be->fanout_writes++ & (PARPORT_SKEW_EVERY - 1)) != 0) {
+        for (k = 0; k < be->followers; k++)
+            parport_write(be->follower[k], be->follower_xlat[k][value]);
+        return;
+    }
+
+    // Timed write: the clock read after each follower adds
+    // to the skew of the next one (about 20 ns with vDSO)
+    t0 = monotonic_ns();
+    for (k = 0; k < be->followers; k++) {
+        parport_write(be->follower[k], be->follower_xlat[k][value]);
+        dt = monotonic_ns() - t0;
+        sk = &be->skew[k];
+        if (sk->samples == 0 || dt < sk->min_ns)
+            sk->min_ns = dt;
+        if (dt > sk->max_ns)
+            sk->max_ns = dt;
+        sk->sum_ns += dt;
+        sk->samples++;
+    }
+}
+
+// ========================================================
+void parport_tap_fifo(struct parport_backend *be, const unsigned char *bytes, size_t n) {
+// ========================================================
+    // Queued bytes leave one every fifo_byte_ns after the ones
+    // already queued, or from now if the FIFO had run empty
+    uint64_t now = monotonic_ns();
+    size_t i;
+
+    if (be->tap_fifo_ns < now)
+        be->tap_fifo_ns = now;
+    for (i = 0; i < n; i++) {
+        be->tap(be->tap_arg, be->tap_fifo_ns, bytes[i]);
+        be->tap_fifo_ns += be->fifo_byte_ns;
+    }
+}
+
+// ========================================================
+uint64_t parport_sim_count(const struct parport_backend *be) {
+// ========================================================
+    // Number of writes still held in the ring
+    return be->sim_head < PARPORT_SIM_CAPACITY ? be->sim_head : PARPORT_SIM_CAPACITY;
+}
+
+// ========================================================
+const struct parport_sim_write *parport_sim_at(const struct parport_backend *be, uint64_t index) {
+// ========================================================
+    // index 0 is the oldest write still held in the ring
+    uint64_t first = be->sim_head - parport_sim_count(be);
+    return &be->sim_ring[(first + index) & (PARPORT_SIM_CAPACITY - 1)];
+}
+
+// ========================================================
+void parport_sim_get_stats(const struct parport_backend *be, struct parport_sim_stats *stats) {
+// ========================================================
+    uint64_t i, n = parport_sim_count(be);
+
+    memset(stats, 0, sizeof(*stats));
+    stats->writes = n;
+    if (n == 0)
+        return;
+
+    stats->first_ns   = parport_sim_at(be, 0)->t_ns;
+    stats->last_ns    = parport_sim_at(be, n - 1)->t_ns;
+    stats->min_gap_ns = UINT64_MAX;
+    for (i = 1; i < n; i++) {
+        uint64_t gap = parport_sim_at(be, i)->t_ns - parport_sim_at(be, i - 1)->t_ns;
+        if (gap < stats->min_gap_ns) stats->min_gap_ns = gap;
+        if (gap > stats->max_gap_ns) stats->max_gap_ns = gap;
+    }
+    if (n > 1)
+        stats->mean_gap_ns = (double)(stats->last_ns - stats->first_ns) / (double)(n - 1);
+    else
+        stats->min_gap_ns = 0;
+}
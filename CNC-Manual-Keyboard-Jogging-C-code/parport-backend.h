@@ -0,0 +1,237 @@
+// File: parport-backend.h
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// Pluggable output backends for the parallel port.
+// Every DATA_REG write of the jogging code goes
+// through one of these instead of calling outb()
+// directly, so the same pulse code can run on:
+//
+//   outb  : direct port I/O (iopl/ioperm, root)
+//   ppdev : /dev/parport0 ioctl(PPWDATA) path
+//   devport : pwrite()/pread() on /dev/port at the
+//           port address (root, no iopl)
+//   sim   : in-memory simulated port that logs
+//           every write with a CLOCK_MONOTONIC
+//           nanosecond timestamp into a ring buffer
+//
+// The simulated port lets us measure pulse-train
+// jitter and throughput on any Linux box.
+//
+// FIFO (burst) output: instead of one CPU-timed write
+// per edge, whole runs of bytes are queued into the
+// port's FIFO and the port clocks them out itself, one
+// byte every fifo_byte_ns. The caller keeps the FIFO
+// topped up (see step-engine.h):
+//
+//   outb  : ECR at base + 0x402 switched to the
+//           parallel port FIFO mode (010), bytes go
+//           to the FIFO at base + 0x400
+//   ppdev : compatibility mode write() on a
+//           non-blocking fd; parport_pc feeds its
+//           FIFO (or DMA) from the kernel
+//   devport : not supported
+//   sim   : a FIFO of fifo_depth bytes drained at
+//           exactly fifo_byte_ns; only changes of the
+//           pins are logged, at the time they happen
+//
+// In the FIFO mode the port strobes every byte and
+// waits for BUSY (PARPORT_BUSY_PIN) to go low, so that
+// pin must not carry a switch.
+//
+// The byte_ns given to parport_fifo_start() is only the
+// rate of the simulated port. A hardware port clocks at
+// its own pace (strobe width, BUSY handshake), so
+// parport_fifo_start() times PARPORT_FIFO_PROBE_BYTES
+// copies of the byte on the pins going through the FIFO
+// and sets fifo_byte_ns to that. parport_fifo_finish()
+// waits at most the FIFO's worth of bytes plus
+// PARPORT_FIFO_STALL_NS for it to drain; past that
+// (BUSY held high) it leaves the FIFO mode anyway, which
+// drops what is left, sets fifo_stalled and returns -1,
+// and parport_fifo_start() refuses from then on, so the
+// caller goes back to timed writes.
+//
+// FOLLOWER PORTS: up to PARPORT_MAX_FOLLOWERS more ports
+// of the same kind can be chained onto the one the step
+// engine writes. Every parport_write() then also writes
+// each follower, back-to-back in the same tick, with the
+// byte translated through the follower's xlat[] table
+// (built from the two pin maps, see pin-map.h). Every
+// PARPORT_SKEW_EVERY-th write is timed: the skew of a
+// follower is the time from the end of the first port's
+// write to the end of its own. Switches are only read on
+// the first port, and FIFO output is refused while
+// followers are attached.
+//
+// TAP: if set, tap() is called with every byte that goes
+// to the pins of this port and its CLOCK_MONOTONIC time
+// (see pulse-trace.h). Bytes queued into the FIFO are
+// passed with the time the port clocks them out, as far
+// as it can be known: one every fifo_byte_ns.
+
+#ifndef PARPORT_BACKEND_H
+#define PARPORT_BACKEND_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+#include "cnc-time.h"
+
+// ==================================================================
+// BACKEND TYPES
+// ==================================================================
+enum parport_backend_kind {
+    PARPORT_BACKEND_OUTB  = 0,
+    PARPORT_BACKEND_PPDEV = 1,
+    PARPORT_BACKEND_SIM   = 2,
+    PARPORT_BACKEND_DEVPORT = 3
+};
+
+#define PARPORT_PPDEV_DEVICE    "/dev/parport0"
+#define PARPORT_DEVPORT_DEVICE  "/dev/port"
+#define PARPORT_SIM_CAPACITY    (1u << 20)   // Writes kept by the simulated port (power of 2)
+
+#define PARPORT_FIFO_DEPTH      16          // ECP FIFO of a PC-style port (bytes)
+#define PARPORT_FIFO_BYTE_NS    1000        // Default time per FIFO byte
+#define PARPORT_FIFO_MAX_DEPTH  4096        // Largest simulated FIFO
+#define PARPORT_FIFO_OFFSET     0x400       // ECP data FIFO (base + 0x400)
+#define PARPORT_ECR_OFFSET      0x402       // Extended control register
+#define PARPORT_FIFO_PROBE_BYTES 256        // Bytes timed to measure a hardware FIFO
+#define PARPORT_FIFO_STALL_NS   10000000    // Longer than due to drain: BUSY is stuck
+#define PARPORT_BUSY_PIN        11          // DB25 pin the FIFO mode handshakes on
+
+#define PARPORT_MAX_FOLLOWERS   3           // Ports written along with the first one
+#define PARPORT_SKEW_EVERY      16          // Time every 16th write (power of 2)
+
+// One logged write of the simulated port
+struct parport_sim_write {
+    uint64_t        t_ns;       // CLOCK_MONOTONIC timestamp (ns)
+    unsigned char   value;      // Byte written to DATA_REG
+};
+
+// Write-to-write skew of one follower port
+struct parport_skew {
+    uint64_t    samples;
+    uint64_t    sum_ns;
+    uint64_t    min_ns;
+    uint64_t    max_ns;
+};
+
+struct parport_backend {
+    enum parport_backend_kind kind;
+    const char      *name;
+
+    int             base_address;   // DATA_REG address (outb)
+    int             fd;             // /dev/parport0 (ppdev), /dev/port (devport)
+    const char      *device;        // ppdev device file
+
+    // Last byte written / read, for status readers on other threads
+    _Atomic unsigned char data_shadow;      // DATA_REG (FIFO: last byte queued)
+    _Atomic unsigned char status_shadow;    // STATUS_REG
+
+    // SIMULATED PORT STATE
+    struct parport_sim_write *sim_ring;     // Preallocated write log
+    uint64_t        sim_head;               // Total writes so far
+    unsigned char   sim_data;               // Last DATA_REG value
+    unsigned char   sim_status;             // Value returned for STATUS_REG
+    unsigned char   (*sim_status_fn)(void *arg);   // Switch model, overrides sim_status
+    void            *sim_status_arg;
+
+    // FIFO (BURST) OUTPUT
+    int             fifo_active;            // Between parport_fifo_start() and _finish()
+    uint32_t        fifo_depth;             // Bytes the FIFO holds
+    uint32_t        fifo_byte_ns;           // Time each byte stays on the pins (measured on hardware)
+    atomic_int      fifo_stalled;           // A drain timed out; FIFO refused from then on
+    unsigned char   fifo_last;              // Last byte queued
+    unsigned char   *sim_fifo;              // Simulated FIFO contents
+    uint32_t        sim_fifo_rd;            // Oldest byte
+    uint32_t        sim_fifo_level;         // Bytes held
+    uint64_t        sim_fifo_next_ns;       // When the oldest byte reaches the pins
+
+    void            (*write_data)(struct parport_backend *be, unsigned char value);
+    unsigned char   (*read_status)(struct parport_backend *be);
+    size_t          (*fifo_write)(struct parport_backend *be, const unsigned char *bytes, size_t n);
+    int             (*fifo_empty)(struct parport_backend *be);
+
+    // FOLLOWER PORTS
+    int             followers;
+    struct parport_backend *follower[PARPORT_MAX_FOLLOWERS];
+    const unsigned char *follower_xlat[PARPORT_MAX_FOLLOWERS];  // This port's byte -> follower's
+    uint32_t        fanout_writes;
+    struct parport_skew skew[PARPORT_MAX_FOLLOWERS];
+
+    // TAP (write capture)
+    void            (*tap)(void *arg, uint64_t t_ns, unsigned char value);
+    void            *tap_arg;
+    uint64_t        tap_fifo_ns;            // When the last FIFO byte reaches the pins
+};
+
+// Summary of the simulated write log
+struct parport_sim_stats {
+    uint64_t    writes;         // Writes still held in the ring
+    uint64_t    first_ns;       // Timestamp of the oldest held write
+    uint64_t    last_ns;        // Timestamp of the newest write
+    uint64_t    min_gap_ns;     // Shortest gap between two writes
+    uint64_t    max_gap_ns;     // Longest gap between two writes
+    double      mean_gap_ns;    // Mean gap between two writes
+};
+
+// ==================================================================
+// FUNCTION PROTOTYPES
+// ==================================================================
+int     parport_backend_parse(const char *name, enum parport_backend_kind *kind);
+int     parport_backend_open(struct parport_backend *be, enum parport_backend_kind kind, int base_address);
+int     parport_backend_open_device(struct parport_backend *be, enum parport_backend_kind kind,
+                                    int base_address, const char *device);
+void    parport_backend_close(struct parport_backend *be);
+
+uint64_t parport_sim_count(const struct parport_backend *be);
+const struct parport_sim_write *parport_sim_at(const struct parport_backend *be, uint64_t index);
+void    parport_sim_get_stats(const struct parport_backend *be, struct parport_sim_stats *stats);
+
+int     parport_fifo_start(struct parport_backend *be, uint32_t byte_ns, uint32_t depth);
+int     parport_fifo_finish(struct parport_backend *be);
+
+int     parport_add_follower(struct parport_backend *be, struct parport_backend *follower,
+                             const unsigned char xlat[256]);
+void    parport_write_followers(struct parport_backend *be, unsigned char value);
+void    parport_tap_fifo(struct parport_backend *be, const unsigned char *bytes, size_t n);
+
+// Write one byte to DATA_REG through the selected backend
+static inline void parport_write(struct parport_backend *be, unsigned char value) {
+    be->write_data(be, value);
+    atomic_store_explicit(&be->data_shadow, value, memory_order_relaxed);
+    if (be->followers > 0)
+        parport_write_followers(be, value);
+    if (be->tap != NULL)
+        be->tap(be->tap_arg, monotonic_ns(), value);
+}
+
+// Read STATUS_REG through the selected backend
+static inline unsigned char parport_read_status(struct parport_backend *be) {
+    unsigned char value = be->read_status(be);
+    atomic_store_explicit(&be->status_shadow, value, memory_order_relaxed);
+    return value;
+}
+
+// Queue up to n bytes into the FIFO, returns how many fitted
+static inline size_t parport_fifo_write(struct parport_backend *be, const unsigned char *bytes, size_t n) {
+    size_t done = be->fifo_write(be, bytes, n);
+    if (done > 0) {
+        be->fifo_last = bytes[done - 1];
+        atomic_store_explicit(&be->data_shadow, be->fifo_last, memory_order_relaxed);
+        if (be->tap != NULL)
+            parport_tap_fifo(be, bytes, done);
+    }
+    return done;
+}
+
+// 1 if the FIFO has run empty, 0 if not, -1 if the backend cannot tell
+static inline int parport_fifo_empty(struct parport_backend *be) {
+    return be->fifo_empty(be);
+}
+
+#endif // PARPORT_BACKEND_H
@@ -0,0 +1,238 @@
+// File: pin-map.c
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// Loads the axis pin map and builds its lookup
+// table, see pin-map.h
+
+// ==============================================
+// INCLUDE FILE HEADERS
+#include <stdio.h>
+#include <string.h>
+
+#include "pin-map.h"
+
+#define PIN_BIT(pin)    (1u << ((pin) - PIN_MAP_FIRST_PIN))
+#define STATUS_BUSY     0x80        // Pin 11 reads inverted
+
+// ========================================================
+static int status_bit(int pin) {
+// ========================================================
+    // STATUS_REG bit of a DB25 input pin, -1 if not an input
+    switch (pin) {
+        case 15: return 3;      // ERROR
+        case 13: return 4;      // SELECT
+        case 12: return 5;      // PAPER OUT
+        case 10: return 6;      // ACK
+        case 11: return 7;      // BUSY (inverted)
+    }
+    return -1;
+}
+
+// ========================================================
+void pin_map_default(struct pin_map *map) {
+// ========================================================
+    // The original wiring: X on pins 2/3, Y on 4/5, Z on 6/7,
+    // and A on the two spare pins 8/9 without a home switch
+    int axis;
+
+    memset(map, 0, sizeof(*map));
+    for (axis = 0; axis < NUM_AXES; axis++) {
+        map->axis[axis].step_pin = PIN_MAP_FIRST_PIN + 2 * axis;
+        map->axis[axis].dir_pin  = PIN_MAP_FIRST_PIN + 2 * axis + 1;
+        map->axis[axis].home_pin = axis == AXIS_A ? 0 : 10 + axis;
+    }
+    pin_map_build(map);
+}
+
+// ========================================================
+int pin_map_load(struct pin_map *map, const char *path, char *err, size_t err_len) {
+// ========================================================
+    // Read the config file over the default map. Returns 0, or
+    // -1 with a message in err; *map is unchanged on error.
+    // Without the two home columns an axis has no switch.
+    struct pin_map next;
+    struct axis_pins pins;
+    unsigned used = 0, named = 0;
+    char line[256], name;
+    int n, lineno = 0, axis;
+    FILE *fp;
+
+    fp = fopen(path, "r");
+    if (fp == NULL) {
+        snprintf(err, err_len, "cannot open %s", path);
+        return -1;
+    }
+    pin_map_default(&next);
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        lineno++;
+        if (sscanf(line, " %c", &name) != 1 || name == '#')
+            continue;
+        pins.home_pin = pins.home_invert = 0;
+        n = sscanf(line, " %c %d %d %d %d %d %d", &name, &pins.step_pin, &pins.dir_pin,
+                   &pins.step_invert, &pins.dir_invert, &pins.home_pin, &pins.home_invert);
+        if (name >= 'a' && name <= 'z')
+            name -= 'a' - 'A';
+        for (axis = NUM_AXES - 1; axis >= 0 && AXIS_NAME(axis) != name; axis--)
+            ;
+        if (name == 'B' || name == 'C') {
+            snprintf(err, err_len, "%s:%d: rotary axis %c: only X, Y, Z and A can be stepped,"
+                     " on the first port or mirrored/split onto extra ports", path, lineno, name);
+            fclose(fp);
+            return -1;
+        }
+        if ((n != 5 && n != 7) || axis < 0
+            || (pins.home_pin != 0 && status_bit(pins.home_pin) < 0)
+            || ((pins.step_pin != 0 || pins.dir_pin != 0)
+                && (pins.step_pin < PIN_MAP_FIRST_PIN || pins.step_pin > PIN_MAP_LAST_PIN
+                    || pins.dir_pin  < PIN_MAP_FIRST_PIN || pins.dir_pin  > PIN_MAP_LAST_PIN
+                    || pins.step_pin == pins.dir_pin))) {
+            snprintf(err, err_len, "%s:%d: expected \"X|Y|Z|A step-pin dir-pin step-invert dir-invert"
+                     " [home-pin home-invert]\" with pins 2..9 (0 0 = not wired) and 10..13, 15",
+                     path, lineno);
+            fclose(fp);
+            return -1;
+        }
+        pins.step_invert = pins.step_invert != 0;
+        pins.dir_invert  = pins.dir_invert != 0;
+        pins.home_invert = pins.home_invert != 0;
+        next.axis[axis]  = pins;
+        named |= 1u << axis;
+    }
+    fclose(fp);
+
+    // No pin may drive two signals. A keeps its default pins
+    // 8/9 only while the file neither names A nor uses them, so
+    // a three-axis map with an axis on pin 8 or 9 still loads.
+    for (axis = 0; axis < NUM_AXES; axis++) {
+        if (!pin_map_wired(&next, axis))
+            continue;
+        if (axis == AXIS_A && !(named & (1u << axis))
+            && ((used & PIN_BIT(next.axis[axis].step_pin)) || (used & PIN_BIT(next.axis[axis].dir_pin)))) {
+            next.axis[axis].step_pin = next.axis[axis].dir_pin = 0;
+            continue;
+        }
+        if ((used & PIN_BIT(next.axis[axis].step_pin)) || (used & PIN_BIT(next.axis[axis].dir_pin))) {
+            snprintf(err, err_len, "%s: pin %d or %d used twice", path,
+                     next.axis[axis].step_pin, next.axis[axis].dir_pin);
+            return -1;
+        }
+        used |= PIN_BIT(next.axis[axis].step_pin) | PIN_BIT(next.axis[axis].dir_pin);
+    }
+    pin_map_build(&next);
+    *map = next;
+    return 0;
+}
+
+// ========================================================
+void pin_map_build(struct pin_map *map) {
+// ========================================================
+    // Fill lut[] for every logical code and home_lut[] for
+    // every STATUS_REG value
+    const struct axis_pins *pins;
+    unsigned code, byte, status, level;
+    int axis, step, dir;
+
+    for (code = 0; code < PIN_MAP_CODES; code++) {
+        byte = 0;
+        for (axis = 0; axis < NUM_AXES; axis++) {
+            pins = &map->axis[axis];
+            if (!pin_map_wired(map, axis))
+                continue;
+            step = (code & AXIS_STEP_BIT(axis)) != 0;
+            dir  = (code & AXIS_DIR_BIT(axis)) != 0;
+            if (step ^ pins->step_invert)
+                byte |= PIN_BIT(pins->step_pin);
+            if (dir ^ pins->dir_invert)
+                byte |= PIN_BIT(pins->dir_pin);
+        }
+        map->lut[code] = (unsigned char)byte;
+    }
+
+    for (status = 0; status < 256; status++) {
+        byte = 0;
+        for (axis = 0; axis < NUM_AXES; axis++) {
+            pins = &map->axis[axis];
+            if (pins->home_pin == 0)
+                continue;
+            level = ((status ^ STATUS_BUSY) >> status_bit(pins->home_pin)) & 1;
+            if (level == (unsigned)pins->home_invert)
+                byte |= 1u << axis;
+        }
+        map->home_lut[status] = (unsigned char)byte;
+    }
+}
+
+// ========================================================
+unsigned char pin_map_status(const struct pin_map *map, unsigned axes_active) {
+// ========================================================
+    // STATUS_REG as read with the switches of axes_active
+    // (bit a = axis a) closed: used by the simulated port
+    unsigned levels = PIN_MAP_STATUS_IDLE ^ STATUS_BUSY, bit;    // Pin levels, all high
+    int axis;
+
+    for (axis = 0; axis < NUM_AXES; axis++) {
+        if (map->axis[axis].home_pin == 0)
+            continue;
+        bit = 1u << status_bit(map->axis[axis].home_pin);
+        // Active: pin low, or high for home_invert
+        if (((axes_active >> axis) & 1) != (unsigned)map->axis[axis].home_invert)
+            levels &= ~bit;
+        else
+            levels |= bit;
+    }
+    return (unsigned char)(levels ^ STATUS_BUSY);
+}
+
+// ========================================================
+int pin_map_translate(const struct pin_map *from, const struct pin_map *to, unsigned char xlat[256]) {
+// ========================================================
+    // xlat[from byte] = to byte of the same logical code. Bytes
+    // that are no code of from give the idle byte of to.
+    // Returns -1 if to wires an axis that from does not; xlat
+    // is still filled, but that axis never moves through it.
+    unsigned code, byte, from_bits = 0;
+    int axis, ret = 0;
+
+    for (axis = 0; axis < NUM_AXES; axis++) {
+        if (pin_map_wired(from, axis))
+            from_bits |= AXIS_STEP_BIT(axis) | AXIS_DIR_BIT(axis);
+        else if (pin_map_wired(to, axis))
+            ret = -1;
+    }
+    for (byte = 0; byte < 256; byte++)
+        xlat[byte] = to->lut[0];
+    // Only codes that from can tell apart
+    for (code = 0; code < PIN_MAP_CODES; code++)
+        if ((code & ~from_bits) == 0)
+            xlat[from->lut[code]] = to->lut[code];
+    return ret;
+}
+
+// ========================================================
+void pin_map_describe(const struct pin_map *map, unsigned char code_hi, unsigned char code_lo,
+                      char *buf, size_t len) {
+// ========================================================
+    // "(1/0)(1) (0)(0) (0)(0)": level of pins 2, 3, 4, ... in
+    // pairs during the two edges of a step, "1/0" for a pin
+    // that pulses
+    unsigned char hi = pin_map_byte(map, code_hi), lo = pin_map_byte(map, code_lo);
+    unsigned wired = 0;
+    int axis, bit, last, used;
+    size_t n;
+
+    for (axis = 0; axis < NUM_AXES; axis++)
+        if (pin_map_wired(map, axis))
+            wired |= PIN_BIT(map->axis[axis].step_pin) | PIN_BIT(map->axis[axis].dir_pin);
+    last = (wired & 0xc0) ? 7 : 5;       // Show pins 8 and 9 only when wired
+
+    n = 0;
+    buf[0] = '\0';
+    for (bit = 0; bit <= last && n < len; bit++) {
+        used = snprintf(buf + n, len - n, "%s(%s)", bit % 2 == 0 && bit > 0 ? " " : "",
+                        ((hi ^ lo) >> bit) & 1 ? ((hi >> bit) & 1 ? "1/0" : "0/1")
+                                               : ((hi >> bit) & 1 ? "1" : "0"));
+        n += (size_t)used;
+    }
+}
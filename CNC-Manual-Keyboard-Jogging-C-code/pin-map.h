@@ -0,0 +1,131 @@
+// File: pin-map.h
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// Axis to parallel-port pin map. All motion code
+// works on a LOGICAL DATA_REG code with 2 bits per
+// axis (below). One table describes how each axis
+// is wired: the DB25 pin of its step and direction
+// signals and their polarity. It is loaded from a
+// config file at startup and turned into a 256-entry
+// lookup table
+//
+//      lut[logical code] = DATA_REG byte
+//
+// so custom wiring costs one table lookup per edge,
+// done by the pulse compiler when it fills a buffer.
+// The stepping thread still only streams bytes.
+//
+// Each axis may also have a home/limit switch on a
+// STATUS_REG input pin. A second table
+//
+//      home_lut[STATUS_REG] = axes whose switch is active
+//
+// lets the stepping loop check every switch with one
+// read and one lookup.
+//
+// CONFIG FILE (--pin-map=FILE), one axis per line:
+//
+//   # axis  step-pin  dir-pin  step-invert  dir-invert  [home-pin  home-invert]
+//   X       2         3        0            0            10        0
+//   Y       4         5        0            0            11        0
+//   Z       6         7        0            0            12        0
+//   A       8         9        0            0
+//
+// Pins are DB25 data pins 2..9 (DATA_REG bits 0..7).
+// step-invert = 1 : step pulses are active low
+// dir-invert  = 1 : the pin is low for a positive move
+// Home pins are status pins 10, 11, 12, 13 or 15
+// (0 = no switch). Switches are active low (closed to
+// ground, pull-up open); home-invert = 1 for active
+// high. The hardware inversion of pin 11 (BUSY) is
+// taken care of. The lines above are the default wiring.
+//
+// An extra port (--extra-port) has a pin map of its own.
+// There step-pin 0 and dir-pin 0 mean the axis is not
+// wired to that port, e.g. only the slave motor of a
+// gantry axis. The step engine writes first-port bytes;
+// pin_map_translate() gives the table that turns each of
+// them into the extra port's byte, so the first port must
+// wire every axis that any extra port wires.
+//
+// Extra ports therefore mirror the axes or carry part of
+// them (a gantry slave motor, or one axis per driver
+// board); they add no axis of their own. The fourth axis
+// is the rotary A axis (degrees instead of mm). B and C
+// are not covered: the logical code is one DATA_REG byte
+// wide, and a pin map line for either is rejected.
+
+#ifndef PIN_MAP_H
+#define PIN_MAP_H
+
+#include <stddef.h>
+
+// ==================================================================
+// LOGICAL DATA_REG CODE (COORDINATED MULTI-AXIS DDA STEPPING)
+// ==================================================================
+// The logical code carries 2 bits per axis:
+//   X : bit 0 step, bit 1 direction
+//   Y : bit 2 step, bit 3 direction
+//   Z : bit 4 step, bit 5 direction
+//   A : bit 6 step, bit 7 direction
+// A positive delta sets the direction bit (CW), so
+//   X+ = right (3,2)    X- = left (1,0)
+//   Y+ = forward (12,8) Y- = backward (4,0)
+//   Z+ = down (48,32)   Z- = up (16,0)
+//   A+ = CW (192,128)   A- = CCW (64,0)
+// With the default pin map the code is written to
+// DATA_REG unchanged.
+#define AXIS_X          0
+#define AXIS_Y          1
+#define AXIS_Z          2
+#define AXIS_A          3
+#define NUM_AXES        4
+
+#define AXIS_NAME(axis)         ("XYZA"[axis])              // Axis letter
+#define AXIS_STEP_BIT(axis)     (1u << (2 * (axis)))
+#define AXIS_DIR_BIT(axis)      (1u << (2 * (axis) + 1))
+
+#define PIN_MAP_CODES           (1u << (2 * NUM_AXES))  // Logical codes
+#define PIN_MAP_FIRST_PIN       2       // DB25 pin of DATA_REG bit 0
+#define PIN_MAP_LAST_PIN        9       // DB25 pin of DATA_REG bit 7
+#define PIN_MAP_STATUS_IDLE     0x78    // STATUS_REG with every input pin high
+
+struct axis_pins {
+    int         step_pin;       // DB25 pin 2..9, 0 = axis not on this port
+    int         dir_pin;        // DB25 pin 2..9, 0 = axis not on this port
+    int         step_invert;    // Active-low step
+    int         dir_invert;     // Low for a positive move
+    int         home_pin;       // DB25 status pin 10..15, 0 = none
+    int         home_invert;    // Active-high switch
+};
+
+struct pin_map {
+    struct axis_pins axis[NUM_AXES];
+    unsigned char lut[PIN_MAP_CODES];   // Logical code -> DATA_REG byte
+    unsigned char home_lut[256];        // STATUS_REG -> axes with an active switch
+};
+
+// ==================================================================
+// FUNCTION PROTOTYPES
+// ==================================================================
+void    pin_map_default(struct pin_map *map);
+int     pin_map_load(struct pin_map *map, const char *path, char *err, size_t err_len);
+void    pin_map_build(struct pin_map *map);
+unsigned char pin_map_status(const struct pin_map *map, unsigned axes_active);
+int     pin_map_translate(const struct pin_map *from, const struct pin_map *to, unsigned char xlat[256]);
+void    pin_map_describe(const struct pin_map *map, unsigned char code_hi, unsigned char code_lo,
+                         char *buf, size_t len);
+
+// 1 if the axis has step/dir pins on this port
+static inline int pin_map_wired(const struct pin_map *map, int axis) {
+    return map->axis[axis].step_pin != 0;
+}
+
+// DATA_REG byte for a logical code
+static inline unsigned char pin_map_byte(const struct pin_map *map, unsigned char code) {
+    return map->lut[code];
+}
+
+#endif // PIN_MAP_H
@@ -0,0 +1,284 @@
+// File: port-access-bench.c
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// Cost of one parallel port access through each
+// access path of parport-backend.h:
+//
+//   outb    : outb()/inb() after ioperm()
+//   ppdev   : ioctl(PPWDATA) / ioctl(PPRSTATUS)
+//   devport : pwrite()/pread() on /dev/port
+//   sim     : the in-memory simulated port
+//
+// For every path it times each single DATA_REG
+// write and STATUS_REG read into a histogram, then
+// times a burst of back-to-back accesses for the
+// throughput. A "clock" row gives the cost of the
+// two clock reads around each access, which is
+// included in every per-access sample.
+//
+// Paths that cannot be opened (no card, no root)
+// are reported and skipped; sim always runs.
+//
+// DATA_REG is only ever written with 0 (every
+// step and direction line low), so the bench is
+// safe to run with the drives connected.
+//
+// OUTPUT FILE (--out=FILE), one record per line:
+//
+//   # comment
+//   summary <path> <op> <count> <min_ns> <mean_ns> <max_ns> <p99_ns> <p99.9_ns> <p99.99_ns> <ops_per_s>
+//   bucket  <path> <op> <low_ns> <high_ns> <count>
+//
+// with <op> one of write, read-status, clock.
+
+// ==============================================
+// COMPILATION AND EXECUTION INSTRUCTIONS
+// gcc -O2 -o port-access-bench.cx port-access-bench.c parport-backend.c latency-hist.c rt-thread.c -lpthread
+//
+// sudo ./port-access-bench.cx --out=port-access.txt                (every path, default 0x378)
+// sudo ./port-access-bench.cx --backend=outb,devport --samples=200000 --cpumap=0x8
+//      ./port-access-bench.cx --backend=sim                        (no port, no root)
+
+// ==============================================
+// INCLUDE FILE HEADERS
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/io.h>
+
+#include "cnc-time.h"
+#include "parport-backend.h"
+#include "latency-hist.h"
+#include "rt-thread.h"
+
+// ==================================================================
+// BENCH SETTINGS
+// ==================================================================
+#define BENCH_ADDRESS       0x378       // Standard on-board port
+#define BENCH_SAMPLES       1000000     // Timed accesses per path and op
+#define BENCH_WARMUP        10000       // Untimed accesses first
+
+enum bench_op {
+    OP_WRITE = 0,
+    OP_READ_STATUS,
+    OP_CLOCK,
+    NUM_OPS
+};
+
+static const char *op_name[NUM_OPS] = { "write", "read-status", "clock" };
+
+struct bench_result {
+    struct latency_hist hist;
+    double          ops_per_s;      // Back-to-back burst throughput
+};
+
+static const enum parport_backend_kind all_kinds[] = {
+    PARPORT_BACKEND_OUTB, PARPORT_BACKEND_PPDEV, PARPORT_BACKEND_DEVPORT, PARPORT_BACKEND_SIM
+};
+static const char *kind_name[] = { "outb", "ppdev", "devport", "sim" };
+#define NUM_KINDS   (int)(sizeof(all_kinds) / sizeof(all_kinds[0]))
+
+int                 base_address = BENCH_ADDRESS;
+uint32_t            samples      = BENCH_SAMPLES;
+int                 rt_priority  = RT_DEFAULT_PRIORITY;
+unsigned long       rt_cpumap;
+const char         *out_file;
+int                 selected[NUM_KINDS];
+
+// Current path, handed to the bench thread
+struct parport_backend  port;
+struct bench_result     result[NUM_OPS];
+
+// ==================================================================
+static void DTStamp(void) {  // Same date-time stamp as the jogging code
+// ==================================================================
+    struct timespec ts;
+    struct tm *tm_info;
+    char buf[26];
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    tm_info = localtime(&ts.tv_sec);
+    strftime(buf, 26, "%Y-%m-%d %H:%M:%S", tm_info);
+    printf("%s.%09ld \t", buf, (long int)ts.tv_nsec);
+}
+
+// ========================================================
+static void bench_op(struct parport_backend *be, enum bench_op op, struct bench_result *res) {
+// ========================================================
+    // Histogram of single accesses, then one timed burst
+    volatile unsigned char sink;
+    uint64_t t0, t1;
+    uint32_t i;
+
+    latency_hist_init(&res->hist);
+    for (i = 0; i < BENCH_WARMUP; i++) {
+        if (op == OP_WRITE)
+            parport_write(be, 0);
+        else if (op == OP_READ_STATUS)
+            sink = parport_read_status(be);
+    }
+
+    for (i = 0; i < samples; i++) {
+        t0 = monotonic_ns();
+        if (op == OP_WRITE)
+            parport_write(be, 0);
+        else if (op == OP_READ_STATUS)
+            sink = parport_read_status(be);
+        t1 = monotonic_ns();
+        latency_hist_record(&res->hist, (int64_t)(t1 - t0), 0);
+    }
+
+    t0 = monotonic_ns();
+    for (i = 0; i < samples; i++) {
+        if (op == OP_WRITE)
+            parport_write(be, 0);
+        else if (op == OP_READ_STATUS)
+            sink = parport_read_status(be);
+        else
+            sink = (unsigned char)monotonic_ns();
+    }
+    t1 = monotonic_ns();
+    res->ops_per_s = t1 > t0 ? samples * 1e9 / (double)(t1 - t0) : 0.0;
+    (void)sink;
+}
+
+// ========================================================
+static void *bench_thread(void *unused) {
+// ========================================================
+    // Runs with the stepping thread's real-time settings
+    int op;
+
+    (void)unused;
+    for (op = 0; op < NUM_OPS; op++)
+        bench_op(&port, (enum bench_op)op, &result[op]);
+    return NULL;
+}
+
+// ========================================================
+static int open_path(enum parport_backend_kind kind) {
+// ========================================================
+    if (kind == PARPORT_BACKEND_OUTB && ioperm(base_address, 3, 1) != 0)
+        return -1;
+    return parport_backend_open(&port, kind, base_address);
+}
+
+// ========================================================
+static void report_path(FILE *fp) {
+// ========================================================
+    struct latency_summary s;
+    char prefix[64];
+    int op;
+
+    for (op = 0; op < NUM_OPS; op++) {
+        latency_hist_summary(&result[op].hist, &s);
+        DTStamp(); printf("SUCCESS: Display %s %-11s min/mean/p99.9/max \t= %llu / %.1f / %llu / %llu (ns), %.0f ops/s\n",
+            port.name, op_name[op], (unsigned long long)s.min_ns, s.mean_ns,
+            (unsigned long long)s.p999_ns, (unsigned long long)s.max_ns, result[op].ops_per_s);
+        if (fp == NULL)
+            continue;
+        fprintf(fp, "summary %s %s %llu %llu %.1f %llu %llu %llu %llu %.0f\n", port.name, op_name[op],
+            (unsigned long long)s.count, (unsigned long long)s.min_ns, s.mean_ns, (unsigned long long)s.max_ns,
+            (unsigned long long)s.p99_ns, (unsigned long long)s.p999_ns, (unsigned long long)s.p9999_ns,
+            result[op].ops_per_s);
+        snprintf(prefix, sizeof(prefix), "bucket %s %s", port.name, op_name[op]);
+        latency_hist_write_buckets(&result[op].hist, fp, prefix);
+    }
+}
+
+// ==================================================================
+int main(int argc, char *argv[]) {
+// ==================================================================
+    struct rt_thread rt;
+    enum parport_backend_kind kind;
+    char *list, *name, *save;
+    FILE *fp = NULL;
+    int argi, k, err, any = 0;
+
+    for (k = 0; k < NUM_KINDS; k++)
+        selected[k] = 1;
+
+    // COMMAND LINE OPTIONS
+    for (argi = 1; argi < argc; argi++) {
+        if (strncmp(argv[argi], "--backend=", 10) == 0) {
+            memset(selected, 0, sizeof(selected));
+            list = strdup(argv[argi] + 10);
+            for (name = strtok_r(list, ",", &save); name != NULL; name = strtok_r(NULL, ",", &save)) {
+                if (parport_backend_parse(name, &kind) != 0) {
+                    printf("ERROR: Unknown backend %s (use outb, ppdev, devport or sim)\n", name);
+                    exit(1);
+                }
+                for (k = 0; k < NUM_KINDS; k++)
+                    if (all_kinds[k] == kind)
+                        selected[k] = 1;
+            }
+            free(list);
+        } else if (strncmp(argv[argi], "--address=", 10) == 0) {
+            base_address = (int)strtol(argv[argi] + 10, NULL, 0);
+        } else if (strncmp(argv[argi], "--samples=", 10) == 0 && atoi(argv[argi] + 10) > 0) {
+            samples = (uint32_t)atoi(argv[argi] + 10);
+        } else if (strncmp(argv[argi], "--rt-priority=", 14) == 0) {
+            rt_priority = atoi(argv[argi] + 14);
+        } else if (strncmp(argv[argi], "--cpumap=", 9) == 0) {
+            rt_cpumap = strtoul(argv[argi] + 9, NULL, 0);
+        } else if (strncmp(argv[argi], "--out=", 6) == 0) {
+            out_file = argv[argi] + 6;
+        } else {
+            printf("Usage: %s [--backend=outb,ppdev,devport,sim] [--address=0x378] [--samples=N]\n", argv[0]);
+            printf("       [--rt-priority=N] [--cpumap=MASK] [--out=FILE]\n");
+            exit(1);
+        }
+    }
+
+    DTStamp(); printf("Bismillah. Start parallel port access benchmark. \n\n");
+    err = rt_lock_memory();
+    if (err != 0) {
+        DTStamp(); printf("ERROR  : Lock memory mlockall(MCL_CURRENT|MCL_FUTURE) \t= %s\n", strerror(err));
+    }
+    if (out_file != NULL) {
+        fp = fopen(out_file, "w");
+        if (fp == NULL) {
+            DTStamp(); printf("ERROR  : Cannot write %s \t= %s\n", out_file, strerror(errno));
+            exit(1);
+        }
+        fprintf(fp, "# port-access-bench address 0x%X samples %u\n", base_address, samples);
+        fprintf(fp, "# summary path op count min_ns mean_ns max_ns p99_ns p99.9_ns p99.99_ns ops_per_s\n");
+        fprintf(fp, "# bucket path op low_ns high_ns count\n");
+    }
+
+    for (k = 0; k < NUM_KINDS; k++) {
+        if (!selected[k])
+            continue;
+        printf("\n");
+        DTStamp(); printf("EXECUTING  bench %s path (%u samples per op).\n", kind_name[k], samples);
+        if (open_path(all_kinds[k]) != 0) {
+            DTStamp(); printf("ERROR  : Open path, skipped \t= %s\n", strerror(errno));
+            continue;
+        }
+        err = rt_thread_start(&rt, rt_priority, rt_cpumap, bench_thread, NULL);
+        if (err != 0) {
+            DTStamp(); printf("ERROR  : Create bench thread \t= %s\n", strerror(err));
+            parport_backend_close(&port);
+            continue;
+        }
+        if (rt.sched_err != 0) {
+            DTStamp(); printf("ERROR  : Set SCHED_FIFO priority %d \t= %s\n", rt_priority, strerror(rt.sched_err));
+        }
+        pthread_join(rt.tid, NULL);
+        report_path(fp);
+        parport_backend_close(&port);
+        any = 1;
+        DTStamp(); printf("COMPLETED bench %s path.\n", kind_name[k]);
+    }
+
+    if (fp != NULL) {
+        fclose(fp);
+        DTStamp(); printf("SUCCESS: Write access histograms \t= %s\n", out_file);
+    }
+    DTStamp(); printf("Alhamdulillah. Finished parallel port access benchmark. \n\n");
+    return any ? 0 : 1;
+}
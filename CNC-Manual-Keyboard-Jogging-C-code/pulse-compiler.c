@@ -0,0 +1,193 @@
+// File: pulse-compiler.c
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// Compiles moves into (byte, delta) pulse buffers,
+// see pulse-compiler.h
+
+// ==============================================
+// INCLUDE FILE HEADERS
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "pulse-compiler.h"
+
+// ========================================================
+void pulse_pool_init(struct pulse_pool *pool) {
+// ========================================================
+    // Zero everything now so no page is touched for the first time later
+    int i;
+    memset(pool, 0, sizeof(*pool));
+    for (i = 0; i < PULSE_POOL_SIZE; i++)
+        atomic_init(&pool->buf[i].busy, 0);
+}
+
+// ========================================================
+struct pulse_buffer *pulse_pool_acquire(struct pulse_pool *pool) {
+// ========================================================
+    // Compiler side: wait for the next buffer in ring order to be
+    // played, then hand it out empty. Buffers are played in the
+    // order they were queued, so ring order never skips one.
+    struct pulse_buffer *buf = &pool->buf[pool->next];
+
+    while (atomic_load_explicit(&buf->busy, memory_order_acquire))
+        usleep(1000);
+    pool->next = (pool->next + 1) & (PULSE_POOL_SIZE - 1);
+
+    buf->count       = 0;
+    buf->starts_move = 0;
+    atomic_store_explicit(&buf->busy, 1, memory_order_relaxed);
+    return buf;
+}
+
+// ========================================================
+void pulse_buffer_release(struct pulse_buffer *buf) {
+// ========================================================
+    // Stepping thread side: buffer fully played
+    atomic_store_explicit(&buf->busy, 0, memory_order_release);
+}
+
+// ========================================================
+void pulse_compile_begin(struct pulse_compiler *pc, const int32_t delta[NUM_AXES],
+                         const struct ramp_table *ramp, long period_ns, uint32_t reset_edges,
+                         const struct pin_map *map) {
+// ========================================================
+    int axis;
+
+    memset(pc, 0, sizeof(*pc));
+    pc->map        = map;
+    pc->ramp       = ramp;
+    pc->period_ns  = period_ns;
+    pc->reset_left = reset_edges;
+    for (axis = 0; axis < NUM_AXES; axis++) {
+        pc->net[axis]   = delta[axis];
+        pc->steps[axis] = (uint32_t)abs(delta[axis]);
+        if (delta[axis] > 0)
+            pc->dir_bits |= AXIS_DIR_BIT(axis);
+        if (pc->steps[axis] > pc->major)
+            pc->major = pc->steps[axis];
+    }
+    // Start each accumulator half full, so a minor axis steps
+    // in the middle of its interval, within half a step of the line
+    for (axis = 0; axis < NUM_AXES; axis++)
+        pc->error[axis] = pc->major / 2;
+    if (pc->major == 0)
+        pc->setup_done = 1;     // Nothing to step: only the reset edges
+}
+
+// ========================================================
+static unsigned char arc_dir_bits(unsigned char dir_bits, const int step[2]) {
+// ========================================================
+    // Direction bits for the axes that step next; an axis
+    // that does not step keeps its direction
+    int axis;
+    for (axis = AXIS_X; axis <= AXIS_Y; axis++) {
+        if (step[axis] > 0)
+            dir_bits |= AXIS_DIR_BIT(axis);
+        else if (step[axis] < 0)
+            dir_bits &= ~AXIS_DIR_BIT(axis);
+    }
+    return dir_bits;
+}
+
+// ========================================================
+void pulse_compile_begin_arc(struct pulse_compiler *pc, struct arc_stepper *arc, int32_t dz,
+                             long period_ns, uint32_t reset_edges, const struct pin_map *map) {
+// ========================================================
+    // dz Z steps are spread over the arc's ticks by the DDA
+    // (a helix); the caller keeps |dz| within the tick count.
+    memset(pc, 0, sizeof(*pc));
+    pc->map        = map;
+    pc->arc        = arc;
+    pc->period_ns  = period_ns;
+    pc->reset_left = reset_edges;
+    pc->major      = arc_count_ticks(arc);
+    pc->net[AXIS_X] = (int32_t)(arc->xe - arc->x);
+    pc->net[AXIS_Y] = (int32_t)(arc->ye - arc->y);
+    pc->net[AXIS_Z] = dz;
+    pc->steps[AXIS_Z] = (uint32_t)abs(dz);
+    pc->error[AXIS_Z] = pc->major / 2;
+    if (dz > 0)
+        pc->dir_bits = AXIS_DIR_BIT(AXIS_Z);
+    if (arc_step(arc, pc->arc_next))
+        pc->dir_bits = arc_dir_bits(pc->dir_bits, pc->arc_next);
+    if (pc->major == 0)
+        pc->setup_done = 1;
+}
+
+// ========================================================
+int pulse_compile_fill(struct pulse_compiler *pc, struct pulse_buffer *buf) {
+// ========================================================
+    // Append as much of the move as fits into buf.
+    // Returns 1 once the whole move has been compiled.
+    unsigned char step_bits, dir_bits;
+    uint32_t interval, n = buf->count;
+    int axis;
+
+    if (!pc->setup_done && n < PULSE_BUFFER_EDGES) {
+        buf->code[n]     = pc->dir_bits;
+        buf->byte[n]     = pin_map_byte(pc->map, pc->dir_bits);
+        buf->delta_ns[n] = (uint32_t)pc->period_ns;
+        n++;
+        pc->setup_done = 1;
+    }
+
+    while (pc->tick < pc->major && n + 2 <= PULSE_BUFFER_EDGES) {
+        step_bits = 0;
+        dir_bits  = pc->dir_bits;
+        if (pc->arc != NULL) {
+            // Arc: this tick's steps, then look one tick ahead
+            // for the direction the low edge should carry; Z
+            // (a helix) by the DDA against the arc's ticks
+            if (pc->arc_next[0]) step_bits |= AXIS_STEP_BIT(AXIS_X);
+            if (pc->arc_next[1]) step_bits |= AXIS_STEP_BIT(AXIS_Y);
+            if (arc_step(pc->arc, pc->arc_next))
+                pc->dir_bits = arc_dir_bits(pc->dir_bits, pc->arc_next);
+            pc->error[AXIS_Z] += pc->steps[AXIS_Z];
+            if (pc->error[AXIS_Z] >= pc->major) {
+                pc->error[AXIS_Z] -= pc->major;
+                step_bits |= AXIS_STEP_BIT(AXIS_Z);
+            }
+        } else {
+            // Bresenham/DDA: the major axis steps every tick, the
+            // others whenever their error accumulator overflows.
+            for (axis = 0; axis < NUM_AXES; axis++) {
+                pc->error[axis] += pc->steps[axis];
+                if (pc->error[axis] >= pc->major) {
+                    pc->error[axis] -= pc->major;
+                    step_bits |= AXIS_STEP_BIT(axis);
+                }
+            }
+        }
+        if (pc->plan != NULL)
+            interval = profile_plan_interval_ns(pc->plan, pc->tick, pc->major);
+        else if (pc->ramp != NULL)
+            interval = profile_interval_ns(pc->ramp, pc->tick, pc->major);
+        else
+            interval = 2 * (uint32_t)pc->period_ns;
+        if (interval < pc->min_interval_ns)
+            interval = pc->min_interval_ns;
+
+        buf->code[n]     = dir_bits | step_bits;
+        buf->byte[n]     = pin_map_byte(pc->map, dir_bits | step_bits);
+        buf->delta_ns[n] = interval / 2;
+        buf->code[n + 1]     = pc->dir_bits;
+        buf->byte[n + 1]     = pin_map_byte(pc->map, pc->dir_bits);
+        buf->delta_ns[n + 1] = interval - interval / 2;
+        n += 2;
+        pc->tick++;
+    }
+
+    while (pc->tick == pc->major && pc->reset_left > 0 && n < PULSE_BUFFER_EDGES) {
+        buf->code[n]     = 0;
+        buf->byte[n]     = pin_map_byte(pc->map, 0);
+        buf->delta_ns[n] = (uint32_t)pc->period_ns;
+        n++;
+        pc->reset_left--;
+    }
+
+    buf->count = n;
+    return pc->setup_done && pc->tick == pc->major && pc->reset_left == 0;
+}
@@ -0,0 +1,111 @@
+// File: pulse-compiler.h
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// Pulse-train compiler. A move (DDA interpolation
+// plus its acceleration ramp plus the trailing
+// reset_CNC() zeros) is compiled ahead of time into
+// a preallocated buffer of
+//
+//      (DATA_REG byte, ns until the next edge)
+//
+// pairs. The stepping thread then only streams the
+// buffer: write byte, wait, next entry. No branching
+// on axes and no arithmetic in the hot loop, so the
+// per-edge cost is constant.
+//
+// Long moves are compiled in chunks into a small pool
+// of buffers, so the next chunk (or the next move) is
+// compiled while the current one plays.
+
+#ifndef PULSE_COMPILER_H
+#define PULSE_COMPILER_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+#include "motion-profile.h"
+#include "arc-stepper.h"
+#include "pin-map.h"
+
+// ==================================================================
+// EDGES OF A MOVE
+// ==================================================================
+// Every tick lasts two edges. The first edge writes
+// the direction bits OR'ed with the step bits of every
+// axis due in this tick, the second edge writes the
+// direction bits alone. All axes therefore share a
+// single DATA_REG write per edge. One direction-only
+// setup edge precedes the first step pulse. Bits are
+// the logical code of pin-map.h; each edge is stored
+// as pin_map_byte(map, code).
+//
+// With ramp == NULL every edge lasts one PERIOD (the
+// old fixed 1 kHz rate). Otherwise tick i lasts
+// profile_interval_ns(ramp, i, ticks), so the move
+// accelerates, cruises and decelerates. A nonzero
+// min_interval_ns caps the speed below the ramp's
+// cruise rate (the G1 feed rate): the ramp is cut
+// off where it reaches that interval. A non-NULL plan
+// replaces the ramp with the planner's trapezoid, see
+// motion-planner.h.
+//
+// Arcs (pulse_compile_begin_arc) take the X/Y steps of
+// each tick from the arc stepper instead of the DDA.
+// Directions change along an arc, so the second edge
+// of every tick already writes the direction bits of
+// the next tick: half a tick of direction setup time.
+
+// ==================================================================
+// PULSE BUFFERS
+// ==================================================================
+#define PULSE_BUFFER_EDGES      16384   // Edges per buffer
+#define PULSE_POOL_SIZE         4       // Buffers in flight (power of 2)
+#define PULSE_RESET_EDGES       10      // Zero edges of reset_CNC()
+
+struct pulse_buffer {
+    atomic_int  busy;           // 1 from compile until the stepping thread has played it
+    int         starts_move;    // First chunk of a move: restart the timeline
+    uint32_t    count;          // Edges used
+    unsigned char byte[PULSE_BUFFER_EDGES];       // DATA_REG value of edge i
+    unsigned char code[PULSE_BUFFER_EDGES];       // Logical code of edge i (position, limits)
+    uint32_t    delta_ns[PULSE_BUFFER_EDGES];     // Wait after edge i
+};
+
+struct pulse_pool {
+    uint32_t    next;           // Next buffer the compiler will try (producer only)
+    struct pulse_buffer buf[PULSE_POOL_SIZE];
+};
+
+// Incremental compile state of one move
+struct pulse_compiler {
+    uint32_t    steps[NUM_AXES];
+    uint32_t    error[NUM_AXES];
+    uint32_t    major;          // Ticks in the move
+    uint32_t    tick;           // Next tick to compile
+    uint32_t    reset_left;     // Trailing zero edges still to emit
+    unsigned char dir_bits;
+    int         setup_done;     // Direction setup edge emitted
+    long        period_ns;
+    uint32_t    min_interval_ns;    // Feed limit per tick, 0 = ramp only
+    const struct ramp_table *ramp;
+    const struct plan_profile *plan;    // Planned segment, overrides ramp
+    const struct pin_map *map;          // Logical code -> DATA_REG byte
+    struct arc_stepper *arc;            // G2/G3 arc, replaces the DDA
+    int         arc_next[2];            // X/Y steps of the next arc tick
+    int32_t     net[NUM_AXES];          // Signed steps of the whole move (trace markers)
+};
+
+void    pulse_pool_init(struct pulse_pool *pool);
+struct pulse_buffer *pulse_pool_acquire(struct pulse_pool *pool);
+void    pulse_buffer_release(struct pulse_buffer *buf);
+
+void    pulse_compile_begin(struct pulse_compiler *pc, const int32_t delta[NUM_AXES],
+                            const struct ramp_table *ramp, long period_ns, uint32_t reset_edges,
+                            const struct pin_map *map);
+void    pulse_compile_begin_arc(struct pulse_compiler *pc, struct arc_stepper *arc, int32_t dz,
+                                long period_ns, uint32_t reset_edges, const struct pin_map *map);
+int     pulse_compile_fill(struct pulse_compiler *pc, struct pulse_buffer *buf);
+
+#endif // PULSE_COMPILER_H
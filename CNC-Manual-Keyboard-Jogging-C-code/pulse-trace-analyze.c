@@ -0,0 +1,622 @@
+// File: pulse-trace-analyze.c
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// Offline check of a pulse trace (--capture, see
+// pulse-trace.h) against the timing a step/dir drive
+// needs. The trace's own pin map decodes each axis.
+// It reports:
+//
+//   - step rate per axis over time: the peak rate of
+//     any window, and with --freq-out one line per window
+//   - shortest step high and low time per axis, and the
+//     pulses shorter than --min-high / --min-low
+//   - direction setup violations: an active step edge
+//     less than --dir-setup after the direction changed
+//   - direction hold violations: a direction change less
+//     than --dir-hold after an active step edge
+//   - steps per axis, and for every compiled move (MOVE
+//     marker) the net steps against the commanded ones
+//   - identical consecutive writes: two bytes that should
+//     have formed an edge but left every pin as it was,
+//     like the (1,0) and (16,0) pairs of drive_left() and
+//     drive_up() when the pins they share are all zero.
+//     Writes of the idle byte (reset_CNC()) are counted
+//     apart. FIFO traces repeat bytes by design.
+//
+// Speed: the record words are scanned 8 at a time with
+// GCC vector extensions. For a block without escapes the
+// vector pass gives every lane its time (prefix sum of
+// the deltas), the watched (step or dir) pins it changes,
+// the level they change to and whether it repeats the
+// write before; these become 8-bit lane masks. Repeats
+// are counted from the masks, and the per-axis width,
+// setup and hold checks run only for the lanes with an
+// edge, found by count-trailing-zeros on the edge mask.
+// A block without an edge never reaches them. The file
+// is read sequentially in 4 MB chunks, never mapped as
+// a whole.
+//
+// OUTPUT FILE (--freq-out=FILE), one line per window:
+//
+//   <t_s> <x_steps_per_s> <y_steps_per_s> <z_steps_per_s> <a_steps_per_s>
+
+// ==============================================
+// COMPILATION AND EXECUTION INSTRUCTIONS
+// gcc -O3 -march=native -o pulse-trace-analyze.cx pulse-trace-analyze.c pulse-trace.c pin-map.c -lpthread
+//
+// ./pulse-trace-analyze.cx job.trace
+// ./pulse-trace-analyze.cx --dir-setup=5000 --dir-hold=2500 --min-high=2500 --min-low=2500 job.trace
+// ./pulse-trace-analyze.cx --window=10 --freq-out=rate.txt --show=20 job.trace
+
+// ==============================================
+// INCLUDE FILE HEADERS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "cnc-time.h"
+#include "pulse-trace.h"
+
+// ==================================================================
+// ANALYZER SETTINGS
+// ==================================================================
+// Defaults are common microstepping drive figures; take the real
+// ones from the drive's data sheet.
+#define DEFAULT_DIR_SETUP_NS    5000
+#define DEFAULT_DIR_HOLD_NS     2500
+#define DEFAULT_MIN_HIGH_NS     2500
+#define DEFAULT_MIN_LOW_NS      2500
+#define DEFAULT_WINDOW_MS       100
+#define DEFAULT_SHOW            5       // Violations listed per kind and axis
+#define BLOCK_WORDS             8       // Words per vector block
+
+typedef uint32_t v8u __attribute__((vector_size(BLOCK_WORDS * sizeof(uint32_t))));
+typedef int32_t  v8i __attribute__((vector_size(BLOCK_WORDS * sizeof(int32_t))));     // Lane masks
+
+enum violation {
+    VIOL_SETUP = 0,
+    VIOL_HOLD,
+    VIOL_HIGH,
+    VIOL_LOW,
+    NUM_VIOL
+};
+
+static const char *viol_name[NUM_VIOL] = { "dir setup", "dir hold", "step high", "step low" };
+
+struct axis_track {
+    unsigned    step_bit, dir_bit;      // DATA_REG bit masks
+    unsigned    step_inv, dir_inv;      // Byte value of an inactive line
+    int         wired;
+
+    int         level;                  // Logical step line
+    int         dir;                    // Logical direction, 1 = positive
+    int         have_rise, have_fall, have_dir;
+    uint64_t    t_rise, t_fall, t_dir;
+
+    uint64_t    rises;
+    int64_t     net;
+    int64_t     seg_net;                // Net steps since the last marker
+    uint64_t    min_high_ns, min_low_ns, min_period_ns;
+    uint64_t    viol[NUM_VIOL];
+    uint64_t    win_rises;
+    double      peak_rate;
+    int64_t     commanded;              // Sum of the MOVE markers
+};
+
+// Settings
+uint64_t            dir_setup_ns = DEFAULT_DIR_SETUP_NS;
+uint64_t            dir_hold_ns  = DEFAULT_DIR_HOLD_NS;
+uint64_t            min_high_ns  = DEFAULT_MIN_HIGH_NS;
+uint64_t            min_low_ns   = DEFAULT_MIN_LOW_NS;
+uint64_t            window_ns    = (uint64_t)DEFAULT_WINDOW_MS * 1000000;
+uint64_t            show         = DEFAULT_SHOW;
+const char         *freq_file;
+
+// Analysis state
+struct axis_track   axis_tr[NUM_AXES];
+unsigned            watch;              // Step and dir bits of the wired axes
+unsigned            invert;             // Watched bits that are active low
+unsigned char       idle_byte;
+unsigned char       prev_byte;
+int                 have_prev;
+uint64_t            t_ns;               // Time of the last write (after t0)
+uint64_t            t_first;
+uint64_t            writes, marks, blocks_fast, blocks_slow;
+uint64_t            same_idle, same_active;     // Identical consecutive writes
+uint64_t            run_len, max_run;           // Of identical non-idle writes
+uint64_t            first_same_ns;
+uint64_t            win_start;
+FILE               *freq_fp;
+
+// Compiled-move check
+int                 seg_move;           // A MOVE marker is open
+int32_t             seg_cmd[NUM_AXES];
+uint64_t            seg_t, moves, move_bad;
+
+// ========================================================
+static void DTStamp(void) {  // Same date-time stamp as the jogging code
+// ========================================================
+    struct timespec ts;
+    struct tm *tm_info;
+    char buf[26];
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    tm_info = localtime(&ts.tv_sec);
+    strftime(buf, 26, "%Y-%m-%d %H:%M:%S", tm_info);
+    printf("%s.%09ld \t", buf, (long int)ts.tv_nsec);
+}
+
+// ========================================================
+static void violation(struct axis_track *at, int axis, enum violation v, uint64_t t, uint64_t ns) {
+// ========================================================
+    if (at->viol[v]++ < show) {
+        printf("         t = %.9f s  %c-axis %-9s %llu ns\n", t / 1e9, AXIS_NAME(axis), viol_name[v],
+            (unsigned long long)ns);
+    }
+}
+
+// ========================================================
+static void advance_windows(uint64_t t) {
+// ========================================================
+    // Close every rate window that ends at or before t
+    struct axis_track *at;
+    double rate[NUM_AXES];
+    int axis;
+
+    while (t >= win_start + window_ns) {
+        for (axis = 0; axis < NUM_AXES; axis++) {
+            at = &axis_tr[axis];
+            rate[axis] = at->win_rises * 1e9 / window_ns;
+            if (rate[axis] > at->peak_rate)
+                at->peak_rate = rate[axis];
+            at->win_rises = 0;
+        }
+        if (freq_fp != NULL) {
+            fprintf(freq_fp, "%.3f %.0f %.0f %.0f %.0f\n", (win_start - t_first) / 1e9,
+                rate[AXIS_X], rate[AXIS_Y], rate[AXIS_Z], rate[AXIS_A]);
+        }
+        win_start += window_ns;
+    }
+}
+
+// ========================================================
+static void end_segment(void) {
+// ========================================================
+    // Compare the steps since the last MOVE marker with it
+    int axis, bad = 0;
+
+    if (seg_move) {
+        for (axis = 0; axis < NUM_AXES; axis++)
+            if (axis_tr[axis].wired && axis_tr[axis].seg_net != seg_cmd[axis])
+                bad = 1;
+        if (bad && move_bad++ < show) {
+            printf("         t = %.9f s  move commanded %d / %d / %d / %d, stepped %lld / %lld / %lld / %lld\n",
+                seg_t / 1e9, seg_cmd[AXIS_X], seg_cmd[AXIS_Y], seg_cmd[AXIS_Z], seg_cmd[AXIS_A],
+                (long long)axis_tr[AXIS_X].seg_net, (long long)axis_tr[AXIS_Y].seg_net,
+                (long long)axis_tr[AXIS_Z].seg_net, (long long)axis_tr[AXIS_A].seg_net);
+        }
+    }
+    seg_move = 0;
+    for (axis = 0; axis < NUM_AXES; axis++)
+        axis_tr[axis].seg_net = 0;
+}
+
+// ========================================================
+static void on_mark(const struct pulse_trace_event *ev) {
+// ========================================================
+    int axis;
+
+    marks++;
+    end_segment();
+    if (ev->mark != PULSE_TRACE_MARK_MOVE)
+        return;
+    seg_move = 1;
+    seg_t    = ev->t_ns;
+    moves++;
+    for (axis = 0; axis < NUM_AXES; axis++) {
+        seg_cmd[axis] = ev->arg[axis];
+        axis_tr[axis].commanded += ev->arg[axis];
+    }
+}
+
+// ========================================================
+static void axis_dir_change(struct axis_track *at, int axis, uint64_t t, int dir) {
+// ========================================================
+    if (at->have_rise && t - at->t_rise < dir_hold_ns)
+        violation(at, axis, VIOL_HOLD, t, t - at->t_rise);
+    at->dir = dir;
+    at->t_dir = t;
+    at->have_dir = 1;
+}
+
+// ========================================================
+static void axis_step_edge(struct axis_track *at, int axis, uint64_t t, int level) {
+// ========================================================
+    at->level = level;
+    if (level) {
+        // Active edge: the drive takes a step
+        if (at->have_dir && t - at->t_dir < dir_setup_ns)
+            violation(at, axis, VIOL_SETUP, t, t - at->t_dir);
+        if (at->have_fall) {
+            if (t - at->t_fall < at->min_low_ns)
+                at->min_low_ns = t - at->t_fall;
+            if (t - at->t_fall < min_low_ns)
+                violation(at, axis, VIOL_LOW, t, t - at->t_fall);
+        }
+        if (at->have_rise && t - at->t_rise < at->min_period_ns)
+            at->min_period_ns = t - at->t_rise;
+        advance_windows(t);
+        at->win_rises++;
+        at->rises++;
+        at->net     += at->dir ? 1 : -1;
+        at->seg_net += at->dir ? 1 : -1;
+        at->t_rise = t;
+        at->have_rise = 1;
+    } else if (at->have_rise) {
+        if (t - at->t_rise < at->min_high_ns)
+            at->min_high_ns = t - at->t_rise;
+        if (t - at->t_rise < min_high_ns)
+            violation(at, axis, VIOL_HIGH, t, t - at->t_rise);
+        at->t_fall = t;
+        at->have_fall = 1;
+    }
+}
+
+// ========================================================
+static void on_change(uint64_t t, unsigned char byte, unsigned changed) {
+// ========================================================
+    // A write that changes at least one watched pin
+    unsigned logic = byte ^ invert;
+    struct axis_track *at;
+    int axis;
+
+    for (axis = 0; axis < NUM_AXES; axis++) {
+        at = &axis_tr[axis];
+        if (changed & at->dir_bit)
+            axis_dir_change(at, axis, t, (logic & at->dir_bit) != 0);
+        if (changed & at->step_bit)
+            axis_step_edge(at, axis, t, (logic & at->step_bit) != 0);
+    }
+}
+
+// ========================================================
+static void on_write(uint64_t t, unsigned char byte) {
+// ========================================================
+    unsigned changed;
+
+    writes++;
+    if (!have_prev) {
+        // Levels as the trace starts, no edges yet
+        have_prev = 1;
+        prev_byte = byte;
+        t_first = win_start = t;
+        for (int axis = 0; axis < NUM_AXES; axis++) {
+            axis_tr[axis].level = ((byte & axis_tr[axis].step_bit) != 0) ^ (axis_tr[axis].step_inv != 0);
+            axis_tr[axis].dir   = ((byte & axis_tr[axis].dir_bit) != 0) ^ (axis_tr[axis].dir_inv != 0);
+        }
+        return;
+    }
+    if (byte == prev_byte) {
+        if (byte == idle_byte) {
+            same_idle++;
+        } else {
+            if (same_active++ == 0)
+                first_same_ns = t;
+            if (++run_len > max_run)
+                max_run = run_len;
+        }
+        return;
+    }
+    run_len = 0;
+    changed = (byte ^ prev_byte) & watch;
+    prev_byte = byte;
+    if (changed)
+        on_change(t, byte, changed);
+}
+
+// ========================================================
+static unsigned lane_mask(const v8i *m) {
+// ========================================================
+    // Bit k set where lane k of a comparison is true (by
+    // pointer: a 32-byte vector argument has no stable ABI)
+    unsigned bits = 0, k;
+
+    for (k = 0; k < BLOCK_WORDS; k++)
+        bits |= (unsigned)((*m)[k] & 1) << k;
+    return bits;
+}
+
+// ========================================================
+static void count_runs(unsigned m_run, unsigned m_break) {
+// ========================================================
+    // Identical non-idle writes (m_run) extend the current
+    // run; any write that differs (m_break) ends it
+    unsigned k, below;
+
+    while (m_break != 0) {
+        k = (unsigned)__builtin_ctz(m_break);
+        m_break &= m_break - 1;
+        below = (1u << k) - 1;
+        run_len += (unsigned)__builtin_popcount(m_run & below);
+        if (run_len > max_run)
+            max_run = run_len;
+        run_len = 0;
+        m_run &= ~((below << 1) | 1);
+    }
+    run_len += (unsigned)__builtin_popcount(m_run);
+    if (run_len > max_run)
+        max_run = run_len;
+}
+
+// ========================================================
+static int scan_block(const uint32_t *w) {
+// ========================================================
+    // Vector pass over 8 plain words. Returns 0 if the block
+    // holds an escape (the caller decodes it record by record).
+    const v8u shift1 = { 8, 0, 1, 2, 3, 4, 5, 6 };    // Lane i gets lane i - 1, or the 2nd operand
+    const v8u shift2 = { 8, 8, 0, 1, 2, 3, 4, 5 };
+    const v8u shift4 = { 8, 8, 8, 8, 0, 1, 2, 3 };
+    const v8u zero   = { 0 };
+    unsigned m_step[NUM_AXES], m_dir[NUM_AXES], m_step_hi[NUM_AXES], m_dir_hi[NUM_AXES];
+    unsigned m_same, m_idle, m_run, m_edge, k;
+    struct axis_track *at;
+    v8u cur, byte, prv, ts, changed, logic;
+    v8i cmp;
+    uint64_t t;
+    int axis;
+
+    memcpy(&cur, w, sizeof(cur));
+    cmp = cur >= PULSE_TRACE_ESC_MARK << 8;
+    if (lane_mask(&cmp) != 0)
+        return 0;
+
+    // Lane times: running sum of the deltas (8 x 24 bits fits in 32)
+    ts  = cur >> 8;
+    ts += __builtin_shuffle(ts, zero, shift1);
+    ts += __builtin_shuffle(ts, zero, shift2);
+    ts += __builtin_shuffle(ts, zero, shift4);
+
+    // Lane bytes against the byte before each of them
+    byte    = cur & 0xff;
+    prv     = __builtin_shuffle(byte, zero + prev_byte, shift1);
+    changed = (byte ^ prv) & watch;
+    cmp     = byte == prv;
+    m_same  = lane_mask(&cmp);
+    cmp     = byte == idle_byte;
+    m_idle  = m_same & lane_mask(&cmp);
+    cmp     = changed != 0;
+    m_edge  = lane_mask(&cmp);
+
+    writes    += BLOCK_WORDS;
+    same_idle += (unsigned)__builtin_popcount(m_idle);
+    m_run = m_same & ~m_idle;
+    if (m_run != 0) {
+        if (same_active == 0)
+            first_same_ns = t_ns + ts[__builtin_ctz(m_run)];
+        same_active += (unsigned)__builtin_popcount(m_run);
+    }
+    count_runs(m_run, ~m_same & ((1u << BLOCK_WORDS) - 1));
+
+    if (m_edge == 0) {
+        blocks_fast++;
+    } else {
+        // Per-axis lane masks, then the checks edge by edge in time order
+        blocks_slow++;
+        logic = byte ^ invert;
+        for (axis = 0; axis < NUM_AXES; axis++) {
+            at = &axis_tr[axis];
+            cmp = (changed & at->step_bit) != 0;
+            m_step[axis] = lane_mask(&cmp);
+            cmp = (changed & at->dir_bit) != 0;
+            m_dir[axis] = lane_mask(&cmp);
+            cmp = (logic & at->step_bit) != 0;
+            m_step_hi[axis] = lane_mask(&cmp);
+            cmp = (logic & at->dir_bit) != 0;
+            m_dir_hi[axis] = lane_mask(&cmp);
+        }
+        while (m_edge != 0) {
+            k = (unsigned)__builtin_ctz(m_edge);
+            m_edge &= m_edge - 1;
+            t = t_ns + ts[k];
+            for (axis = 0; axis < NUM_AXES; axis++) {
+                at = &axis_tr[axis];
+                if ((m_dir[axis] >> k) & 1)
+                    axis_dir_change(at, axis, t, (m_dir_hi[axis] >> k) & 1);
+                if ((m_step[axis] >> k) & 1)
+                    axis_step_edge(at, axis, t, (m_step_hi[axis] >> k) & 1);
+            }
+        }
+    }
+    t_ns     += ts[BLOCK_WORDS - 1];
+    prev_byte = (unsigned char)byte[BLOCK_WORDS - 1];
+    return 1;
+}
+
+// ========================================================
+static int analyze(struct pulse_trace_reader *rd) {
+// ========================================================
+    // Vector blocks where possible, the record decoder where
+    // an escape or the first write needs it
+    struct pulse_trace_event ev;
+    int avail, r;
+
+    for (;;) {
+        avail = pulse_trace_fill(rd, PULSE_TRACE_READ_WORDS / 2);
+        if (avail < 0)
+            return -1;
+        if (avail == 0)
+            return 0;
+        while (have_prev && rd->count - rd->pos >= BLOCK_WORDS) {
+            if (!scan_block(rd->buf + rd->pos))
+                break;
+            rd->pos += BLOCK_WORDS;
+        }
+        // One record through the decoder (escape, start or tail)
+        rd->t_ns = t_ns;
+        r = pulse_trace_next(rd, &ev);
+        if (r < 0)
+            return -1;
+        if (r == 0)
+            return 0;
+        if (ev.mark != 0) {
+            on_mark(&ev);
+        } else {
+            t_ns = ev.t_ns;
+            on_write(t_ns, ev.byte);
+        }
+    }
+}
+
+// ========================================================
+static void report(const struct pulse_trace_reader *rd, double cpu_s) {
+// ========================================================
+    struct axis_track *at;
+    double secs = (t_ns - t_first) / 1e9;
+    int axis, v;
+
+    DTStamp(); printf("SUCCESS: Display trace writes/markers/moves \t= %llu / %llu / %llu over %.3f s\n",
+        (unsigned long long)writes, (unsigned long long)marks, (unsigned long long)moves, secs);
+    if (rd->hdr.dropped > 0 || !rd->hdr.complete) {
+        DTStamp(); printf("ERROR  : Trace incomplete \t= %llu records dropped%s\n",
+            (unsigned long long)rd->hdr.dropped, rd->hdr.complete ? "" : ", not closed");
+    }
+    for (axis = 0; axis < NUM_AXES; axis++) {
+        at = &axis_tr[axis];
+        if (!at->wired)
+            continue;
+        DTStamp(); printf("SUCCESS: Display %c-axis steps net/commanded \t= %llu steps, %lld / %lld\n", AXIS_NAME(axis),
+            (unsigned long long)at->rises, (long long)at->net, (long long)at->commanded);
+        if (at->rises == 0)
+            continue;
+        DTStamp(); printf("SUCCESS: Display %c-axis peak rate/shortest period \t= %.0f steps/s / %llu ns\n",
+            AXIS_NAME(axis), at->peak_rate, (unsigned long long)(at->min_period_ns != UINT64_MAX ? at->min_period_ns : 0));
+        DTStamp(); printf("SUCCESS: Display %c-axis shortest high/low \t= %llu / %llu (ns)\n", AXIS_NAME(axis),
+            (unsigned long long)(at->min_high_ns != UINT64_MAX ? at->min_high_ns : 0),
+            (unsigned long long)(at->min_low_ns != UINT64_MAX ? at->min_low_ns : 0));
+        for (v = 0; v < NUM_VIOL; v++) {
+            if (at->viol[v] == 0)
+                continue;
+            DTStamp(); printf("ERROR  : %c-axis %s violations \t= %llu\n", AXIS_NAME(axis), viol_name[v],
+                (unsigned long long)at->viol[v]);
+        }
+    }
+    if (move_bad > 0) {
+        DTStamp(); printf("ERROR  : Moves stepped differently from commanded \t= %llu of %llu\n",
+            (unsigned long long)move_bad, (unsigned long long)moves);
+    } else if (moves > 0) {
+        DTStamp(); printf("SUCCESS: Display moves stepped as commanded \t= %llu\n", (unsigned long long)moves);
+    }
+    DTStamp(); printf("SUCCESS: Display identical writes idle/other \t= %llu / %llu\n",
+        (unsigned long long)same_idle, (unsigned long long)same_active);
+    if (same_active > 0) {
+        DTStamp(); printf("ERROR  : Writes that changed no pin \t= %llu (first at %.9f s, longest run %llu)\n",
+            (unsigned long long)same_active, (first_same_ns - t_first) / 1e9, (unsigned long long)max_run);
+    }
+    DTStamp(); printf("SUCCESS: Display analysis time \t= %.3f s CPU, %.0f MB/s, %.1f%% of blocks skipped\n",
+        cpu_s, cpu_s > 0 ? rd->words * 4 / cpu_s / 1e6 : 0.0,
+        blocks_fast + blocks_slow ? 100.0 * blocks_fast / (blocks_fast + blocks_slow) : 0.0);
+}
+
+// ==================================================================
+int main(int argc, char *argv[]) {
+// ==================================================================
+    struct pulse_trace_reader rd;
+    struct pin_map map;
+    struct axis_track *at;
+    const char *path = NULL;
+    uint64_t cpu0;
+    int argi, axis, err;
+
+    // COMMAND LINE OPTIONS
+    for (argi = 1; argi < argc; argi++) {
+        if (strncmp(argv[argi], "--dir-setup=", 12) == 0) {
+            dir_setup_ns = strtoull(argv[argi] + 12, NULL, 0);
+        } else if (strncmp(argv[argi], "--dir-hold=", 11) == 0) {
+            dir_hold_ns = strtoull(argv[argi] + 11, NULL, 0);
+        } else if (strncmp(argv[argi], "--min-high=", 11) == 0) {
+            min_high_ns = strtoull(argv[argi] + 11, NULL, 0);
+        } else if (strncmp(argv[argi], "--min-low=", 10) == 0) {
+            min_low_ns = strtoull(argv[argi] + 10, NULL, 0);
+        } else if (strncmp(argv[argi], "--window=", 9) == 0 && atoi(argv[argi] + 9) > 0) {
+            window_ns = (uint64_t)atoi(argv[argi] + 9) * 1000000;
+        } else if (strncmp(argv[argi], "--freq-out=", 11) == 0) {
+            freq_file = argv[argi] + 11;
+        } else if (strncmp(argv[argi], "--show=", 7) == 0) {
+            show = strtoull(argv[argi] + 7, NULL, 0);
+        } else if (argv[argi][0] != '-' && path == NULL) {
+            path = argv[argi];
+        } else {
+            path = NULL;
+            break;
+        }
+    }
+    if (path == NULL) {
+        printf("Usage: %s [--dir-setup=NS] [--dir-hold=NS] [--min-high=NS] [--min-low=NS]\n", argv[0]);
+        printf("       [--window=MS] [--freq-out=FILE] [--show=N] TRACE\n");
+        exit(1);
+    }
+
+    DTStamp(); printf("Bismillah. Start pulse trace analysis. \n\n");
+    if (pulse_trace_open(&rd, path) != 0) {
+        DTStamp(); printf("ERROR  : Open trace file %s \t= %s\n", path,
+            errno == EPROTO ? "not a pulse trace of this version" : strerror(errno));
+        exit(1);
+    }
+    if (freq_file != NULL && (freq_fp = fopen(freq_file, "w")) == NULL) {
+        DTStamp(); printf("ERROR  : Cannot write %s \t= %s\n", freq_file, strerror(errno));
+        exit(1);
+    }
+
+    // Decode with the pin map the trace was recorded with
+    pulse_trace_pin_map(&rd.hdr, &map);
+    idle_byte = pin_map_byte(&map, 0);
+    for (axis = 0; axis < NUM_AXES; axis++) {
+        at = &axis_tr[axis];
+        at->wired = pin_map_wired(&map, axis);
+        at->min_high_ns = at->min_low_ns = at->min_period_ns = UINT64_MAX;
+        if (!at->wired)
+            continue;
+        at->step_bit = 1u << (map.axis[axis].step_pin - PIN_MAP_FIRST_PIN);
+        at->dir_bit  = 1u << (map.axis[axis].dir_pin - PIN_MAP_FIRST_PIN);
+        at->step_inv = map.axis[axis].step_invert;
+        at->dir_inv  = map.axis[axis].dir_invert;
+        watch |= at->step_bit | at->dir_bit;
+        if (at->step_inv)
+            invert |= at->step_bit;
+        if (at->dir_inv)
+            invert |= at->dir_bit;
+        DTStamp(); printf("SUCCESS: Display %c-axis step/dir pins \t= %d%s / %d%s\n", AXIS_NAME(axis),
+            map.axis[axis].step_pin, at->step_inv ? " (active low)" : "",
+            map.axis[axis].dir_pin, at->dir_inv ? " (inverted)" : "");
+    }
+    DTStamp(); printf("SUCCESS: Display trace file \t= %s (%llu words, %s backend, PERIOD %u ns)\n", path,
+        (unsigned long long)rd.words, rd.hdr.backend, rd.hdr.period_ns);
+    DTStamp(); printf("SUCCESS: Display limits setup/hold/high/low \t= %llu / %llu / %llu / %llu (ns)\n",
+        (unsigned long long)dir_setup_ns, (unsigned long long)dir_hold_ns,
+        (unsigned long long)min_high_ns, (unsigned long long)min_low_ns);
+
+    printf("\n");
+    DTStamp(); printf("EXECUTING  analysis of %s.\n", path);
+    cpu0 = thread_cpu_ns();
+    err = analyze(&rd);
+    end_segment();
+    if (have_prev)
+        advance_windows(t_ns + window_ns);      // Close the last window
+    if (err != 0) {
+        DTStamp(); printf("ERROR  : Trace read error or cut-off record after %llu writes\n",
+            (unsigned long long)writes);
+    }
+    report(&rd, (thread_cpu_ns() - cpu0) / 1e9);
+    pulse_trace_close_reader(&rd);
+    if (freq_fp != NULL) {
+        fclose(freq_fp);
+        DTStamp(); printf("SUCCESS: Write step rates per window \t= %s\n", freq_file);
+    }
+    DTStamp(); printf("COMPLETED analysis of %s.\n", path);
+    DTStamp(); printf("Alhamdulillah. Finished pulse trace analysis. \n\n");
+    return err != 0 ? 1 : 0;
+}
@@ -0,0 +1,396 @@
+// File: pulse-trace.c
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// Capture and read-back of DATA_REG write traces,
+// see pulse-trace.h
+
+// ==============================================
+// INCLUDE FILE HEADERS
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "cnc-time.h"
+#include "pulse-trace.h"
+
+_Static_assert(sizeof(struct pulse_trace_header) == 128, "trace header layout");
+
+#define RING_MASK       (PULSE_TRACE_RING_WORDS - 1)
+#define GAP_MASK        ((1u << PULSE_TRACE_GAP_SHIFT) - 1)
+
+// ==================================================================
+// CAPTURE: PRODUCER SIDE (the thread writing the port)
+// ==================================================================
+
+// ========================================================
+static int ring_push(struct pulse_trace *tr, const uint32_t *w, unsigned n) {
+// ========================================================
+    // All n words or none, so a record is never split
+    uint64_t head = atomic_load_explicit(&tr->head, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&tr->tail, memory_order_acquire);
+    unsigned i;
+
+    if (PULSE_TRACE_RING_WORDS - (head - tail) < n) {
+        tr->dropped++;
+        return -1;
+    }
+    for (i = 0; i < n; i++)
+        tr->ring[(head + i) & RING_MASK] = w[i];
+    atomic_store_explicit(&tr->head, head + n, memory_order_release);
+    return 0;
+}
+
+// ========================================================
+void pulse_trace_record(struct pulse_trace *tr, uint64_t t_ns, unsigned char value) {
+// ========================================================
+    // One DATA_REG write. A write that is dropped leaves
+    // last_ns alone, so the next delta covers it.
+    uint64_t delta = t_ns > tr->last_ns ? t_ns - tr->last_ns : 0;
+    uint32_t w[3];
+    unsigned n = 0;
+
+    if (delta > PULSE_TRACE_DELTA_MAX) {
+        w[n++] = PULSE_TRACE_ESC_GAP << 8;
+        w[n++] = (uint32_t)(delta >> PULSE_TRACE_GAP_SHIFT);
+        delta &= GAP_MASK;
+    }
+    w[n++] = (uint32_t)delta << 8 | value;
+    if (ring_push(tr, w, n) != 0)
+        return;
+    if (t_ns > tr->last_ns)
+        tr->last_ns = t_ns;
+    tr->writes++;
+}
+
+// ========================================================
+void pulse_trace_tap(void *arg, uint64_t t_ns, unsigned char value) {
+// ========================================================
+    // Signature of the port's tap
+    pulse_trace_record(arg, t_ns, value);
+}
+
+// ========================================================
+void pulse_trace_mark(struct pulse_trace *tr, int type, int32_t a0, int32_t a1, int32_t a2, int32_t a3) {
+// ========================================================
+    uint32_t w[5];
+
+    w[0] = PULSE_TRACE_ESC_MARK << 8 | (uint8_t)type;
+    w[1] = (uint32_t)a0;
+    w[2] = (uint32_t)a1;
+    w[3] = (uint32_t)a2;
+    w[4] = (uint32_t)a3;
+    if (ring_push(tr, w, 5) == 0)
+        tr->marks++;
+}
+
+// ==================================================================
+// CAPTURE: WRITER THREAD
+// ==================================================================
+
+// ========================================================
+static int map_window(struct pulse_trace *tr, uint64_t first) {
+// ========================================================
+    // Grow the file and map words [first, first + WINDOW_WORDS)
+    off_t offset = PULSE_TRACE_DATA_OFFSET + (off_t)first * 4;
+    size_t len = (size_t)PULSE_TRACE_WINDOW_WORDS * 4;
+
+    if (tr->window != NULL)
+        munmap(tr->window, len);
+    tr->window = NULL;
+    if (ftruncate(tr->fd, offset + (off_t)len) != 0)
+        return -1;
+    tr->window = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, tr->fd, offset);
+    if (tr->window == MAP_FAILED) {
+        tr->window = NULL;
+        return -1;
+    }
+    tr->window_first = first;
+    return 0;
+}
+
+// ========================================================
+static void write_header(struct pulse_trace *tr) {
+// ========================================================
+    // Counters are the producer's; a slightly stale copy is fine
+    tr->hdr.words   = tr->words;
+    tr->hdr.writes  = tr->writes;
+    tr->hdr.marks   = tr->marks;
+    tr->hdr.dropped = tr->dropped;
+    if (pwrite(tr->fd, &tr->hdr, sizeof(tr->hdr), 0) == (ssize_t)sizeof(tr->hdr))
+        tr->flushed_words = tr->words;
+}
+
+// ========================================================
+static uint64_t drain(struct pulse_trace *tr) {
+// ========================================================
+    // Copy everything in the ring to the file, returns the words
+    // copied (0 while the file cannot grow)
+    uint64_t head = atomic_load_explicit(&tr->head, memory_order_acquire);
+    uint64_t tail = atomic_load_explicit(&tr->tail, memory_order_relaxed);
+    uint64_t moved = 0, n, room;
+
+    if (head - tail > tr->max_fill)
+        tr->max_fill = head - tail;
+    while (tail < head) {
+        if (tr->words - tr->window_first == PULSE_TRACE_WINDOW_WORDS
+            && map_window(tr, tr->words) != 0)
+            break;                      // Disk full: the ring fills up and drops
+        if (tr->window == NULL)
+            break;
+        n    = head - tail;
+        room = PULSE_TRACE_RING_WORDS - (tail & RING_MASK);     // To the end of the ring
+        if (n > room)
+            n = room;
+        room = PULSE_TRACE_WINDOW_WORDS - (tr->words - tr->window_first);
+        if (n > room)
+            n = room;
+        memcpy(tr->window + (tr->words - tr->window_first), tr->ring + (tail & RING_MASK), n * 4);
+        tr->words += n;
+        tail      += n;
+        moved     += n;
+        atomic_store_explicit(&tr->tail, tail, memory_order_release);
+    }
+    return moved;
+}
+
+// ========================================================
+static void *writer_main(void *data) {
+// ========================================================
+    struct pulse_trace *tr = data;
+    struct timespec ts = { 0, PULSE_TRACE_IDLE_NS };
+    int stop;
+
+    for (;;) {
+        // Read stop first: whatever was pushed before it is drained,
+        // unless the file cannot grow, which close reports
+        stop = atomic_load_explicit(&tr->stop, memory_order_acquire);
+        if (drain(tr) != 0)
+            continue;
+        if (stop)
+            break;
+        if (tr->words != tr->flushed_words)
+            write_header(tr);
+        nanosleep(&ts, NULL);
+    }
+    return NULL;
+}
+
+// ========================================================
+int pulse_trace_create(struct pulse_trace *tr, const char *path, const struct pin_map *map,
+                       uint32_t period_ns, const char *backend) {
+// ========================================================
+    // Create the file and start the writer. Returns 0, or -1
+    // with errno set.
+    struct timespec wall;
+    int axis, err;
+
+    memset(tr, 0, sizeof(*tr));
+    atomic_init(&tr->head, 0);
+    atomic_init(&tr->tail, 0);
+    atomic_init(&tr->stop, 0);
+    tr->ring = malloc(PULSE_TRACE_RING_WORDS * sizeof(*tr->ring));
+    if (tr->ring == NULL)
+        return -1;
+    // Touch every page now so the producer never page-faults
+    memset(tr->ring, 0, PULSE_TRACE_RING_WORDS * sizeof(*tr->ring));
+
+    tr->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (tr->fd < 0 || map_window(tr, 0) != 0)
+        goto fail;
+
+    memcpy(&tr->hdr, PULSE_TRACE_MAGIC, sizeof(tr->hdr.magic));   // magic is the first field
+    tr->hdr.version     = PULSE_TRACE_VERSION;
+    tr->hdr.data_offset = PULSE_TRACE_DATA_OFFSET;
+    tr->hdr.period_ns   = period_ns;
+    strncpy(tr->hdr.backend, backend, sizeof(tr->hdr.backend) - 1);
+    for (axis = 0; axis < NUM_AXES; axis++) {
+        tr->hdr.axis[axis].step_pin    = (int8_t)map->axis[axis].step_pin;
+        tr->hdr.axis[axis].dir_pin     = (int8_t)map->axis[axis].dir_pin;
+        tr->hdr.axis[axis].step_invert = (int8_t)map->axis[axis].step_invert;
+        tr->hdr.axis[axis].dir_invert  = (int8_t)map->axis[axis].dir_invert;
+    }
+    clock_gettime(CLOCK_REALTIME, &wall);
+    tr->hdr.wall_s  = wall.tv_sec;
+    tr->hdr.t0_ns   = monotonic_ns();
+    tr->last_ns     = tr->hdr.t0_ns;
+    write_header(tr);
+
+    err = pthread_create(&tr->writer, NULL, writer_main, tr);
+    if (err != 0) {
+        errno = err;
+        goto fail;
+    }
+    return 0;
+
+fail:
+    err = errno;
+    if (tr->window != NULL)
+        munmap(tr->window, (size_t)PULSE_TRACE_WINDOW_WORDS * 4);
+    if (tr->fd >= 0)
+        close(tr->fd);
+    free(tr->ring);
+    tr->ring = NULL;
+    errno = err;
+    return -1;
+}
+
+// ========================================================
+int pulse_trace_close(struct pulse_trace *tr) {
+// ========================================================
+    // Drain, cut the file to size and mark it complete.
+    // The port's tap must already be off.
+    int err = 0;
+
+    atomic_store_explicit(&tr->stop, 1, memory_order_release);
+    pthread_join(tr->writer, NULL);
+    if (atomic_load(&tr->head) != atomic_load(&tr->tail))
+        err = ENOSPC;                   // Writer could not map more of the file
+    if (tr->window != NULL)
+        munmap(tr->window, (size_t)PULSE_TRACE_WINDOW_WORDS * 4);
+    tr->window = NULL;
+    if (ftruncate(tr->fd, PULSE_TRACE_DATA_OFFSET + (off_t)tr->words * 4) != 0 && err == 0)
+        err = errno;
+    tr->hdr.complete = err == 0;
+    write_header(tr);
+    if (close(tr->fd) != 0 && err == 0)
+        err = errno;
+    free(tr->ring);
+    tr->ring = NULL;
+    errno = err;
+    return err == 0 ? 0 : -1;
+}
+
+// ==================================================================
+// READING
+// ==================================================================
+
+// ========================================================
+int pulse_trace_open(struct pulse_trace_reader *rd, const char *path) {
+// ========================================================
+    // Returns 0, or -1 with errno set (EPROTO: not a trace of
+    // this version)
+    struct stat sb;
+    uint64_t in_file;
+
+    memset(rd, 0, sizeof(*rd));
+    rd->fd = open(path, O_RDONLY);
+    if (rd->fd < 0)
+        return -1;
+    posix_fadvise(rd->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    if (fstat(rd->fd, &sb) != 0
+        || pread(rd->fd, &rd->hdr, sizeof(rd->hdr), 0) != (ssize_t)sizeof(rd->hdr)
+        || memcmp(rd->hdr.magic, PULSE_TRACE_MAGIC, sizeof(rd->hdr.magic)) != 0
+        || rd->hdr.version != PULSE_TRACE_VERSION
+        || rd->hdr.data_offset != PULSE_TRACE_DATA_OFFSET) {
+        close(rd->fd);
+        rd->fd = -1;
+        errno = EPROTO;
+        return -1;
+    }
+    // An unfinished trace: trust the header, not the file size
+    in_file   = sb.st_size > PULSE_TRACE_DATA_OFFSET ? (uint64_t)(sb.st_size - PULSE_TRACE_DATA_OFFSET) / 4 : 0;
+    rd->words = rd->hdr.words < in_file ? rd->hdr.words : in_file;
+    rd->buf   = malloc(PULSE_TRACE_READ_WORDS * sizeof(*rd->buf));
+    if (rd->buf == NULL) {
+        close(rd->fd);
+        rd->fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+// ========================================================
+int pulse_trace_fill(struct pulse_trace_reader *rd, uint32_t min_words) {
+// ========================================================
+    // Make at least min_words undecoded words available in
+    // buf[pos..count) if the file has them. Returns the words
+    // available, or -1 on a read error.
+    uint64_t want;
+    ssize_t got;
+
+    if (rd->count - rd->pos >= min_words || rd->file_pos >= rd->words)
+        return (int)(rd->count - rd->pos);
+    memmove(rd->buf, rd->buf + rd->pos, (size_t)(rd->count - rd->pos) * 4);
+    rd->count -= rd->pos;
+    rd->pos    = 0;
+    want = rd->words - rd->file_pos;
+    if (want > PULSE_TRACE_READ_WORDS - rd->count)
+        want = PULSE_TRACE_READ_WORDS - rd->count;
+    got = pread(rd->fd, rd->buf + rd->count, (size_t)want * 4,
+                PULSE_TRACE_DATA_OFFSET + (off_t)rd->file_pos * 4);
+    if (got < 0)
+        return -1;
+    rd->count    += (uint32_t)(got / 4);
+    rd->file_pos += (uint64_t)got / 4;
+    return (int)(rd->count - rd->pos);
+}
+
+// ========================================================
+int pulse_trace_next(struct pulse_trace_reader *rd, struct pulse_trace_event *ev) {
+// ========================================================
+    // Decode one event. Returns 1, 0 at the end of the trace,
+    // -1 on a read error or a record cut off by the end.
+    uint32_t w, d;
+    int avail = pulse_trace_fill(rd, 5);
+
+    if (avail <= 0)
+        return avail;
+    w = rd->buf[rd->pos++];
+    d = w >> 8;
+    if (d == PULSE_TRACE_ESC_MARK) {
+        if (avail < 5)
+            return -1;
+        ev->mark   = w & 0xff;
+        ev->byte   = 0;
+        ev->arg[0] = (int32_t)rd->buf[rd->pos++];
+        ev->arg[1] = (int32_t)rd->buf[rd->pos++];
+        ev->arg[2] = (int32_t)rd->buf[rd->pos++];
+        ev->arg[3] = (int32_t)rd->buf[rd->pos++];
+        ev->t_ns   = rd->t_ns;
+        return 1;
+    }
+    if (d == PULSE_TRACE_ESC_GAP) {
+        if (avail < 3)
+            return -1;
+        rd->t_ns += (uint64_t)rd->buf[rd->pos++] << PULSE_TRACE_GAP_SHIFT;
+        w = rd->buf[rd->pos++];
+        d = w >> 8;
+    }
+    rd->t_ns += d;
+    ev->mark  = 0;
+    ev->byte  = (unsigned char)w;
+    ev->t_ns  = rd->t_ns;
+    return 1;
+}
+
+// ========================================================
+void pulse_trace_pin_map(const struct pulse_trace_header *hdr, struct pin_map *map) {
+// ========================================================
+    // Pin map the trace was recorded with (no switches)
+    int axis;
+
+    memset(map, 0, sizeof(*map));
+    for (axis = 0; axis < NUM_AXES; axis++) {
+        map->axis[axis].step_pin    = hdr->axis[axis].step_pin;
+        map->axis[axis].dir_pin     = hdr->axis[axis].dir_pin;
+        map->axis[axis].step_invert = hdr->axis[axis].step_invert;
+        map->axis[axis].dir_invert  = hdr->axis[axis].dir_invert;
+    }
+    pin_map_build(map);
+}
+
+// ========================================================
+void pulse_trace_close_reader(struct pulse_trace_reader *rd) {
+// ========================================================
+    if (rd->fd >= 0)
+        close(rd->fd);
+    rd->fd = -1;
+    free(rd->buf);
+    rd->buf = NULL;
+}
@@ -0,0 +1,156 @@
+// File: pulse-trace.h
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// Compact binary trace of every DATA_REG write, for
+// finding out afterwards what the port really put on
+// the pins (--capture) and for playing it back through
+// any backend (--replay).
+//
+// CAPTURE: the port's tap (parport-backend.h) hands
+// each write to pulse_trace_record() on the thread
+// that wrote it. The record is delta-encoded into one
+// 32-bit word and pushed into a lock-free ring; a
+// background writer thread moves the ring into the
+// trace file through a memory-mapped window. The step
+// loop never blocks and never makes a syscall: when
+// the ring is full the record is dropped and counted,
+// and the time of the next record still comes out
+// right. Only one thread may write the port (and so
+// the trace) at a time, as for the port itself.
+//
+// FILE FORMAT (little endian):
+//
+//   bytes 0..4095 : struct pulse_trace_header, zero padded
+//   then          : uint32_t record words
+//
+// A record word is (delta << 8) | byte:
+//
+//   delta 0 .. 0xFFFFFD : a write of byte, delta ns after
+//                         the previous write (the first
+//                         one after t0_ns)
+//   delta 0xFFFFFE      : marker of type byte, followed by
+//                         4 int32_t arguments; it applies
+//                         to the writes after it
+//   delta 0xFFFFFF      : long gap, followed by one word
+//                         with the gap >> 23; the write
+//                         after it adds its own delta
+//                         (always < 2^23)
+//
+// The writer rewrites the header (words) whenever the
+// ring runs empty, so a trace cut short by a crash is
+// readable up to its last flush.
+
+#ifndef PULSE_TRACE_H
+#define PULSE_TRACE_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "pin-map.h"
+
+#define PULSE_TRACE_MAGIC           "CNCTRACE"
+#define PULSE_TRACE_VERSION         2
+#define PULSE_TRACE_DATA_OFFSET     4096            // First record word (page aligned)
+#define PULSE_TRACE_RING_WORDS      (1u << 20)      // Capture ring, 4 MB (power of 2)
+#define PULSE_TRACE_WINDOW_WORDS    (1u << 22)      // Mapped part of the file, 16 MB
+#define PULSE_TRACE_READ_WORDS      (1u << 20)      // Reader buffer, 4 MB
+#define PULSE_TRACE_IDLE_NS         1000000         // Writer sleep when the ring is empty
+
+#define PULSE_TRACE_DELTA_MAX       0xFFFFFDu
+#define PULSE_TRACE_ESC_MARK        0xFFFFFEu
+#define PULSE_TRACE_ESC_GAP         0xFFFFFFu
+#define PULSE_TRACE_GAP_SHIFT       23
+
+// Marker types
+enum pulse_trace_mark {
+    PULSE_TRACE_MARK_MOVE  = 1,     // Compiled move, args = net steps X, Y, Z, A
+    PULSE_TRACE_MARK_JOG   = 2,     // Continuous jog, args = direction X, Y, Z, A
+    PULSE_TRACE_MARK_HOME  = 3,     // Homing, arg 0 = axis
+    PULSE_TRACE_MARK_RESET = 4      // reset_CNC()
+};
+
+struct pulse_trace_header {
+    char        magic[8];           // PULSE_TRACE_MAGIC, no NUL
+    uint32_t    version;
+    uint32_t    data_offset;        // PULSE_TRACE_DATA_OFFSET
+    uint64_t    t0_ns;              // CLOCK_MONOTONIC time the deltas start from
+    int64_t     wall_s;             // CLOCK_REALTIME at t0 (seconds)
+    uint64_t    words;              // Record words written so far
+    uint64_t    writes;             // DATA_REG writes recorded
+    uint64_t    marks;              // Markers recorded
+    uint64_t    dropped;            // Records lost to a full ring
+    uint32_t    period_ns;          // PERIOD of the driver that recorded it
+    uint32_t    complete;           // 1 once closed cleanly
+    char        backend[16];        // Output backend that was written
+    struct {
+        int8_t  step_pin;           // Pin map of the port (see pin-map.h)
+        int8_t  dir_pin;
+        int8_t  step_invert;
+        int8_t  dir_invert;
+    } axis[NUM_AXES];
+    uint8_t     reserved[128 - 104];
+};
+
+// Writing side
+struct pulse_trace {
+    // Producer (the thread writing the port)
+    _Alignas(64) atomic_uint_fast64_t head;     // Words pushed
+    uint64_t    last_ns;                        // Time of the last write recorded
+    uint64_t    writes;
+    uint64_t    marks;
+    uint64_t    dropped;
+
+    // Consumer (writer thread)
+    _Alignas(64) atomic_uint_fast64_t tail;     // Words taken
+    uint64_t    max_fill;                       // Fullest the ring has been (words)
+
+    uint32_t    *ring;
+    int         fd;
+    uint32_t    *window;                        // Mapped file words [window_first, +WINDOW_WORDS)
+    uint64_t    window_first;
+    uint64_t    words;                          // Words in the file
+    uint64_t    flushed_words;                  // words at the last header rewrite
+    struct pulse_trace_header hdr;
+    atomic_int  stop;
+    pthread_t   writer;
+};
+
+// Reading side
+struct pulse_trace_reader {
+    int         fd;
+    struct pulse_trace_header hdr;
+    uint64_t    words;              // Record words in the file
+    uint64_t    file_pos;           // Next word to read from the file
+    uint32_t    *buf;               // Words buf[pos .. count) not yet decoded
+    uint32_t    pos;
+    uint32_t    count;
+    uint64_t    t_ns;               // Time of the last write decoded (after t0_ns)
+};
+
+struct pulse_trace_event {
+    uint64_t    t_ns;               // After t0_ns
+    int         mark;               // 0 = DATA_REG write, else enum pulse_trace_mark
+    unsigned char byte;             // Write: byte written
+    int32_t     arg[NUM_AXES];      // Marker arguments
+};
+
+// ==================================================================
+// FUNCTION PROTOTYPES
+// ==================================================================
+int     pulse_trace_create(struct pulse_trace *tr, const char *path, const struct pin_map *map,
+                           uint32_t period_ns, const char *backend);
+void    pulse_trace_record(struct pulse_trace *tr, uint64_t t_ns, unsigned char value);
+void    pulse_trace_tap(void *arg, uint64_t t_ns, unsigned char value);
+void    pulse_trace_mark(struct pulse_trace *tr, int type, int32_t a0, int32_t a1, int32_t a2, int32_t a3);
+int     pulse_trace_close(struct pulse_trace *tr);
+
+int     pulse_trace_open(struct pulse_trace_reader *rd, const char *path);
+int     pulse_trace_fill(struct pulse_trace_reader *rd, uint32_t min_words);
+int     pulse_trace_next(struct pulse_trace_reader *rd, struct pulse_trace_event *ev);
+void    pulse_trace_pin_map(const struct pulse_trace_header *hdr, struct pin_map *map);
+void    pulse_trace_close_reader(struct pulse_trace_reader *rd);
+
+#endif // PULSE_TRACE_H
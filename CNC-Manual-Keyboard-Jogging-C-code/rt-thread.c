@@ -0,0 +1,144 @@
+// File: rt-thread.c
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// Real-time thread bring-up, see rt-thread.h
+
+// ==============================================
+// INCLUDE FILE HEADERS
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "rt-thread.h"
+
+// ========================================================
+int rt_lock_memory(void) {
+// ========================================================
+    // Lock current and future pages so the stepping loop
+    // never waits on a page fault. Returns 0 or errno.
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+        return errno;
+    return 0;
+}
+
+// ========================================================
+void rt_prefault_stack(void) {
+// ========================================================
+    // Touch the first RT_STACK_PREFAULT bytes of the stack
+    // now, while page faults are still harmless. One volatile
+    // store per page, so the compiler cannot drop them.
+    volatile unsigned char dummy[RT_STACK_PREFAULT];
+    long page = sysconf(_SC_PAGESIZE);
+    size_t i;
+
+    if (page <= 0)
+        page = 4096;
+    for (i = 0; i < sizeof(dummy); i += (size_t)page)
+        dummy[i] = 0;
+    dummy[sizeof(dummy) - 1] = 0;
+}
+
+// ========================================================
+static int cpus_are_isolated(unsigned long cpumap) {
+// ========================================================
+    // Compare cpumap against /sys/devices/system/cpu/isolated
+    // (a list like "3" or "2-3,6").
+    char line[256];
+    unsigned long isolated = 0;
+    char *p;
+    FILE *fp = fopen("/sys/devices/system/cpu/isolated", "r");
+
+    if (fp == NULL)
+        return 0;
+    if (fgets(line, sizeof(line), fp) == NULL) {
+        fclose(fp);
+        return 0;
+    }
+    fclose(fp);
+
+    p = line;
+    while (*p >= '0' && *p <= '9') {
+        long first = strtol(p, &p, 10), last = first, cpu;
+        if (*p == '-')
+            last = strtol(p + 1, &p, 10);
+        for (cpu = first; cpu <= last && cpu < (long)(8 * sizeof(long)); cpu++)
+            isolated |= 1UL << cpu;
+        if (*p == ',')
+            p++;
+    }
+    return cpumap != 0 && (cpumap & ~isolated) == 0;
+}
+
+// ========================================================
+static void *rt_thread_entry(void *data) {
+// ========================================================
+    struct rt_thread *rt = data;
+    struct sched_param param;
+    cpu_set_t cpus;
+    unsigned int cpu;
+
+    // STEP (a) CPU affinity from CPUMAP
+    rt->affinity_err = 0;
+    if (rt->cpumap != 0) {
+        CPU_ZERO(&cpus);
+        for (cpu = 0; cpu < 8 * sizeof(rt->cpumap); cpu++)
+            if (rt->cpumap & (1UL << cpu))
+                CPU_SET(cpu, &cpus);
+        rt->affinity_err = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    }
+    rt->cpus_isolated = cpus_are_isolated(rt->cpumap);
+
+    // STEP (b) SCHED_FIFO priority
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = rt->priority;
+    rt->sched_err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+
+    // STEP (c) prefault the stack before any real-time work
+    rt_prefault_stack();
+
+    pthread_mutex_lock(&rt->lock);
+    rt->ready = 1;
+    pthread_cond_signal(&rt->cond);
+    pthread_mutex_unlock(&rt->lock);
+
+    return rt->fn(rt->arg);
+}
+
+// ========================================================
+int rt_thread_start(struct rt_thread *rt, int priority, unsigned long cpumap,
+                    void *(*fn)(void *), void *arg) {
+// ========================================================
+    // Start fn(arg) on a real-time thread and wait until it
+    // has applied its settings. Returns 0 or the
+    // pthread_create() error.
+    pthread_attr_t attr;
+    int err;
+
+    rt->priority = priority;
+    rt->cpumap   = cpumap;
+    rt->fn       = fn;
+    rt->arg      = arg;
+    rt->ready    = 0;
+    pthread_mutex_init(&rt->lock, NULL);
+    pthread_cond_init(&rt->cond, NULL);
+
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, RT_STACK_SIZE);
+    err = pthread_create(&rt->tid, &attr, rt_thread_entry, rt);
+    pthread_attr_destroy(&attr);
+    if (err != 0)
+        return err;
+
+    pthread_mutex_lock(&rt->lock);
+    while (!rt->ready)
+        pthread_cond_wait(&rt->cond, &rt->lock);
+    pthread_mutex_unlock(&rt->lock);
+    return 0;
+}
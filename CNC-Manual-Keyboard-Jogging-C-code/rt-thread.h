@@ -0,0 +1,51 @@
+// File: rt-thread.h
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// Real-time thread bring-up for the stepping loop:
+//   (1) mlockall(MCL_CURRENT|MCL_FUTURE)
+//   (2) SCHED_FIFO with a configurable priority
+//   (3) CPU affinity from the CPUMAP bit mask
+//       (bit n = CPU n, e.g. 0x8 = CPU 3, which
+//       should be the core given to isolcpus=)
+//   (4) prefaulted stack
+// Each step is recorded so the caller can report
+// SUCCESS or ERROR for it at startup. A failed
+// step is not fatal: the thread still runs, only
+// with weaker real-time guarantees.
+
+#ifndef RT_THREAD_H
+#define RT_THREAD_H
+
+#include <pthread.h>
+
+#define RT_DEFAULT_PRIORITY     80              // SCHED_FIFO priority (1..99)
+#define RT_STACK_SIZE           (256 * 1024)    // Stepping thread stack (bytes)
+#define RT_STACK_PREFAULT       (64 * 1024)     // Stack touched at thread start
+
+struct rt_thread {
+    pthread_t       tid;
+    int             priority;       // Requested SCHED_FIFO priority
+    unsigned long   cpumap;         // Requested CPU bit mask (0 = do not pin)
+
+    void            *(*fn)(void *);
+    void            *arg;
+
+    // Result of each bring-up step (0 = success, else errno)
+    int             affinity_err;
+    int             sched_err;
+    int             cpus_isolated;  // 1 if every CPU in cpumap is in isolcpus
+
+    // Startup handshake with the creating thread
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    int             ready;
+};
+
+int     rt_lock_memory(void);
+int     rt_thread_start(struct rt_thread *rt, int priority, unsigned long cpumap,
+                        void *(*fn)(void *), void *arg);
+void    rt_prefault_stack(void);
+
+#endif // RT_THREAD_H
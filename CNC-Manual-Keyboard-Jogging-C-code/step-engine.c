@@ -0,0 +1,524 @@
+// File: step-engine.c
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// Absolute-deadline step timing, see step-engine.h
+
+// ==============================================
+// INCLUDE FILE HEADERS
+#include <errno.h>
+#include <string.h>
+
+#include "cnc-time.h"
+#include "step-engine.h"
+
+// ==================================================================
+static inline void timespec_add_ns(struct timespec *ts, long ns) {
+// ==================================================================
+    ts->tv_nsec += ns;
+    while (ts->tv_nsec >= NSEC_PER_SEC) {
+        ts->tv_nsec -= NSEC_PER_SEC;
+        ts->tv_sec++;
+    }
+}
+
+// ==================================================================
+static inline int64_t timespec_diff_ns(const struct timespec *a, const struct timespec *b) {
+// ==================================================================
+    // Returns a - b in nanoseconds
+    return (int64_t)(a->tv_sec - b->tv_sec) * NSEC_PER_SEC + (a->tv_nsec - b->tv_nsec);
+}
+
+// ========================================================
+void step_timeline_init(struct step_timeline *tl, long period_ns) {
+// ========================================================
+    memset(tl, 0, sizeof(*tl));
+    tl->period_ns = period_ns;
+    tl->margin_ns = HYBRID_MARGIN_NS;
+}
+
+// ========================================================
+void step_timeline_start(struct step_timeline *tl) {
+// ========================================================
+    // The first edge is written immediately; the timeline
+    // starts from the moment the move begins.
+    clock_gettime(CLOCK_MONOTONIC, &tl->next);
+    tl->start_ns = (uint64_t)tl->next.tv_sec * NSEC_PER_SEC + (uint64_t)tl->next.tv_nsec;
+}
+
+// ========================================================
+static void step_timeline_spin(struct step_timeline *tl, long interval_ns) {
+// ========================================================
+    // Sleep until margin_ns (at most half the edge interval)
+    // before tl->next, then spin up to it, adapting the
+    // margin to the wake-up latency
+    int64_t deadline, wake, now, woke, want, margin;
+    struct timespec ts;
+
+    margin = tl->margin_ns;
+    if (margin > interval_ns / 2)
+        margin = interval_ns / 2;
+    if (margin < HYBRID_MARGIN_MIN_NS)
+        margin = HYBRID_MARGIN_MIN_NS;
+
+    deadline = (int64_t)tl->next.tv_sec * NSEC_PER_SEC + tl->next.tv_nsec;
+    now      = (int64_t)monotonic_ns();
+    if (deadline - now > margin) {
+        wake = deadline - margin;
+        ts.tv_sec  = (time_t)(wake / NSEC_PER_SEC);
+        ts.tv_nsec = (long)(wake % NSEC_PER_SEC);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+            ;
+        now  = (int64_t)monotonic_ns();
+        woke = now - wake;
+        tl->wakes++;
+        if (woke > tl->max_wake_ns)
+            tl->max_wake_ns = woke;
+        if (now > deadline)
+            tl->overshoots++;
+
+        want = woke + HYBRID_GUARD_NS;
+        if (want > tl->margin_ns)
+            tl->margin_ns = want;
+        else
+            tl->margin_ns -= (tl->margin_ns - want) >> HYBRID_DECAY_SHIFT;
+        if (tl->margin_ns < HYBRID_MARGIN_MIN_NS)
+            tl->margin_ns = HYBRID_MARGIN_MIN_NS;
+        if (tl->margin_ns > HYBRID_MARGIN_MAX_NS)
+            tl->margin_ns = HYBRID_MARGIN_MAX_NS;
+    } else if (tl->margin_ns > HYBRID_MARGIN_MIN_NS) {
+        // Spin only: no wake-up to learn from, decay anyway
+        tl->margin_ns -= (tl->margin_ns - HYBRID_MARGIN_MIN_NS) >> HYBRID_DECAY_SHIFT;
+    }
+    if (now >= deadline)
+        return;
+
+    tl->spin_ns += (uint64_t)(deadline - now);
+    if (tl->tsc != NULL && tl->tsc->ok)
+        tsc_spin_ns(tl->tsc, deadline - now);
+    while ((int64_t)monotonic_ns() < deadline)
+        ;
+}
+
+// ========================================================
+int64_t step_timeline_wait(struct step_timeline *tl) {
+// ========================================================
+    return step_timeline_wait_ns(tl, tl->period_ns);
+}
+
+// ========================================================
+int64_t step_timeline_wait_ns(struct step_timeline *tl, long interval_ns) {
+// ========================================================
+    // Sleep until the previous deadline + interval_ns and
+    // return how late (ns) we woke up compared with it.
+    struct timespec now;
+    int64_t late;
+
+    timespec_add_ns(&tl->next, interval_ns);
+    if (tl->mode == STEP_WAIT_HYBRID) {
+        step_timeline_spin(tl, interval_ns);
+    } else {
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &tl->next, NULL) == EINTR)
+            ;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    late = timespec_diff_ns(&now, &tl->next);
+
+    // Single writer: plain load + store, no locked add per edge
+    atomic_store_explicit(&tl->edges,
+        atomic_load_explicit(&tl->edges, memory_order_relaxed) + 1, memory_order_relaxed);
+    atomic_store_explicit(&tl->sum_late_ns,
+        atomic_load_explicit(&tl->sum_late_ns, memory_order_relaxed) + late, memory_order_relaxed);
+    if (late > atomic_load_explicit(&tl->max_late_ns, memory_order_relaxed))
+        atomic_store_explicit(&tl->max_late_ns, late, memory_order_relaxed);
+
+    if (tl->hist != NULL)
+        latency_hist_record(tl->hist, late, late >= interval_ns);
+
+    if (late >= interval_ns) {
+        // Missed: re-anchor instead of bursting catch-up edges
+        atomic_store_explicit(&tl->missed,
+            atomic_load_explicit(&tl->missed, memory_order_relaxed) + 1, memory_order_relaxed);
+        tl->next = now;
+    }
+    return late;
+}
+
+// ========================================================
+void step_state_init(struct step_state *st, const struct pin_map *map) {
+// ========================================================
+    unsigned code;
+    int axis;
+
+    memset(st, 0, sizeof(*st));
+    st->map        = map;
+    st->fault_axis = -1;
+    for (axis = 0; axis < NUM_AXES; axis++) {
+        atomic_init(&st->raw[axis], 0);
+        atomic_init(&st->homed[axis], 0);
+        st->soft_min[axis] = INT64_MIN;
+        st->soft_max[axis] = INT64_MAX;
+    }
+    atomic_init(&st->fault, 0);
+
+    for (code = 0; code < PIN_MAP_CODES; code++) {
+        for (axis = 0; axis < NUM_AXES; axis++) {
+            if (!(code & AXIS_STEP_BIT(axis)))
+                continue;
+            if (code & AXIS_DIR_BIT(axis)) {
+                st->code_step[code][axis] = 1;
+            } else {
+                st->code_step[code][axis] = -1;
+                st->code_neg[code] |= 1u << axis;
+            }
+        }
+    }
+}
+
+// ========================================================
+int64_t step_position(struct step_state *st, int axis) {
+// ========================================================
+    return atomic_load_explicit(&st->raw[axis], memory_order_relaxed) - st->origin[axis];
+}
+
+// ========================================================
+static inline unsigned check_limits(struct parport_backend *be, struct step_state *st,
+                                    unsigned code) {
+// ========================================================
+    // Axes of code stepping into an active switch, timed
+    uint64_t t0 = monotonic_ns(), dt;
+    unsigned hit;
+
+    hit = st->map->home_lut[parport_read_status(be)] & st->code_neg[code];
+    dt  = monotonic_ns() - t0;
+    st->checks++;
+    st->check_ns_sum += dt;
+    if (dt > st->check_ns_max)
+        st->check_ns_max = dt;
+    return hit;
+}
+
+// ========================================================
+void step_state_trip(struct step_state *st, unsigned hit) {
+// ========================================================
+    int axis;
+
+    for (axis = 0; axis < NUM_AXES; axis++)
+        if (hit & (1u << axis))
+            break;
+    st->fault_axis = axis;
+    st->limit_trips++;
+    atomic_store_explicit(&st->fault, 1, memory_order_release);
+}
+
+// ========================================================
+int step_play_pulses(struct parport_backend *be, struct step_timeline *tl,
+                     const struct pulse_buffer *buf, struct step_state *st) {
+// ========================================================
+    uint32_t i, n = buf->count;
+    unsigned code, hit;
+
+    for (i = 0; i < n; i++) {
+        code = buf->code[i];
+        if (code & STEP_STEP_BITS) {
+            // Check before the step leaves the port
+            if ((hit = check_limits(be, st, code)) != 0) {
+                parport_write(be, pin_map_byte(st->map, code & ~STEP_STEP_BITS));
+                step_state_trip(st, hit);
+                return -1;
+            }
+            step_state_count(st, code);
+        }
+        parport_write(be, buf->byte[i]);
+        step_timeline_wait_ns(tl, buf->delta_ns[i]);
+    }
+    return 0;
+}
+
+// ========================================================
+static void fifo_flush_stage(struct parport_backend *be, struct fifo_stream *fs,
+                             struct step_state *st) {
+// ========================================================
+    // Push the staged bytes, waiting for room as the port
+    // drains the FIFO, then read the switches for the next
+    // stage.
+    const unsigned char *p = fs->stage;
+    size_t left = fs->stage_n, done;
+    struct timespec ts;
+    uint64_t wait_ns, t_end, t0, dt;
+
+    wait_ns = (uint64_t)(be->fifo_depth / 2 ? be->fifo_depth / 2 : 1) * be->fifo_byte_ns;
+    while (left > 0) {
+        if (fs->started && parport_fifo_empty(be) == 1)
+            fs->underruns++;
+        done = parport_fifo_write(be, p, left);
+        fs->started = 1;
+        fs->refills++;
+        fs->bytes += done;
+        p    += done;
+        left -= done;
+        if (left == 0)
+            break;
+
+        // Full: come back when half of it has gone out
+        if (wait_ns >= FIFO_SLEEP_MIN_NS) {
+            ts.tv_sec  = (time_t)(wait_ns / NSEC_PER_SEC);
+            ts.tv_nsec = (long)(wait_ns % NSEC_PER_SEC);
+            nanosleep(&ts, NULL);
+            fs->sleeps++;
+        } else {
+            t_end = monotonic_ns() + wait_ns;
+            while (monotonic_ns() < t_end)
+                ;
+            fs->spins++;
+        }
+    }
+    fs->stage_n = 0;
+
+    t0 = monotonic_ns();
+    fs->switches = st->map->home_lut[parport_read_status(be)];
+    dt = monotonic_ns() - t0;
+    st->checks++;
+    st->check_ns_sum += dt;
+    if (dt > st->check_ns_max)
+        st->check_ns_max = dt;
+}
+
+// ========================================================
+int step_play_pulses_fifo(struct parport_backend *be, struct fifo_stream *fs,
+                          const struct pulse_buffer *buf, struct step_state *st) {
+// ========================================================
+    uint32_t i, n = buf->count, chunk;
+    int64_t copies;
+    unsigned code, hit;
+
+    chunk = be->fifo_depth / 2;
+    if (chunk == 0)
+        chunk = 1;
+    if (chunk > FIFO_STAGE_BYTES)
+        chunk = FIFO_STAGE_BYTES;
+    if (buf->starts_move) {
+        fs->started  = 0;
+        fs->carry_ns = 0;
+        fs->switches = st->map->home_lut[parport_read_status(be)];
+    }
+
+    for (i = 0; i < n; i++) {
+        code = buf->code[i];
+        if (code & STEP_STEP_BITS) {
+            if ((hit = fs->switches & st->code_neg[code]) != 0) {
+                // Send what is staged (already counted, so the
+                // position stays true), then park the step lines
+                if (fs->stage_n > 0)
+                    fifo_flush_stage(be, fs, st);
+                fs->stage[0] = pin_map_byte(st->map, code & ~STEP_STEP_BITS);
+                fs->stage_n  = 1;
+                fifo_flush_stage(be, fs, st);
+                step_state_trip(st, hit);
+                return -1;
+            }
+            step_state_count(st, code);
+        }
+
+        fs->carry_ns += buf->delta_ns[i];
+        copies = fs->carry_ns / be->fifo_byte_ns;
+        if (copies < 1)
+            copies = 1;
+        fs->carry_ns -= copies * (int64_t)be->fifo_byte_ns;
+        while (copies-- > 0) {
+            fs->stage[fs->stage_n++] = buf->byte[i];
+            if (fs->stage_n >= chunk)
+                fifo_flush_stage(be, fs, st);
+        }
+    }
+    if (fs->stage_n > 0)
+        fifo_flush_stage(be, fs, st);
+    return 0;
+}
+
+// ========================================================
+static uint64_t step_seek(struct parport_backend *be, struct step_timeline *tl,
+                          struct step_state *st, int axis, int dir, uint32_t rate,
+                          int until_active, uint32_t max_steps) {
+// ========================================================
+    // Step axis in dir at a constant rate until its switch
+    // is active (until_active = 1) or released (0). Returns
+    // the steps taken, or max_steps + 1 if it gave up.
+    unsigned code = AXIS_STEP_BIT(axis) | (dir > 0 ? AXIS_DIR_BIT(axis) : 0);
+    unsigned char byte_hi = pin_map_byte(st->map, code);
+    unsigned char byte_lo = pin_map_byte(st->map, code & ~STEP_STEP_BITS);
+    uint32_t interval = 1000000000u / (rate ? rate : 1), steps;
+    int active;
+
+    step_timeline_start(tl);
+    parport_write(be, byte_lo);
+    step_timeline_wait(tl);
+
+    for (steps = 0; steps <= max_steps; steps++) {
+        active = (st->map->home_lut[parport_read_status(be)] >> axis) & 1;
+        if (active == until_active)
+            return steps;
+        step_state_count(st, code);
+        parport_write(be, byte_hi);
+        step_timeline_wait_ns(tl, interval / 2);
+        parport_write(be, byte_lo);
+        step_timeline_wait_ns(tl, interval - interval / 2);
+    }
+    return steps;
+}
+
+// ========================================================
+int step_home_axis(struct parport_backend *be, struct step_timeline *tl,
+                   struct step_state *st, int axis, const struct home_config *cfg) {
+// ========================================================
+    if (st->map->axis[axis].home_pin == 0)
+        return HOME_NO_SWITCH;
+    atomic_store_explicit(&st->homed[axis], 0, memory_order_relaxed);
+
+    // Fast approach onto the switch (minimum end)
+    if (step_seek(be, tl, st, axis, -1, cfg->fast_rate, 1, cfg->max_steps) > cfg->max_steps)
+        return HOME_NO_SWITCH;
+    // Slow back-off until it opens: that edge is position 0
+    if (step_seek(be, tl, st, axis, +1, cfg->slow_rate, 0, cfg->max_steps) > cfg->max_steps)
+        return HOME_NO_RELEASE;
+
+    st->origin[axis] = atomic_load_explicit(&st->raw[axis], memory_order_relaxed);
+    atomic_store_explicit(&st->homed[axis], 1, memory_order_release);
+    return HOME_OK;
+}
+
+// ========================================================
+void jog_control_reset(struct jog_control *jog, struct motion_queue *queue,
+                       struct step_state *state) {
+// ========================================================
+    // release_ns belongs to the UI, which clears it before
+    // it queues the jog
+    jog->queue           = queue;
+    jog->state           = state;
+    jog->preempted       = 0;
+    jog->stop_request_ns = 0;
+    jog->decel_start_ns  = 0;
+    jog->last_pulse_ns   = 0;
+    jog->steps           = 0;
+}
+
+// ========================================================
+int jog_stop_requested(struct jog_control *jog) {
+// ========================================================
+    // 1 while the jog should decelerate: for good once a command
+    // is queued, for as long as release_ns is set otherwise
+    const struct motion_cmd *next_cmd;
+    uint64_t release_ns;
+
+    if (jog->preempted)
+        return 1;
+    if ((next_cmd = motion_queue_peek(jog->queue)) != NULL) {
+        jog->preempted       = 1;
+        jog->stop_request_ns = next_cmd->t_enqueue_ns;
+        jog->decel_start_ns  = monotonic_ns();
+        return 1;
+    }
+    release_ns = atomic_load_explicit(&jog->release_ns, memory_order_acquire);
+    if (release_ns != jog->stop_request_ns) {
+        // Released, or held again (re-armed)
+        jog->stop_request_ns = release_ns;
+        jog->decel_start_ns  = release_ns != 0 ? monotonic_ns() : 0;
+    }
+    return release_ns != 0;
+}
+
+// ========================================================
+uint64_t step_soft_limit_left(struct step_state *st, const int dir[NUM_AXES]) {
+// ========================================================
+    // Steps left before the first moving axis reaches its
+    // soft limit (UINT64_MAX if none is set)
+    uint64_t left = UINT64_MAX, d;
+    int64_t pos;
+    int axis;
+
+    for (axis = 0; axis < NUM_AXES; axis++) {
+        pos = step_position(st, axis);
+        if (dir[axis] > 0 && st->soft_max[axis] != INT64_MAX)
+            d = pos >= st->soft_max[axis] ? 0 : (uint64_t)(st->soft_max[axis] - pos);
+        else if (dir[axis] < 0 && st->soft_min[axis] != INT64_MIN)
+            d = pos <= st->soft_min[axis] ? 0 : (uint64_t)(pos - st->soft_min[axis]);
+        else
+            continue;
+        if (d < left)
+            left = d;
+    }
+    return left;
+}
+
+// ========================================================
+uint64_t step_jog_continuous(struct parport_backend *be, struct step_timeline *tl,
+                             const int dir[NUM_AXES], const struct ramp_table *ramp,
+                             struct jog_control *jog) {
+// ========================================================
+    // Every moving axis (dir = -1 or +1) steps on every tick.
+    // Returns the number of step pulses emitted.
+    struct step_state *st = jog->state;
+    unsigned char dir_bits = 0, step_bits = 0, byte_hi, byte_lo;
+    uint32_t ramp_index = 0, interval;
+    uint64_t left;
+    unsigned code, hit;
+    int axis, decelerating, braking = 0;
+
+    for (axis = 0; axis < NUM_AXES; axis++) {
+        if (dir[axis] != 0)
+            step_bits |= AXIS_STEP_BIT(axis);
+        if (dir[axis] > 0)
+            dir_bits |= AXIS_DIR_BIT(axis);
+    }
+    if (step_bits == 0)
+        return 0;
+    code    = dir_bits | step_bits;
+    byte_hi = pin_map_byte(st->map, code);
+    byte_lo = pin_map_byte(st->map, dir_bits);
+
+    step_timeline_start(tl);
+    parport_write(be, byte_lo);
+    step_timeline_wait(tl);
+
+    for (;;) {
+        decelerating = jog_stop_requested(jog);
+
+        // Brake in time to stop on the nearest soft limit
+        left = step_soft_limit_left(st, dir);
+        if (left == 0)
+            break;
+        if (ramp != NULL && left <= (uint64_t)ramp_index + 1)
+            braking = 1;
+        decelerating |= braking;
+
+        if (ramp == NULL) {
+            if (decelerating)
+                break;
+            interval = 2 * tl->period_ns;
+        } else if (decelerating) {
+            // Walk back down the ramp we came up
+            if (ramp_index == 0)
+                break;
+            interval = ramp->interval_ns[--ramp_index];
+        } else if (ramp_index < ramp->n) {
+            interval = ramp->interval_ns[ramp_index++];
+        } else {
+            interval = ramp->cruise_ns;
+        }
+
+        if ((hit = check_limits(be, st, code)) != 0) {
+            step_state_trip(st, hit);
+            break;
+        }
+        step_state_count(st, code);
+        parport_write(be, byte_hi);
+        jog->last_pulse_ns = monotonic_ns();
+        step_timeline_wait_ns(tl, interval / 2);
+        parport_write(be, byte_lo);
+        step_timeline_wait_ns(tl, interval - interval / 2);
+        jog->steps++;
+    }
+    return jog->steps;
+}
@@ -0,0 +1,255 @@
+// File: step-engine.h
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// Step engine for the jogging code. Every port
+// edge is scheduled against an absolute
+// CLOCK_MONOTONIC timeline that advances by one
+// PERIOD per edge, using
+//   clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME)
+// Wake-up latency therefore never accumulates:
+// a late edge does not push the following edges
+// later, so the step frequency stays constant.
+//
+// An edge that fires a full PERIOD or more after
+// its deadline is counted as a missed deadline
+// and the timeline is re-anchored to "now" so we
+// never emit a burst of back-to-back catch-up edges.
+//
+// Two ways to wait for a deadline (tl->mode):
+//
+//   STEP_WAIT_SLEEP  : clock_nanosleep() right up to the
+//                      deadline; the edge is as late as
+//                      the kernel wakes us up
+//   STEP_WAIT_HYBRID : clock_nanosleep() up to margin_ns
+//                      before the deadline, then spin on
+//                      the TSC (or clock_gettime()) until
+//                      the deadline itself
+//
+// In the hybrid mode every wake-up is measured against
+// the time asked for, and margin_ns follows it: it jumps
+// up at once to the worst wake-up seen plus a guard, and
+// creeps back down by 1/64 of the excess per edge. An edge
+// sleeps for at least half its interval whatever the
+// margin, so the thread never spins a whole edge through
+// and leaves the CPU to the servo thread; an edge too
+// short (or already too late) to sleep at all decays the
+// margin towards HYBRID_MARGIN_MIN_NS, so it cannot stay
+// stuck above the interval.
+
+#ifndef STEP_ENGINE_H
+#define STEP_ENGINE_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "parport-backend.h"
+#include "motion-profile.h"
+#include "motion-queue.h"
+#include "pulse-compiler.h"
+#include "latency-hist.h"
+#include "tsc-clock.h"
+
+// ==================================================================
+// ABSOLUTE DEADLINE TIMELINE
+// ==================================================================
+enum step_wait_mode {
+    STEP_WAIT_SLEEP  = 0,
+    STEP_WAIT_HYBRID = 1
+};
+
+#define HYBRID_MARGIN_NS        50000       // Starting margin before the first wake-up is seen
+#define HYBRID_MARGIN_MIN_NS    2000
+#define HYBRID_MARGIN_MAX_NS    500000
+#define HYBRID_GUARD_NS         2000        // Added to the worst wake-up latency
+#define HYBRID_DECAY_SHIFT      6           // Margin decays by 1/64 of the excess per edge
+
+struct step_timeline {
+    struct timespec next;       // Absolute deadline of the next edge
+    long        period_ns;      // Time between two edges (half step period)
+    uint64_t    start_ns;       // When step_timeline_start() was last called
+
+    // Statistics since step_timeline_init(). Written only by
+    // the thread that waits; other threads read them with
+    // atomic_load_explicit(..., memory_order_relaxed).
+    atomic_uint_fast64_t edges;         // Edges waited for
+    atomic_uint_fast64_t missed;        // Edges fired a full interval or more late
+    atomic_int_fast64_t  max_late_ns;   // Worst lateness seen
+    atomic_int_fast64_t  sum_late_ns;   // For the mean lateness
+
+    struct latency_hist *hist;  // Every edge's lateness, if not NULL
+
+    // Sleep-then-spin waiting (STEP_WAIT_HYBRID)
+    int         mode;           // enum step_wait_mode
+    const struct tsc_clock *tsc;    // Spin clock, NULL = clock_gettime()
+    int64_t     margin_ns;      // Sleep ends this long before the edge
+    uint64_t    spin_ns;        // Time spent spinning
+    uint64_t    wakes;          // Sleeps that ended before the edge was due
+    int64_t     max_wake_ns;    // Worst wake-up latency after such a sleep
+    uint64_t    overshoots;     // Wake-ups after the edge was due (margin too short)
+};
+
+void    step_timeline_init(struct step_timeline *tl, long period_ns);
+void    step_timeline_start(struct step_timeline *tl);
+int64_t step_timeline_wait(struct step_timeline *tl);
+int64_t step_timeline_wait_ns(struct step_timeline *tl, long interval_ns);
+
+// ==================================================================
+// POSITION, LIMIT SWITCHES AND HOMING
+// ==================================================================
+// The stepping thread counts every step it writes into a
+// signed per-axis counter (raw[]). On every step edge it
+// also reads STATUS_REG and looks it up in the pin map's
+// home_lut[]: an axis stepping towards an active switch
+// (negative direction, switches sit at the minimum end)
+// stops the move, sets fault and ignores further motion
+// until a reset or homing. The read and check are timed
+// per tick (checks, check_ns_*).
+//
+// Homing an axis: fast approach at fast_rate until its
+// switch closes, then back off at slow_rate until it opens
+// again and latch that point as position 0. Both rates are
+// at or below the start rate, so the axis stops dead on
+// the switch without a ramp.
+//
+// Positions are raw[] - origin[]. Soft limits are kept in
+// those coordinates; the continuous jog brakes for them.
+#define STEP_STEP_BITS  (AXIS_STEP_BIT(AXIS_X) | AXIS_STEP_BIT(AXIS_Y) | AXIS_STEP_BIT(AXIS_Z) | AXIS_STEP_BIT(AXIS_A))
+
+struct step_state {
+    const struct pin_map *map;
+    _Atomic int64_t raw[NUM_AXES];      // Steps since start (stepping thread writes)
+    int64_t     origin[NUM_AXES];       // raw[] at the home latch
+    int64_t     soft_min[NUM_AXES];     // Soft limits (positions)
+    int64_t     soft_max[NUM_AXES];
+    atomic_int  fault;                  // Limit switch hit
+    atomic_int  homed[NUM_AXES];
+    int         fault_axis;
+
+    // Logical code -> per-axis step (-1, 0, +1) and axes stepping negative
+    int8_t      code_step[PIN_MAP_CODES][NUM_AXES];
+    unsigned char code_neg[PIN_MAP_CODES];
+
+    // Cost of the STATUS_REG read + limit check per tick
+    uint64_t    checks;
+    uint64_t    check_ns_sum;
+    uint64_t    check_ns_max;
+    uint64_t    limit_trips;
+};
+
+struct home_config {
+    uint32_t    fast_rate;      // steps/s towards the switch
+    uint32_t    slow_rate;      // steps/s backing off to the latch
+    uint32_t    max_steps;      // Give up after this many steps per phase
+};
+
+#define HOME_OK             0
+#define HOME_NO_SWITCH      -1  // Switch never closed
+#define HOME_NO_RELEASE     -2  // Switch never opened again
+
+void    step_state_init(struct step_state *st, const struct pin_map *map);
+int64_t step_position(struct step_state *st, int axis);
+int     step_home_axis(struct parport_backend *be, struct step_timeline *tl,
+                       struct step_state *st, int axis, const struct home_config *cfg);
+void    step_state_trip(struct step_state *st, unsigned hit);
+uint64_t step_soft_limit_left(struct step_state *st, const int dir[NUM_AXES]);
+
+// Count the steps of logical code into raw[]. Only the stepping
+// thread writes raw[], so a relaxed load + store is enough for
+// other threads to read it.
+static inline void step_state_count(struct step_state *st, unsigned code) {
+    int axis;
+
+    for (axis = 0; axis < NUM_AXES; axis++) {
+        if (st->code_step[code][axis] != 0)
+            atomic_store_explicit(&st->raw[axis],
+                atomic_load_explicit(&st->raw[axis], memory_order_relaxed) + st->code_step[code][axis],
+                memory_order_relaxed);
+    }
+}
+
+// ==================================================================
+// PULSE-TRAIN PLAYBACK
+// ==================================================================
+// Streams a compiled pulse buffer (see pulse-compiler.h):
+// write byte[i], wait delta_ns[i], next edge. Consecutive
+// buffers of one move continue on the same timeline.
+// Returns 0, or -1 if a limit switch stopped it.
+int     step_play_pulses(struct parport_backend *be, struct step_timeline *tl,
+                         const struct pulse_buffer *buf, struct step_state *st);
+
+// ==================================================================
+// FIFO (BURST) PLAYBACK
+// ==================================================================
+// Same buffers, played through the port FIFO (parport_fifo_start):
+// an edge of delta_ns becomes delta_ns / fifo_byte_ns copies of its
+// byte, and the rounding error is carried into the next edge, so
+// the train keeps its timing to within one byte overall. No edge is
+// shorter than one byte. The bytes are staged half a FIFO at a time
+// and the CPU only refills the FIFO, sleeping while it drains (or
+// spinning, when half a FIFO lasts less than FIFO_SLEEP_MIN_NS).
+//
+// Positions are counted as steps are queued. The switches are read
+// once per refill, so a limit trip stops the train at most one and
+// a half FIFOs of bytes later.
+#define FIFO_STAGE_BYTES    (PARPORT_FIFO_MAX_DEPTH / 2)
+#define FIFO_SLEEP_MIN_NS   60000       // Shorter waits spin on the clock
+
+struct fifo_stream {
+    int64_t     carry_ns;       // Time still owed to the edges already staged
+    int         started;        // FIFO fed since the move started
+    unsigned    switches;       // home_lut[] at the last refill
+    uint32_t    stage_n;
+
+    uint64_t    bytes;          // Bytes queued into the FIFO
+    uint64_t    refills;        // parport_fifo_write() calls
+    uint64_t    underruns;      // FIFO found empty in the middle of a move
+    uint64_t    sleeps;         // Waits for room done in nanosleep()
+    uint64_t    spins;          // ... and by spinning
+
+    unsigned char stage[FIFO_STAGE_BYTES];
+};
+
+int     step_play_pulses_fifo(struct parport_backend *be, struct fifo_stream *fs,
+                              const struct pulse_buffer *buf, struct step_state *st);
+
+// ==================================================================
+// CONTINUOUS (HOLD-TO-MOVE) JOG
+// ==================================================================
+// step_jog_continuous() accelerates along the ramp and
+// cruises until any command arrives on the motion queue
+// (normally MOTION_CMD_STOP, or a new jog). The queue is
+// peeked once per tick, so deceleration starts within one
+// step period; the jog then ramps back down along the same
+// table instead of finishing a fixed block of pulses. The
+// preempting command is left queued for the caller. The jog
+// also starts braking early enough to stop at a soft limit,
+// and stops dead on a limit switch.
+//
+// Letting go of the key is not a queued command: the UI
+// stores the time in release_ns and the jog decelerates
+// while it is set. A key repeat that arrives during the
+// deceleration clears it again, and the jog climbs back up
+// the ramp from where it was. A queued command cannot be
+// taken back.
+struct jog_control {
+    struct motion_queue *queue;     // Any queued command ends the jog
+    struct step_state *state;       // Position, limits and pin map
+    _Atomic uint64_t release_ns;    // UI: key let go at, 0 = held
+    int         preempted;          // A command is queued behind the jog
+    uint64_t    stop_request_ns;    // Enqueue time of that command, or release_ns
+    uint64_t    decel_start_ns;     // When the step loop saw stop
+    uint64_t    last_pulse_ns;      // Last step pulse of the jog
+    uint64_t    steps;              // Step pulses emitted
+};
+
+void    jog_control_reset(struct jog_control *jog, struct motion_queue *queue,
+                          struct step_state *state);
+int     jog_stop_requested(struct jog_control *jog);
+uint64_t step_jog_continuous(struct parport_backend *be, struct step_timeline *tl,
+                             const int dir[NUM_AXES], const struct ramp_table *ramp,
+                             struct jog_control *jog);
+
+#endif // STEP_ENGINE_H
@@ -0,0 +1,66 @@
+// File: tsc-clock.c
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// TSC spin clock calibration, see tsc-clock.h
+
+// ==============================================
+// INCLUDE FILE HEADERS
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include "cnc-time.h"
+#include "tsc-clock.h"
+
+// ========================================================
+static int tsc_is_invariant(void) {
+// ========================================================
+    // Both flags on the first "flags" line of /proc/cpuinfo
+    char line[4096];
+    FILE *fp = fopen("/proc/cpuinfo", "r");
+    int ok = 0;
+
+    if (fp == NULL)
+        return 0;
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        if (strncmp(line, "flags", 5) != 0)
+            continue;
+        ok = strstr(line, " constant_tsc") != NULL && strstr(line, " nonstop_tsc") != NULL;
+        break;
+    }
+    fclose(fp);
+    return ok;
+}
+
+// ========================================================
+int tsc_clock_calibrate(struct tsc_clock *tc, long calibrate_ns) {
+// ========================================================
+    // Returns 0, or -1 with errno = ENOTSUP if the TSC
+    // cannot serve as a clock on this CPU
+    struct timespec ts;
+    uint64_t t0, t1, c0, c1;
+
+    tc->ok           = 0;
+    tc->ticks_per_ns = 0.0;
+    if (!TSC_CLOCK_SUPPORTED || !tsc_is_invariant()) {
+        errno = ENOTSUP;
+        return -1;
+    }
+
+    ts.tv_sec  = calibrate_ns / NSEC_PER_SEC;
+    ts.tv_nsec = calibrate_ns % NSEC_PER_SEC;
+    t0 = monotonic_ns();
+    c0 = tsc_read();
+    nanosleep(&ts, NULL);
+    t1 = monotonic_ns();
+    c1 = tsc_read();
+    if (t1 <= t0 || c1 <= c0) {
+        errno = ENOTSUP;
+        return -1;
+    }
+    tc->ticks_per_ns = (double)(c1 - c0) / (double)(t1 - t0);
+    tc->ok           = 1;
+    return 0;
+}
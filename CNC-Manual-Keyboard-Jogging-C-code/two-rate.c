@@ -0,0 +1,259 @@
+// File: two-rate.c
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// Base/servo two-rate jog scheduler, see two-rate.h
+
+// ==============================================
+// INCLUDE FILE HEADERS
+#include <math.h>
+#include <string.h>
+
+#include "cnc-time.h"
+#include "two-rate.h"
+
+// ========================================================
+static void exec_stats_record(struct exec_stats *es, uint64_t ns) {
+// ========================================================
+    if (es->cycles == 0 || ns < es->min_ns)
+        es->min_ns = ns;
+    if (ns > es->max_ns)
+        es->max_ns = ns;
+    es->sum_ns += ns;
+    es->cycles++;
+}
+
+// ========================================================
+static void stepgen_dbuf_write(struct stepgen_dbuf *db, const struct stepgen_cmd *cmd) {
+// ========================================================
+    // Servo side: fill the idle slot, then make it current
+    unsigned seq = atomic_load_explicit(&db->seq, memory_order_relaxed) + 1;
+
+    db->slot[seq & 1] = *cmd;
+    atomic_store_explicit(&db->seq, seq, memory_order_release);
+}
+
+// ========================================================
+static void stepgen_dbuf_read(struct stepgen_dbuf *db, struct stepgen_cmd *cmd) {
+// ========================================================
+    // Base side: copy the current slot; if the servo
+    // published while we copied, the copy may be torn
+    unsigned seq;
+
+    for (;;) {
+        seq  = atomic_load_explicit(&db->seq, memory_order_acquire);
+        *cmd = db->slot[seq & 1];
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&db->seq, memory_order_relaxed) == seq)
+            return;
+        db->retries++;
+    }
+}
+
+// ========================================================
+static void setup_dbuf_write(struct two_rate_setup_dbuf *db, struct two_rate_setup *setup) {
+// ========================================================
+    // Base side: as stepgen_dbuf_write(); setup->gen becomes
+    // the new seq. Returns with setup->gen set.
+    unsigned seq = atomic_load_explicit(&db->seq, memory_order_relaxed) + 1;
+
+    setup->gen = seq;
+    db->slot[seq & 1] = *setup;
+    atomic_store_explicit(&db->seq, seq, memory_order_release);
+}
+
+// ========================================================
+static void setup_dbuf_read(struct two_rate_setup_dbuf *db, struct two_rate_setup *setup) {
+// ========================================================
+    // Servo side: as stepgen_dbuf_read()
+    unsigned seq;
+
+    for (;;) {
+        seq    = atomic_load_explicit(&db->seq, memory_order_acquire);
+        *setup = db->slot[seq & 1];
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&db->seq, memory_order_relaxed) == seq)
+            return;
+        db->retries++;
+    }
+}
+
+// ========================================================
+void two_rate_init(struct two_rate *tr, long base_period_ns, long servo_period_ns) {
+// ========================================================
+    memset(tr, 0, sizeof(*tr));
+    tr->base_period_ns  = base_period_ns;
+    tr->servo_period_ns = servo_period_ns;
+    tr->max_rate        = 1e9 / (2.0 * base_period_ns);
+    atomic_init(&tr->cmd.seq, 0);
+    atomic_init(&tr->setup.seq, 0);
+    atomic_init(&tr->jog_active, 0);
+    atomic_init(&tr->steps, 0);
+    step_timeline_init(&tr->servo_tl, servo_period_ns);
+}
+
+// ========================================================
+static void servo_cycle(struct two_rate *tr) {
+// ========================================================
+    // Next rate of the running jog, if there is one. Works
+    // on its own copy of the jog (servo_jog) only.
+    const struct axis_limits *lim = &tr->servo_jog.lim;
+    struct jog_control *jog;
+    struct stepgen_cmd cmd;
+    uint64_t steps, left;
+    double dt, brake;
+    uint32_t gen;
+
+    if (!atomic_load_explicit(&tr->jog_active, memory_order_acquire))
+        return;
+    if (atomic_load_explicit(&tr->setup.seq, memory_order_acquire) != tr->servo_gen) {
+        // New jog: take a copy, from rest straight to the start rate
+        setup_dbuf_read(&tr->setup, &tr->servo_jog);
+        tr->servo_gen = tr->servo_jog.gen;
+        tr->velocity  = lim->start_rate;
+        tr->stopping  = 0;
+    } else if (tr->velocity == 0.0) {
+        return;                         // Already told the base it is done
+    }
+    jog = tr->servo_jog.jog;
+    gen = tr->servo_gen;
+
+    tr->stopping = jog_stop_requested(jog);
+
+    // Steps first, then the positions: a step in between makes
+    // step_limit one smaller, never larger
+    steps = atomic_load_explicit(&tr->steps, memory_order_relaxed);
+    left  = step_soft_limit_left(jog->state, tr->servo_jog.dir);
+
+    dt = tr->servo_period_ns / 1e9;
+    if (left == 0 || atomic_load_explicit(&jog->state->fault, memory_order_acquire)) {
+        tr->velocity = 0.0;
+    } else {
+        if (tr->stopping)
+            tr->velocity -= lim->accel * dt;
+        else
+            tr->velocity += lim->accel * dt;
+        if (tr->velocity > lim->max_rate)
+            tr->velocity = lim->max_rate;
+        if (left != UINT64_MAX) {
+            // Slow enough to stop on the soft limit
+            brake = sqrt((double)lim->start_rate * lim->start_rate + 2.0 * lim->accel * left);
+            if (tr->velocity > brake)
+                tr->velocity = brake;
+        }
+        // Below the start rate the axis stops dead
+        if (tr->velocity < lim->start_rate)
+            tr->velocity = tr->stopping ? 0.0 : lim->start_rate;
+        if (tr->velocity > tr->max_rate)
+            tr->velocity = tr->max_rate;
+    }
+
+    cmd.inc        = (uint64_t)(tr->velocity * tr->base_period_ns / 1e9 * TWO_RATE_ONE);
+    cmd.step_limit = left == UINT64_MAX ? UINT64_MAX : steps + left;
+    cmd.gen        = gen;
+    cmd.done       = tr->velocity == 0.0;
+    stepgen_dbuf_write(&tr->cmd, &cmd);
+}
+
+// ========================================================
+static void *servo_thread_main(void *data) {
+// ========================================================
+    struct two_rate *tr = data;
+    uint64_t t0;
+
+    step_timeline_start(&tr->servo_tl);
+    for (;;) {
+        step_timeline_wait(&tr->servo_tl);
+        t0 = monotonic_ns();
+        servo_cycle(tr);
+        exec_stats_record(&tr->servo_stats, monotonic_ns() - t0);
+    }
+    return NULL;
+}
+
+// ========================================================
+int two_rate_start_servo(struct two_rate *tr, int priority, unsigned long cpumap) {
+// ========================================================
+    return rt_thread_start(&tr->servo_rt, priority, cpumap, servo_thread_main, tr);
+}
+
+// ========================================================
+uint64_t two_rate_jog(struct two_rate *tr, struct parport_backend *be, struct step_timeline *tl,
+                      const int dir[NUM_AXES], const struct axis_limits *lim,
+                      struct jog_control *jog) {
+// ========================================================
+    // Base side of a continuous jog, on the stepping thread.
+    // Returns the number of step pulses emitted.
+    struct step_state *st = jog->state;
+    struct two_rate_setup setup;
+    struct stepgen_cmd cmd;
+    unsigned dir_bits = 0, moving = 0, step_bits = 0, sw, hit;
+    unsigned char byte, last_byte;
+    uint64_t phase = 0, steps = 0, t0;
+    uint32_t gen;
+    int axis;
+
+    for (axis = 0; axis < NUM_AXES; axis++) {
+        setup.dir[axis] = dir[axis];
+        if (dir[axis] != 0)
+            moving |= AXIS_STEP_BIT(axis);
+        if (dir[axis] > 0)
+            dir_bits |= AXIS_DIR_BIT(axis);
+    }
+    if (moving == 0)
+        return 0;
+
+    // Hand the jog to the servo thread
+    setup.jog = jog;
+    setup.lim = *lim;
+    atomic_store_explicit(&tr->steps, 0, memory_order_relaxed);
+    setup_dbuf_write(&tr->setup, &setup);
+    gen = setup.gen;
+    atomic_store_explicit(&tr->jog_active, 1, memory_order_release);
+
+    step_timeline_start(tl);
+    last_byte = pin_map_byte(st->map, dir_bits);
+    parport_write(be, last_byte);
+
+    for (;;) {
+        step_timeline_wait_ns(tl, tr->base_period_ns);
+        t0 = monotonic_ns();
+        stepgen_dbuf_read(&tr->cmd, &cmd);
+        sw = st->map->home_lut[parport_read_status(be)];
+
+        if (cmd.gen == gen) {
+            if (cmd.done && step_bits == 0)
+                break;
+            phase += cmd.inc;           // Every period, high ones too
+        }
+        if (step_bits != 0) {
+            step_bits = 0;              // Pulse was high for one period
+        } else if (cmd.gen == gen && phase >= TWO_RATE_ONE) {
+            phase -= TWO_RATE_ONE;
+            if (steps < cmd.step_limit)
+                step_bits = moving;
+            if (step_bits != 0) {
+                if ((hit = sw & st->code_neg[dir_bits | step_bits]) != 0) {
+                    step_state_trip(st, hit);
+                    break;
+                }
+                step_state_count(st, dir_bits | step_bits);
+                atomic_store_explicit(&tr->steps, ++steps, memory_order_relaxed);
+            }
+        }
+
+        byte = pin_map_byte(st->map, dir_bits | step_bits);
+        if (byte != last_byte) {
+            parport_write(be, byte);
+            last_byte = byte;
+            if (step_bits != 0)
+                jog->last_pulse_ns = monotonic_ns();
+        }
+        exec_stats_record(&tr->base_stats, monotonic_ns() - t0);
+    }
+
+    atomic_store_explicit(&tr->jog_active, 0, memory_order_release);
+    jog->steps = steps;
+    return steps;
+}
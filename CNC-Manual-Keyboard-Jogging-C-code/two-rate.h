@@ -0,0 +1,138 @@
+// File: two-rate.h
+// Date: Sat 17 Oct 2026
+//
+// ==============================================
+// DESCRIPTION:
+// Two-rate (base/servo) scheduling of the continuous
+// jog, split the way LinuxCNC splits its threads:
+//
+//   base  : the stepping thread, once per base period
+//           (PERIOD by default). Samples STATUS_REG and
+//           turns the current rate into step/dir bits
+//           with a phase accumulator. No floating point,
+//           no queue, no ramp.
+//   servo : its own SCHED_FIFO thread, once per servo
+//           period (TICK_TIME). Watches the motion queue
+//           for the stop, runs the acceleration ramp and
+//           the soft limits, and publishes the next rate.
+//
+// The servo hands each new rate to the base through a
+// double buffer: it fills the slot the base is not
+// reading and then bumps seq; the base copies the slot
+// of the current seq and copies again if seq moved in
+// the meantime. Neither side ever waits for the other.
+// The base hands each new jog (directions, limits,
+// jog_control) to the servo the same way, the other way
+// round: its seq is the jog's generation, and the servo
+// works from its own copy, so a jog starting while the
+// servo is in the middle of a cycle cannot change what
+// that cycle reads.
+//
+// A step pulse is high for one base period and low for at
+// least one, so the base can step at most once every two
+// base periods. The phase accumulates every base period,
+// the high one included; a step that comes due while the
+// line is high goes out on the next low period, so the
+// rate is the commanded one, not v / (1 + v * base
+// period). The direction bits go out one base period
+// before the first step. A switch hit is still caught by
+// the base on the step itself (as in step-engine.h); the
+// servo sees the fault and ends the jog.
+//
+// While a two-rate jog runs the servo thread peeks the
+// motion queue on behalf of the stepping thread, which
+// does not touch the queue until the jog has ended.
+
+#ifndef TWO_RATE_H
+#define TWO_RATE_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "parport-backend.h"
+#include "motion-profile.h"
+#include "step-engine.h"
+#include "rt-thread.h"
+
+#define TWO_RATE_ONE    (1ULL << 32)    // One step of phase
+
+// ==================================================================
+// SERVO -> BASE HAND-OFF
+// ==================================================================
+struct stepgen_cmd {
+    uint64_t    inc;            // Phase added per base period (TWO_RATE_ONE = 1 step)
+    uint64_t    step_limit;     // Steps of the jog the base may emit in total
+    uint32_t    gen;            // Jog this command belongs to
+    int         done;           // Jog over once the step line is low
+};
+
+struct stepgen_dbuf {
+    struct stepgen_cmd slot[2];
+    atomic_uint seq;            // slot[seq & 1] is current
+    uint64_t    retries;        // Reads repeated because seq moved (base side)
+};
+
+// ==================================================================
+// BASE -> SERVO HAND-OFF
+// ==================================================================
+struct two_rate_setup {
+    struct jog_control *jog;
+    struct axis_limits lim;
+    int         dir[NUM_AXES];
+    uint32_t    gen;            // Jog generation (seq of the buffer)
+};
+
+struct two_rate_setup_dbuf {
+    struct two_rate_setup slot[2];
+    atomic_uint seq;            // slot[seq & 1] is current
+    uint64_t    retries;        // Reads repeated because seq moved (servo side)
+};
+
+// Execution time of one thread's cycles
+struct exec_stats {
+    uint64_t    cycles;
+    uint64_t    sum_ns;
+    uint64_t    min_ns;
+    uint64_t    max_ns;
+};
+
+struct two_rate {
+    long        base_period_ns;
+    long        servo_period_ns;
+    double      max_rate;               // steps/s the base period allows
+
+    struct stepgen_dbuf cmd;
+
+    // Current jog, published by the base before it raises jog_active
+    struct two_rate_setup_dbuf setup;
+    atomic_int  jog_active;
+    _Atomic uint64_t steps;             // Step pulses of the jog so far
+
+    // Servo thread state
+    struct two_rate_setup servo_jog;    // Servo's copy of the current jog
+    uint32_t    servo_gen;
+    double      velocity;               // steps/s
+    int         stopping;
+
+    struct exec_stats base_stats;
+    struct exec_stats servo_stats;
+
+    struct rt_thread servo_rt;
+    struct step_timeline servo_tl;
+};
+
+// ==================================================================
+// FUNCTION PROTOTYPES
+// ==================================================================
+void    two_rate_init(struct two_rate *tr, long base_period_ns, long servo_period_ns);
+int     two_rate_start_servo(struct two_rate *tr, int priority, unsigned long cpumap);
+uint64_t two_rate_jog(struct two_rate *tr, struct parport_backend *be, struct step_timeline *tl,
+                      const int dir[NUM_AXES], const struct axis_limits *lim,
+                      struct jog_control *jog);
+
+// Mean cycle time in nanoseconds
+static inline double exec_stats_mean(const struct exec_stats *es) {
+    return es->cycles ? (double)es->sum_ns / es->cycles : 0.0;
+}
+
+#endif // TWO_RATE_H